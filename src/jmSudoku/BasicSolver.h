@@ -13,11 +13,274 @@
 #include <cstdint>
 #include <cstddef>
 #include <vector>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>         // For __rdtsc()
+#else
+#include <x86intrin.h>      // For __rdtsc()
+#endif
 
 #include "Sudoku.h"
+#include "SudokuVerify.h"
 
 namespace jmSudoku {
 
+enum SearchStatus {
+    Solved,
+    NoSolution,
+    BudgetExceeded,
+    Stopped,
+    SearchStatusLast
+};
+
+//
+// The budget and the cancel flag of a search.
+//
+// A solver polls should_stop() through its SearchPoller in its recursion
+// (at every node, or only at the guesses), and unwinds once it returns true:
+//   - another solver (or thread) called stop(),
+//   - the guesses of the search are over max_guesses (0: no limit),
+//   - the polls of the search are over max_polls (0: no limit),
+//   - the TSC is past the deadline (0: no deadline). The TSC is read at
+//     every guess, but only once every kDeadlineInterval polls at the
+//     nodes, so the check stays cheap (see SearchPoller).
+//
+// The polls and the guesses are counted by the poller of every solver, the
+// budget is per search, whatever the statistics policy of the solver is.
+// A control may be shared by the solvers that search one puzzle together,
+// they only read it at the polls, and write it once when they stop. After
+// the search, status() tells why it returned no answer, the counters of the
+// solver keep the partial statistics.
+//
+class SearchControl {
+public:
+    static const size_t kDeadlineInterval = 64;
+
+private:
+    std::atomic<bool>   stopped_;
+    std::atomic<bool>   exceeded_;
+    size_t              max_guesses_;
+    size_t              max_polls_;
+    uint64_t            deadline_;
+
+public:
+    SearchControl(size_t max_guesses = 0, uint64_t deadline = 0)
+        : stopped_(false), exceeded_(false),
+          max_guesses_(max_guesses), max_polls_(0), deadline_(deadline) {}
+    ~SearchControl() {}
+
+    static uint64_t read_tsc() {
+        return (uint64_t)__rdtsc();
+    }
+
+    size_t max_guesses() const { return this->max_guesses_; }
+    void set_max_guesses(size_t max_guesses) { this->max_guesses_ = max_guesses; }
+
+    size_t max_polls() const { return this->max_polls_; }
+    void set_max_polls(size_t max_polls) { this->max_polls_ = max_polls; }
+
+    uint64_t deadline() const { return this->deadline_; }
+    void set_deadline(uint64_t deadline) { this->deadline_ = deadline; }
+
+    // The deadline is the given TSC ticks from now, 0: no deadline.
+    void set_timeout(uint64_t ticks) {
+        this->deadline_ = (ticks != 0) ? (read_tsc() + ticks) : 0;
+    }
+
+    // Clears the stop, keeps the budget.
+    void reset() {
+        this->stopped_.store(false, std::memory_order_relaxed);
+        this->exceeded_.store(false, std::memory_order_relaxed);
+    }
+
+    void stop() {
+        this->stopped_.store(true, std::memory_order_relaxed);
+    }
+
+    bool is_stopped() const {
+        return this->stopped_.load(std::memory_order_relaxed);
+    }
+
+    bool is_budget_exceeded() const {
+        return this->exceeded_.load(std::memory_order_relaxed);
+    }
+
+    // The polls and the guesses of the search that polls, and if the TSC is
+    // read at this poll.
+    bool should_stop(size_t polls, size_t guesses, bool check_deadline) {
+        if (this->stopped_.load(std::memory_order_relaxed))
+            return true;
+        if ((this->max_guesses_ != 0 && guesses > this->max_guesses_) ||
+            (this->max_polls_ != 0 && polls > this->max_polls_) ||
+            (this->deadline_ != 0 && check_deadline && read_tsc() > this->deadline_)) {
+            this->exceeded_.store(true, std::memory_order_relaxed);
+            this->stopped_.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // The status of a search that ran with this control.
+    SearchStatus status(bool success) const {
+        if (success)
+            return SearchStatus::Solved;
+        else if (this->is_budget_exceeded())
+            return SearchStatus::BudgetExceeded;
+        else if (this->is_stopped())
+            return SearchStatus::Stopped;
+        else
+            return SearchStatus::NoSolution;
+    }
+
+    static const char * status_name(size_t status) {
+        static const char * names[SearchStatusLast] = {
+            "solved", "no solution", "budget exceeded", "stopped"
+        };
+        return (status < SearchStatusLast) ? names[status] : "unknown";
+    }
+};
+
+//
+// The SearchControl of a solver and the counters of its search: the polls
+// and the guesses are kept in the solver, not in the shared control, and
+// are counted with every statistics policy. reset() at the start of every
+// search.
+//
+class SearchPoller {
+private:
+    SearchControl * control_;
+    size_t          polls_;
+    size_t          guesses_;
+
+public:
+    SearchPoller() : control_(nullptr), polls_(0), guesses_(0) {}
+    ~SearchPoller() {}
+
+    SearchControl * control() const { return this->control_; }
+    void set_control(SearchControl * control) { this->control_ = control; }
+
+    size_t polls() const { return this->polls_; }
+    size_t guesses() const { return this->guesses_; }
+
+    void reset() {
+        this->polls_ = 0;
+        this->guesses_ = 0;
+    }
+
+    void count_guess() {
+        this->guesses_++;
+    }
+
+    // The poll at a node, the deadline is checked at the first poll of the
+    // search, then once every kDeadlineInterval polls.
+    bool should_stop() {
+        if (this->control_ == nullptr)
+            return false;
+        this->polls_++;
+        return this->control_->should_stop(this->polls_, this->guesses_,
+            (this->polls_ % SearchControl::kDeadlineInterval) == 1);
+    }
+
+    // The poll of the solvers that only poll at the guesses. A guess costs
+    // far more than a read of the TSC, the deadline is checked every time,
+    // however few guesses the search makes.
+    bool should_stop_at_guess() {
+        if (this->control_ == nullptr)
+            return false;
+        this->guesses_++;
+        this->polls_++;
+        return this->control_->should_stop(this->polls_, this->guesses_, true);
+    }
+};
+
+//
+// The answer visitors of the enumeration: a visitor is called as
+// bool visitor(const Board & answer) for every answer when it is found,
+// and stops the search by returning false.
+//
+
+// Keeps the answers in a vector, for search() and the answers().
+template <size_t nSearchMode, typename BoardTy>
+struct AnswerCollector {
+    std::vector<BoardTy> & answers;
+
+    AnswerCollector(std::vector<BoardTy> & _answers) : answers(_answers) {}
+
+    bool operator () (const BoardTy & answer) {
+        this->answers.push_back(answer);
+        return (nSearchMode != SearchMode::MoreThanOneAnswer || this->answers.size() <= 1);
+    }
+};
+
+// Counts the answers that were given to the visitor.
+template <typename VisitorTy, typename BoardTy>
+struct CountingVisitor {
+    VisitorTy & visitor;
+    size_t      count;
+
+    CountingVisitor(VisitorTy & _visitor) : visitor(_visitor), count(0) {}
+
+    bool operator () (const BoardTy & answer) {
+        this->count++;
+        return this->visitor(answer);
+    }
+};
+
+//
+// The statistics policies of the solvers:
+//   NoStats:        nothing is counted, the search has no counter traffic at
+//                   all (the budget of a SearchControl is counted by the
+//                   SearchPoller of the solver),
+//   BasicStats:     the guesses, the unique candidates and the failed returns,
+//   DetailedStats:  and their histograms by the depth of the search, and the
+//                   mems of the exact cover engines (see count_mems()).
+//
+struct NoStats {
+    static const bool kEnabled = false;
+    static const bool kDetailed = false;
+};
+
+struct BasicStats {
+    static const bool kEnabled = true;
+    static const bool kDetailed = false;
+};
+
+struct DetailedStats {
+    static const bool kEnabled = true;
+    static const bool kDetailed = true;
+};
+
+template <typename StatsTy>
+inline void count_stats(size_t & counter) {
+    if (StatsTy::kEnabled) {
+        counter++;
+    }
+}
+
+template <typename StatsTy, size_t N>
+inline void count_stats(size_t & counter, size_t (&histogram)[N], size_t depth) {
+    if (StatsTy::kEnabled) {
+        counter++;
+        if (StatsTy::kDetailed) {
+            histogram[(depth < N) ? depth : (N - 1)]++;
+        }
+    }
+}
+
+//
+// The memory traffic of the exact cover engines in Knuth's mems: one mem is
+// one read or one write of a word of the cover structure, in the cover and
+// the uncover only. Counted with DetailedStats only, it costs a store per
+// update.
+//
+template <typename StatsTy>
+inline void count_mems(size_t & counter, size_t mems) {
+    if (StatsTy::kDetailed) {
+        counter += mems;
+    }
+}
+
 template <typename SudokuTy>
 class BasicSolver {
 public:
@@ -43,9 +306,20 @@ public:
     static const size_t TotalSize = sudoku_t::TotalSize;
     static const size_t Neighbors = sudoku_t::Neighbors;
 
-    static size_t num_guesses;
-    static size_t num_unique_candidate;
-    static size_t num_failed_return;
+    // Per thread, so the solvers can run on several threads.
+    static thread_local size_t num_guesses;
+    static thread_local size_t num_unique_candidate;
+    static thread_local size_t num_failed_return;
+
+    // The BoardCheck of the last input given to check_input().
+    static thread_local size_t last_check;
+
+    // The histograms of DetailedStats, [depth], until reset_depth_statistics().
+    static const size_t kMaxDepth = BoardSize + 1;
+
+    static thread_local size_t guess_depths[kMaxDepth];
+    static thread_local size_t unique_depths[kMaxDepth];
+    static thread_local size_t failed_depths[kMaxDepth];
 
 protected:
     size_t              empties_;
@@ -60,6 +334,19 @@ public:
     static size_t get_num_guesses() { return this_type::num_guesses; }
     static size_t get_num_unique_candidate() { return this_type::num_unique_candidate; }
     static size_t get_num_failed_return() { return this_type::num_failed_return; }
+    static size_t get_last_check() { return this_type::last_check; }
+
+    static const size_t * get_guess_depths() { return this_type::guess_depths; }
+    static const size_t * get_unique_depths() { return this_type::unique_depths; }
+    static const size_t * get_failed_depths() { return this_type::failed_depths; }
+
+    static void reset_depth_statistics() {
+        for (size_t depth = 0; depth < kMaxDepth; depth++) {
+            this_type::guess_depths[depth] = 0;
+            this_type::unique_depths[depth] = 0;
+            this_type::failed_depths[depth] = 0;
+        }
+    }
 
     static size_t get_total_search_counter() {
         return (this_type::num_guesses + this_type::num_unique_candidate + this_type::num_failed_return);
@@ -85,6 +372,19 @@ private:
     }
 
 public:
+    //
+    // The entry of every solve(), rejects an inconsistent board before the
+    // search. The counters are cleared, there is no search to count.
+    //
+    bool check_input(const Board & board) {
+        this_type::last_check = (size_t)check_board(board);
+        if (this_type::last_check != BoardCheck::BoardValid) {
+            init_statistics();
+            return false;
+        }
+        return true;
+    }
+
     size_t calc_empties(Board & board) {
         size_t empties = 0;
         for (size_t pos = 0; pos < BoardSize; pos++) {
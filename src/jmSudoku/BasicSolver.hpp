@@ -2,10 +2,22 @@
 #include "BasicSolver.h"
 
 template <typename SudokuTy>
-size_t jmSudoku::BasicSolver<SudokuTy>::num_guesses = 0;
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::num_guesses = 0;
 
 template <typename SudokuTy>
-size_t jmSudoku::BasicSolver<SudokuTy>::num_unique_candidate = 0;
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::num_unique_candidate = 0;
 
 template <typename SudokuTy>
-size_t jmSudoku::BasicSolver<SudokuTy>::num_failed_return = 0;
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::num_failed_return = 0;
+
+template <typename SudokuTy>
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::last_check = 0;
+
+template <typename SudokuTy>
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::guess_depths[jmSudoku::BasicSolver<SudokuTy>::kMaxDepth] = { 0 };
+
+template <typename SudokuTy>
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::unique_depths[jmSudoku::BasicSolver<SudokuTy>::kMaxDepth] = { 0 };
+
+template <typename SudokuTy>
+thread_local size_t jmSudoku::BasicSolver<SudokuTy>::failed_depths[jmSudoku::BasicSolver<SudokuTy>::kMaxDepth] = { 0 };
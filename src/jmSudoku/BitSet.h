@@ -732,6 +732,79 @@ SmallBitSet<Bits> operator ^ (const SmallBitSet<Bits> & left,
     return (answer ^= right);
 }
 
+//
+// A plain bitset over size_t words, the bitboards of the exact cover and
+// the variant engines. The bits over Bits are kept zero.
+//
+template <size_t Bits>
+struct WordBitSet {
+    typedef WordBitSet<Bits> this_type;
+
+    static const size_t kWordBits = sizeof(size_t) * 8;
+    static const size_t kWords = (Bits + kWordBits - 1) / kWordBits;
+    static const size_t kRestBits = Bits % kWordBits;
+
+    size_t words[kWords];
+
+    void reset() {
+        for (size_t i = 0; i < kWords; i++) {
+            this->words[i] = 0;
+        }
+    }
+
+    void fill() {
+        for (size_t i = 0; i < kWords; i++) {
+            this->words[i] = size_t(-1);
+        }
+        if (kRestBits != 0) {
+            this->words[kWords - 1] = (size_t(1) << kRestBits) - 1;
+        }
+    }
+
+    bool test(size_t pos) const {
+        return ((this->words[pos / kWordBits] >> (pos % kWordBits)) & 1) != 0;
+    }
+
+    void set(size_t pos) {
+        this->words[pos / kWordBits] |= size_t(1) << (pos % kWordBits);
+    }
+
+    void reset(size_t pos) {
+        this->words[pos / kWordBits] &= ~(size_t(1) << (pos % kWordBits));
+    }
+
+    bool any() const {
+        size_t bits = 0;
+        for (size_t i = 0; i < kWords; i++) {
+            bits |= this->words[i];
+        }
+        return (bits != 0);
+    }
+
+    size_t count() const {
+        size_t count = 0;
+        for (size_t i = 0; i < kWords; i++) {
+            count += BitUtils::popcnt(this->words[i]);
+        }
+        return count;
+    }
+
+    // The first set bit, Bits if there is none.
+    size_t bsf() const {
+        for (size_t i = 0; i < kWords; i++) {
+            if (this->words[i] != 0)
+                return (i * kWordBits + BitUtils::bsf(this->words[i]));
+        }
+        return Bits;
+    }
+
+    void and_not(const this_type & other) {
+        for (size_t i = 0; i < kWords; i++) {
+            this->words[i] &= ~other.words[i];
+        }
+    }
+};
+
 } // namespace jmSudoku
 
 #endif // JSTD_BITSET_H
@@ -371,6 +371,149 @@ struct BitUtils {
         return BitUtils::popcnt64(x);
 #else
         return BitUtils::popcnt32(x);
+#endif
+    }
+
+    //
+    // pext() / pdep(): parallel bits extract / deposit (BMI2).
+    //
+    // pext() gathers the bits of x selected by mask to the low bits,
+    // pdep() scatters the low bits of x to the bits selected by mask.
+    // Without BMI2, the bits of the mask are walked one by one.
+    //
+    // Note: on AMD before Zen 3, pext and pdep are microcoded and slow.
+    //
+    static inline
+    uint32_t __internal_pext32(uint32_t x, uint32_t mask) {
+        uint32_t result = 0;
+        for (uint32_t bit = 1; mask != 0; bit <<= 1) {
+            uint32_t low_bit = mask & (0U - mask);
+            if ((x & low_bit) != 0)
+                result |= bit;
+            mask ^= low_bit;
+        }
+        return result;
+    }
+
+    static inline
+    uint64_t __internal_pext64(uint64_t x, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+            uint64_t low_bit = mask & (0ULL - mask);
+            if ((x & low_bit) != 0)
+                result |= bit;
+            mask ^= low_bit;
+        }
+        return result;
+    }
+
+    static inline
+    uint32_t __internal_pdep32(uint32_t x, uint32_t mask) {
+        uint32_t result = 0;
+        for (uint32_t bit = 1; mask != 0; bit <<= 1) {
+            uint32_t low_bit = mask & (0U - mask);
+            if ((x & bit) != 0)
+                result |= low_bit;
+            mask ^= low_bit;
+        }
+        return result;
+    }
+
+    static inline
+    uint64_t __internal_pdep64(uint64_t x, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+            uint64_t low_bit = mask & (0ULL - mask);
+            if ((x & bit) != 0)
+                result |= low_bit;
+            mask ^= low_bit;
+        }
+        return result;
+    }
+
+    static inline uint32_t pext32(uint32_t x, uint32_t mask) {
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+        return (uint32_t)_pext_u32(x, mask);
+#else
+        return BitUtils::__internal_pext32(x, mask);
+#endif
+    }
+
+    static inline uint64_t pext64(uint64_t x, uint64_t mask) {
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && (JSTD_WORD_SIZE == 64)
+        return (uint64_t)_pext_u64(x, mask);
+#else
+        return BitUtils::__internal_pext64(x, mask);
+#endif
+    }
+
+    static inline uint32_t pdep32(uint32_t x, uint32_t mask) {
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+        return (uint32_t)_pdep_u32(x, mask);
+#else
+        return BitUtils::__internal_pdep32(x, mask);
+#endif
+    }
+
+    static inline uint64_t pdep64(uint64_t x, uint64_t mask) {
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && (JSTD_WORD_SIZE == 64)
+        return (uint64_t)_pdep_u64(x, mask);
+#else
+        return BitUtils::__internal_pdep64(x, mask);
+#endif
+    }
+
+    //
+    // The bit of the 16 words: bit i of the result is (src[i] >> bit) & 1.
+    //
+    // SSE2: shift the bit to the sign of the words, pack the words to bytes
+    // with signed saturation (the sign is kept), then movemask.
+    //
+    static inline uint32_t bit_column16(const uint16_t * src, size_t bit) {
+        assert(bit < 16);
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+        __m128i shift = _mm_cvtsi32_si128(int(15 - bit));
+        __m128i low  = _mm_loadu_si128((const __m128i *)src);
+        __m128i high = _mm_loadu_si128((const __m128i *)(src + 8));
+        low  = _mm_sll_epi16(low, shift);
+        high = _mm_sll_epi16(high, shift);
+        return (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(low, high));
+#else
+        uint32_t result = 0;
+        for (size_t i = 0; i < 16; i++) {
+            result |= (uint32_t)((src[i] >> bit) & 1U) << i;
+        }
+        return result;
+#endif
+    }
+
+    //
+    // Transposes a 16 x 16 bit matrix: bit col of src[row] goes to bit row
+    // of dest[col]. src and dest must not overlap.
+    //
+    // SSE2: the low and the high bytes of the 16 rows are packed to two
+    // vectors, then every movemask reads the same column of the 16 rows,
+    // and an add shifts the next column to the sign of the bytes.
+    //
+    static inline void transpose16x16(const uint16_t * src, uint16_t * dest) {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+        __m128i rows_0_7  = _mm_loadu_si128((const __m128i *)src);
+        __m128i rows_8_15 = _mm_loadu_si128((const __m128i *)(src + 8));
+        __m128i low_mask  = _mm_set1_epi16(0x00FF);
+        __m128i low_bytes  = _mm_packus_epi16(_mm_and_si128(rows_0_7, low_mask),
+                                              _mm_and_si128(rows_8_15, low_mask));
+        __m128i high_bytes = _mm_packus_epi16(_mm_srli_epi16(rows_0_7, 8),
+                                              _mm_srli_epi16(rows_8_15, 8));
+        for (size_t i = 0; i < 8; i++) {
+            dest[7 - i]  = (uint16_t)_mm_movemask_epi8(low_bytes);
+            dest[15 - i] = (uint16_t)_mm_movemask_epi8(high_bytes);
+            low_bytes  = _mm_add_epi8(low_bytes, low_bytes);
+            high_bytes = _mm_add_epi8(high_bytes, high_bytes);
+        }
+#else
+        for (size_t col = 0; col < 16; col++) {
+            dest[col] = (uint16_t)BitUtils::bit_column16(src, col);
+        }
 #endif
     }
 };
@@ -236,6 +236,13 @@ struct BitVec16x08 {
         this->xmm128 = _mm_set1_epi16(value);      // SSE2
     }
 
+    // Word i is 0xFFFF if the bit i of bits is set, else 0.
+    void fill_bits16(uint8_t bits) {
+        __m128i lane_bits = _mm_setr_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+        __m128i value = _mm_and_si128(_mm_set1_epi16((short)bits), lane_bits);
+        this->xmm128 = _mm_cmpeq_epi16(value, lane_bits);   // SSE2
+    }
+
     void fill_u32(uint32_t value) {
         this->xmm128 = _mm_set1_epi32(value);      // SSE2
     }
@@ -694,6 +701,12 @@ struct BitVec16x16 {
         this->high.fill_u16(value);
     }
 
+    // Word i is 0xFFFF if the bit i of bits is set, else 0.
+    void fill_bits16(uint16_t bits) {
+        this->low.fill_bits16((uint8_t)(bits & 0xFFU));
+        this->high.fill_bits16((uint8_t)(bits >> 8U));
+    }
+
     void fill_u32(uint32_t value) {
         this->low.fill_u32(value);
         this->high.fill_u32(value);
@@ -1209,6 +1222,15 @@ struct BitVec16x16 {
         this->ymm256 = _mm256_set1_epi16(value);
     }
 
+    // Word i is 0xFFFF if the bit i of bits is set, else 0.
+    void fill_bits16(uint16_t bits) {
+        __m256i lane_bits = _mm256_setr_epi16(0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080,
+                                              0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000,
+                                              (short)0x8000);
+        __m256i value = _mm256_and_si256(_mm256_set1_epi16((short)bits), lane_bits);
+        this->ymm256 = _mm256_cmpeq_epi16(value, lane_bits);
+    }
+
     void fill_u32(uint32_t value) {
         this->ymm256 = _mm256_set1_epi32(value);
     }
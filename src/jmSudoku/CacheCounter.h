@@ -0,0 +1,120 @@
+
+#ifndef JSTD_TEST_CACHE_COUNTER_H
+#define JSTD_TEST_CACHE_COUNTER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif // __linux__
+
+//
+// The L1 data cache reads and read misses of the calling thread, by the
+// hardware counters of perf_event_open() (Linux only). is_available() is
+// false when there are no counters: other systems, most of the virtual
+// machines, or a perf_event_paranoid that forbids them.
+//
+namespace jtest {
+
+class CacheCounter {
+private:
+    int         read_fd_;
+    int         miss_fd_;
+    uint64_t    reads_;
+    uint64_t    misses_;
+
+public:
+    CacheCounter() : read_fd_(-1), miss_fd_(-1), reads_(0), misses_(0) {
+#if defined(__linux__)
+        this->read_fd_ = open_counter(PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+        this->miss_fd_ = open_counter(PERF_COUNT_HW_CACHE_RESULT_MISS);
+        if (this->read_fd_ < 0 || this->miss_fd_ < 0)
+            this->close();
+#endif
+    }
+
+    ~CacheCounter() {
+        this->close();
+    }
+
+    bool is_available() const {
+        return (this->read_fd_ >= 0 && this->miss_fd_ >= 0);
+    }
+
+    uint64_t reads() const { return this->reads_; }
+    uint64_t misses() const { return this->misses_; }
+
+    double miss_rate() const {
+        return (this->reads_ != 0) ? ((double)this->misses_ / this->reads_) : 0.0;
+    }
+
+    void start() {
+        this->reads_ = 0;
+        this->misses_ = 0;
+#if defined(__linux__)
+        if (this->is_available()) {
+            ::ioctl(this->read_fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(this->miss_fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(this->read_fd_, PERF_EVENT_IOC_ENABLE, 0);
+            ::ioctl(this->miss_fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#if defined(__linux__)
+        if (this->is_available()) {
+            ::ioctl(this->read_fd_, PERF_EVENT_IOC_DISABLE, 0);
+            ::ioctl(this->miss_fd_, PERF_EVENT_IOC_DISABLE, 0);
+            this->reads_ = read_counter(this->read_fd_);
+            this->misses_ = read_counter(this->miss_fd_);
+        }
+#endif
+    }
+
+private:
+    void close() {
+#if defined(__linux__)
+        if (this->read_fd_ >= 0)
+            ::close(this->read_fd_);
+        if (this->miss_fd_ >= 0)
+            ::close(this->miss_fd_);
+#endif
+        this->read_fd_ = -1;
+        this->miss_fd_ = -1;
+    }
+
+#if defined(__linux__)
+    static int open_counter(uint64_t result) {
+        struct perf_event_attr attr;
+        ::memset((void *)&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return (int)::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    static uint64_t read_counter(int fd) {
+        uint64_t value = 0;
+        if (::read(fd, (void *)&value, sizeof(value)) != (ssize_t)sizeof(value))
+            return 0;
+        return value;
+    }
+#endif // __linux__
+};
+
+} // namespace jtest
+
+#endif // JSTD_TEST_CACHE_COUNTER_H
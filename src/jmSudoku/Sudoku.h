@@ -37,7 +37,7 @@ enum SearchMode {
     SearchModeLast
 };
 
-double calc_percent(size_t num_val, size_t num_total) {
+inline double calc_percent(size_t num_val, size_t num_total) {
     if (num_total != 0)
         return (num_val * 100.0) / num_total;
     else
@@ -0,0 +1,373 @@
+
+#ifndef JM_SUDOKU_BATCH_H
+#define JM_SUDOKU_BATCH_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "Sudoku.h"
+#include "BasicSolver.h"
+#include "SudokuVerify.h"
+#include "StopWatch.h"
+
+//
+// Batch runner for puzzles of very different difficulty.
+//
+// Schedule::Static: every thread solves one contiguous slice of the batch.
+//
+// Schedule::WorkStealing: every worker owns a deque of puzzle indices,
+// stored as a range [head, tail) of the batch. The owner takes chunks from
+// the head, the size of a chunk is a fraction of what is left in its deque,
+// so the chunks get small near the end. An idle worker steals the back half
+// of another worker's deque. A worker stops when no puzzle is left to take,
+// not when it finds the deques empty: a stolen range is in no deque while
+// the thief moves it.
+//
+// The worker threads and their solvers live as long as the runner, the
+// calling thread is the worker 0. A run_tasks() only wakes the workers up
+// and waits for them, so it is cheap enough to call for every puzzle.
+//
+// The answers are stored by the index of the puzzle, so the output order
+// doesn't depend on the schedule. The solvers reject the inconsistent
+// puzzles before the search, run() keeps the BoardCheck of every puzzle.
+//
+namespace jmSudoku {
+
+template <typename SudokuSolver>
+class BatchRunner {
+public:
+    typedef SudokuSolver                            solver_type;
+    typedef typename SudokuSolver::sudoku_t         sudoku_t;
+    typedef typename SudokuSolver::Board            Board;
+    typedef BasicSolver<sudoku_t>                   basic_solver_t;
+
+    static const size_t kChunkDivisor = 8;
+    static const size_t kMaxChunkSize = 64;
+
+    enum Schedule {
+        Static,
+        WorkStealing,
+        ScheduleLast
+    };
+
+    struct ThreadStats {
+        size_t  puzzles;        // The tasks of run_tasks()
+        size_t  chunks;
+        size_t  steals;
+        double  busy_time;      // ms
+        double  idle_time;      // ms, until the last thread finished
+
+        void reset() {
+            this->puzzles = 0;
+            this->chunks = 0;
+            this->steals = 0;
+            this->busy_time = 0.0;
+            this->idle_time = 0.0;
+        }
+    };
+
+private:
+    static const size_t kDequeSize = 128;
+
+    //
+    // std::allocator doesn't align the over-aligned types before C++17, so
+    // the deques are padded instead of alignas(64): the members of two deques
+    // never share a cache line.
+    //
+    struct WorkDeque {
+        std::mutex  mutex;
+        size_t      head;
+        size_t      tail;
+        char        padding[kDequeSize - sizeof(std::mutex) - sizeof(size_t) * 2];
+    };
+
+    // The task of run_tasks(), called by the workers through a plain function.
+    typedef void (*TaskThunk)(void * task, solver_type & solver, size_t index);
+
+    template <typename TaskFunc>
+    static void call_task(void * task, solver_type & solver, size_t index) {
+        (*static_cast<TaskFunc *>(task))(solver, index);
+    }
+
+    size_t                      threads_;
+    std::vector<WorkDeque>      deques_;
+    std::vector<ThreadStats>    thread_stats_;
+    std::vector<uint8_t>        checks_;
+    std::atomic<size_t>         untaken_;       // The tasks that no worker has taken yet
+    double                      elapsed_time_;
+
+    solver_type                 solver_;        // The solver of the worker 0
+    std::vector<std::thread>    workers_;       // The workers 1 to threads - 1
+    std::mutex                  pool_mutex_;
+    std::condition_variable     task_cond_;
+    std::condition_variable     done_cond_;
+    size_t                      generation_;    // One more for every run_tasks()
+    size_t                      running_;       // The workers still in this run
+    bool                        quit_;
+    TaskThunk                   task_thunk_;
+    void *                      task_;
+    Schedule                    schedule_;
+
+public:
+    BatchRunner(size_t threads = 0)
+        : threads_(threads), untaken_(0), elapsed_time_(0.0),
+          generation_(0), running_(0), quit_(false),
+          task_thunk_(nullptr), task_(nullptr), schedule_(Schedule::WorkStealing) {
+        if (this->threads_ == 0) {
+            this->threads_ = std::thread::hardware_concurrency();
+            if (this->threads_ == 0)
+                this->threads_ = 1;
+        }
+
+        std::vector<WorkDeque> deques(this->threads_);
+        this->deques_.swap(deques);
+        this->thread_stats_.resize(this->threads_);
+
+        // solver_ has initialized the shared mask tables, start the workers.
+        this->workers_.reserve(this->threads_ - 1);
+        for (size_t i = 1; i < this->threads_; i++) {
+            this->workers_.emplace_back(&BatchRunner::worker_loop, this, i);
+        }
+    }
+
+    ~BatchRunner() {
+        {
+            std::lock_guard<std::mutex> lock(this->pool_mutex_);
+            this->quit_ = true;
+        }
+        this->task_cond_.notify_all();
+        for (size_t i = 0; i < this->workers_.size(); i++) {
+            this->workers_[i].join();
+        }
+    }
+
+    size_t threads() const { return this->threads_; }
+    double elapsed_time() const { return this->elapsed_time_; }
+
+    const std::vector<ThreadStats> & thread_stats() const {
+        return this->thread_stats_;
+    }
+
+    // The BoardCheck of every puzzle of the last run().
+    const std::vector<uint8_t> & checks() const {
+        return this->checks_;
+    }
+
+    // The number of the puzzles of the last run() with the given BoardCheck.
+    size_t check_count(size_t check) const {
+        size_t count = 0;
+        for (size_t i = 0; i < this->checks_.size(); i++) {
+            count += (this->checks_[i] == check) ? 1 : 0;
+        }
+        return count;
+    }
+
+    static const char * schedule_name(size_t schedule) {
+        static const char * names[ScheduleLast] = { "static", "work-stealing" };
+        return (schedule < ScheduleLast) ? names[schedule] : "unknown";
+    }
+
+    //
+    // Solves all the puzzles, answers[i] and solved[i] belong to puzzles[i].
+    // Returns the number of the solved puzzles.
+    //
+    size_t run(const std::vector<Board> & puzzles, std::vector<Board> & answers,
+               std::vector<uint8_t> & solved, Schedule schedule = Schedule::WorkStealing) {
+        size_t count = puzzles.size();
+        answers = puzzles;
+        solved.assign(count, 0);
+        this->checks_.assign(count, (uint8_t)BoardCheck::BoardValid);
+
+        std::vector<uint8_t> & checks = this->checks_;
+        this->run_tasks(count, [&answers, &solved, &checks](solver_type & solver, size_t index) {
+            bool success = solver.solve(answers[index]);
+            solved[index] = success ? 1 : 0;
+            if (!success)
+                checks[index] = (uint8_t)basic_solver_t::get_last_check();
+        }, schedule);
+
+        size_t total_solved = 0;
+        for (size_t i = 0; i < count; i++) {
+            total_solved += solved[i];
+        }
+        return total_solved;
+    }
+
+    //
+    // Runs task(solver, index) for every index in [0, count), every worker
+    // has its own solver. Used by run() and by the parallel search.
+    //
+    template <typename TaskFunc>
+    void run_tasks(size_t count, TaskFunc task, Schedule schedule = Schedule::WorkStealing) {
+        for (size_t i = 0; i < this->threads_; i++) {
+            this->deques_[i].head = count * i / this->threads_;
+            this->deques_[i].tail = count * (i + 1) / this->threads_;
+            this->thread_stats_[i].reset();
+        }
+        this->untaken_.store(count, std::memory_order_relaxed);
+        this->task_thunk_ = &call_task<TaskFunc>;
+        this->task_ = (void *)&task;
+        this->schedule_ = schedule;
+
+        jtest::StopWatch sw;
+        sw.start();
+        if (this->threads_ > 1) {
+            {
+                std::lock_guard<std::mutex> lock(this->pool_mutex_);
+                this->running_ = this->threads_ - 1;
+                this->generation_++;
+            }
+            this->task_cond_.notify_all();
+        }
+
+        this->run_worker(0, this->solver_);
+
+        if (this->threads_ > 1) {
+            std::unique_lock<std::mutex> lock(this->pool_mutex_);
+            this->done_cond_.wait(lock, [this]() { return (this->running_ == 0); });
+        }
+        sw.stop();
+        this->elapsed_time_ = sw.getElapsedMillisec();
+
+        for (size_t i = 0; i < this->threads_; i++) {
+            ThreadStats & stats = this->thread_stats_[i];
+            stats.idle_time = this->elapsed_time_ - stats.busy_time;
+            if (stats.idle_time < 0.0)
+                stats.idle_time = 0.0;
+        }
+    }
+
+private:
+    void worker_loop(size_t thread_id) {
+        solver_type solver;
+        size_t generation = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(this->pool_mutex_);
+                this->task_cond_.wait(lock, [this, generation]() {
+                    return (this->quit_ || this->generation_ != generation);
+                });
+                if (this->quit_)
+                    break;
+                generation = this->generation_;
+            }
+
+            this->run_worker(thread_id, solver);
+
+            bool is_last;
+            {
+                std::lock_guard<std::mutex> lock(this->pool_mutex_);
+                is_last = (--this->running_ == 0);
+            }
+            if (is_last)
+                this->done_cond_.notify_one();
+        }
+    }
+
+    void run_worker(size_t thread_id, solver_type & solver) {
+        if (this->schedule_ == Schedule::Static)
+            this->static_worker(thread_id, solver);
+        else
+            this->stealing_worker(thread_id, solver);
+    }
+
+    void run_range(solver_type & solver, size_t first, size_t last, ThreadStats & stats) {
+        jtest::StopWatch sw;
+        sw.start();
+        for (size_t i = first; i < last; i++) {
+            this->task_thunk_(this->task_, solver, i);
+        }
+        sw.stop();
+        stats.busy_time += sw.getElapsedMillisec();
+        stats.puzzles += last - first;
+        stats.chunks++;
+    }
+
+    void static_worker(size_t thread_id, solver_type & solver) {
+        WorkDeque & deque = this->deques_[thread_id];
+        this->run_range(solver, deque.head, deque.tail, this->thread_stats_[thread_id]);
+    }
+
+    // Takes a chunk from the head of the own deque.
+    bool pop_chunk(size_t thread_id, size_t & first, size_t & last) {
+        WorkDeque & deque = this->deques_[thread_id];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        size_t remain = deque.tail - deque.head;
+        if (remain == 0)
+            return false;
+        size_t chunk_size = remain / kChunkDivisor;
+        if (chunk_size < 1)
+            chunk_size = 1;
+        else if (chunk_size > kMaxChunkSize)
+            chunk_size = kMaxChunkSize;
+        first = deque.head;
+        last = first + chunk_size;
+        deque.head = last;
+        this->untaken_.fetch_sub(chunk_size, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Moves the back half of a victim's deque into the own deque.
+    bool steal(size_t thread_id) {
+        for (size_t n = 1; n < this->threads_; n++) {
+            size_t victim_id = (thread_id + n) % this->threads_;
+            WorkDeque & victim = this->deques_[victim_id];
+            size_t first, last;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                size_t remain = victim.tail - victim.head;
+                if (remain == 0)
+                    continue;
+                first = victim.head + remain / 2;
+                last = victim.tail;
+                victim.tail = first;
+            }
+
+            WorkDeque & deque = this->deques_[thread_id];
+            std::lock_guard<std::mutex> lock(deque.mutex);
+            assert(deque.head == deque.tail);
+            deque.head = first;
+            deque.tail = last;
+            return true;
+        }
+        return false;
+    }
+
+    void stealing_worker(size_t thread_id, solver_type & solver) {
+        ThreadStats & stats = this->thread_stats_[thread_id];
+        for (;;) {
+            size_t first, last;
+            if (this->pop_chunk(thread_id, first, last)) {
+                this->run_range(solver, first, last, stats);
+            }
+            else if (this->steal(thread_id)) {
+                stats.steals++;
+            }
+            else if (this->untaken_.load(std::memory_order_relaxed) == 0) {
+                // Every puzzle is taken, the work only shrinks.
+                break;
+            }
+            else {
+                // Another worker is moving a stolen range into its deque.
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_BATCH_H
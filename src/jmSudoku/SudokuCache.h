@@ -0,0 +1,169 @@
+
+#ifndef JM_SUDOKU_CACHE_H
+#define JM_SUDOKU_CACHE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memcmp()
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "Sudoku.h"
+#include "SudokuCanonical.h"
+
+//
+// A concurrent cache from the canonical form of a puzzle to the canonical form
+// of its solution. The table is split into shards, each one guarded by its own
+// mutex, so that lookups of different puzzles rarely contend.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+struct BoardHash {
+    typedef typename SudokuTy::board_type Board;
+
+    size_t operator () (const Board & board) const {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < SudokuTy::BoardSize; i++) {
+            hash ^= (uint8_t)board.cells[i];
+            hash *= 1099511628211ULL;
+        }
+        return (size_t)hash;
+    }
+};
+
+template <typename SudokuTy>
+struct BoardEqual {
+    typedef typename SudokuTy::board_type Board;
+
+    bool operator () (const Board & lhs, const Board & rhs) const {
+        return (std::memcmp(lhs.cells, rhs.cells, SudokuTy::BoardSize) == 0);
+    }
+};
+
+template <typename SudokuTy>
+class SolutionCache {
+public:
+    typedef SudokuTy                        sudoku_t;
+    typedef typename SudokuTy::board_type   Board;
+    typedef Transform<SudokuTy>             transform_t;
+    typedef Canonicalizer<SudokuTy>         canonicalizer_t;
+
+    static const size_t kShards = 64;
+
+private:
+    typedef std::unordered_map<Board, Board, BoardHash<SudokuTy>, BoardEqual<SudokuTy>> map_type;
+
+    struct Shard {
+        std::mutex  mutex;
+        map_type    map;
+    };
+
+    Shard               shards_[kShards];
+    size_t              shard_capacity_;
+
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+
+    static size_t shard_index(size_t hash) {
+        return ((hash >> 32) ^ hash) % kShards;
+    }
+
+public:
+    // capacity = 0 means unlimited
+    SolutionCache(size_t capacity = 0) : hits_(0), misses_(0) {
+        this->shard_capacity_ = (capacity != 0) ? ((capacity + kShards - 1) / kShards) : size_t(-1);
+    }
+    ~SolutionCache() {}
+
+    size_t hits() const { return this->hits_.load(std::memory_order_relaxed); }
+    size_t misses() const { return this->misses_.load(std::memory_order_relaxed); }
+
+    double hit_rate() const {
+        return calc_percent(this->hits(), this->hits() + this->misses());
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (size_t i = 0; i < kShards; i++) {
+            std::lock_guard<std::mutex> lock(this->shards_[i].mutex);
+            total += this->shards_[i].map.size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < kShards; i++) {
+            std::lock_guard<std::mutex> lock(this->shards_[i].mutex);
+            this->shards_[i].map.clear();
+        }
+        this->hits_ = 0;
+        this->misses_ = 0;
+    }
+
+    bool find(const Board & key, Board & answer) {
+        Shard & shard = this->shards_[shard_index(BoardHash<SudokuTy>()(key))];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            typename map_type::const_iterator iter = shard.map.find(key);
+            if (iter != shard.map.end()) {
+                answer = iter->second;
+                this->hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        this->misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool insert(const Board & key, const Board & answer) {
+        Shard & shard = this->shards_[shard_index(BoardHash<SudokuTy>()(key))];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.map.size() >= this->shard_capacity_)
+            return false;
+        shard.map.insert(std::make_pair(key, answer));
+        return true;
+    }
+
+    //
+    // Solve the board in place through the cache: the puzzle is canonicalized,
+    // a hit is mapped back with the inverse transform, a miss is solved by the
+    // solver and its answer is stored in canonical form.
+    //
+    template <typename SudokuSolver>
+    bool solve(SudokuSolver & solver, canonicalizer_t & canonicalizer,
+               Board & board, bool & is_hit) {
+        Board key, answer;
+        transform_t transform;
+        canonicalizer.canonicalize(board, key, transform);
+
+        if (this->find(key, answer)) {
+            transform.apply_inverse(answer, board);
+            is_hit = true;
+            return true;
+        }
+
+        is_hit = false;
+        bool success = solver.solve(board);
+        if (success) {
+            transform.apply(board, answer);
+            this->insert(key, answer);
+        }
+        return success;
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_CACHE_H
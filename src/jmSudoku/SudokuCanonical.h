@@ -0,0 +1,440 @@
+
+#ifndef JM_SUDOKU_CANONICAL_H
+#define JM_SUDOKU_CANONICAL_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset(), std::memcpy()
+#include <vector>
+#include <algorithm>    // For std::sort(), std::swap()
+
+#include "Sudoku.h"
+
+//
+// Canonical form of a 9x9 sudoku under its symmetry group:
+//
+//   digit relabeling, row permutations within a band, column permutations
+//   within a stack, band swaps, stack swaps and transposition.
+//
+// The canonical form is the lexicographically smallest board (row-major,
+// digits relabeled in order of first appearance, empty cells sort after the
+// digits) over all geometric transforms. It is found by a row-by-row
+// branch-and-bound that only keeps the partial transforms tied on the
+// smallest prefix. Sorting the givens first makes the densest row lead,
+// which has far fewer tied column permutations than a sparse one.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+struct Transform {
+    typedef SudokuTy                        sudoku_t;
+    typedef typename SudokuTy::board_type   Board;
+
+    static const size_t Rows = SudokuTy::Rows;
+    static const size_t Cols = SudokuTy::Cols;
+    static const size_t Numbers = SudokuTy::Numbers;
+
+    uint8_t transpose;
+    uint8_t rows[Rows];             // rows[dest_row] = source row (after transpose)
+    uint8_t cols[Cols];             // cols[dest_col] = source col (after transpose)
+    uint8_t nums[Numbers + 1];      // nums[source num] = dest num, nums[0] = 0 is the empty cell
+
+    void identity() {
+        this->transpose = 0;
+        for (size_t i = 0; i < Rows; i++) {
+            this->rows[i] = (uint8_t)i;
+        }
+        for (size_t i = 0; i < Cols; i++) {
+            this->cols[i] = (uint8_t)i;
+        }
+        for (size_t i = 0; i <= Numbers; i++) {
+            this->nums[i] = (uint8_t)i;
+        }
+    }
+
+    size_t source_pos(size_t row, size_t col) const {
+        if (this->transpose == 0)
+            return (this->rows[row] * Cols + this->cols[col]);
+        else
+            return (this->cols[col] * Cols + this->rows[row]);
+    }
+
+    // dest = T(src)
+    void apply(const Board & src, Board & dest) const {
+        size_t pos = 0;
+        for (size_t row = 0; row < Rows; row++) {
+            for (size_t col = 0; col < Cols; col++) {
+                char val = src.cells[source_pos(row, col)];
+                if (val != '.')
+                    dest.cells[pos] = (char)(this->nums[val - '0'] + '0');
+                else
+                    dest.cells[pos] = '.';
+                pos++;
+            }
+        }
+    }
+
+    // src = T^-1(dest)
+    void apply_inverse(const Board & dest, Board & src) const {
+        uint8_t inv_nums[Numbers + 1];
+        for (size_t num = 0; num <= Numbers; num++) {
+            inv_nums[this->nums[num]] = (uint8_t)num;
+        }
+
+        size_t pos = 0;
+        for (size_t row = 0; row < Rows; row++) {
+            for (size_t col = 0; col < Cols; col++) {
+                char val = dest.cells[pos];
+                if (val != '.')
+                    src.cells[source_pos(row, col)] = (char)(inv_nums[val - '0'] + '0');
+                else
+                    src.cells[source_pos(row, col)] = '.';
+                pos++;
+            }
+        }
+    }
+
+    // A uniformly random member of the symmetry group, RandomGen is a
+    // std::mt19937 like generator.
+    template <typename RandomGen>
+    void random(RandomGen & rng) {
+        static const size_t BoxCellsX = SudokuTy::BoxCellsX;
+        static const size_t BoxCellsY = SudokuTy::BoxCellsY;
+        static const size_t BoxCountX = SudokuTy::BoxCountX;
+        static const size_t BoxCountY = SudokuTy::BoxCountY;
+
+        uint8_t bands[BoxCountY], stacks[BoxCountX];
+        uint8_t digits[Numbers];
+
+        this->transpose = (uint8_t)(rng() & 1);
+
+        shuffle_n(bands, BoxCountY, rng);
+        for (size_t band = 0; band < BoxCountY; band++) {
+            uint8_t inner[BoxCellsY];
+            shuffle_n(inner, BoxCellsY, rng);
+            for (size_t i = 0; i < BoxCellsY; i++) {
+                this->rows[band * BoxCellsY + i] = (uint8_t)(bands[band] * BoxCellsY + inner[i]);
+            }
+        }
+
+        shuffle_n(stacks, BoxCountX, rng);
+        for (size_t stack = 0; stack < BoxCountX; stack++) {
+            uint8_t inner[BoxCellsX];
+            shuffle_n(inner, BoxCellsX, rng);
+            for (size_t i = 0; i < BoxCellsX; i++) {
+                this->cols[stack * BoxCellsX + i] = (uint8_t)(stacks[stack] * BoxCellsX + inner[i]);
+            }
+        }
+
+        shuffle_n(digits, Numbers, rng);
+        this->nums[0] = 0;
+        for (size_t num = 0; num < Numbers; num++) {
+            this->nums[num + 1] = (uint8_t)(digits[num] + 1);
+        }
+    }
+
+private:
+    template <typename RandomGen>
+    static void shuffle_n(uint8_t * list, size_t n, RandomGen & rng) {
+        for (size_t i = 0; i < n; i++) {
+            list[i] = (uint8_t)i;
+        }
+        for (size_t i = n - 1; i > 0; i--) {
+            size_t j = (size_t)(rng() % (i + 1));
+            std::swap(list[i], list[j]);
+        }
+    }
+};
+
+template <typename SudokuTy>
+class Canonicalizer {
+public:
+    typedef SudokuTy                        sudoku_t;
+    typedef typename SudokuTy::board_type   Board;
+    typedef Transform<SudokuTy>             transform_t;
+
+    static const size_t BoxCellsX = SudokuTy::BoxCellsX;      // 3
+    static const size_t BoxCellsY = SudokuTy::BoxCellsY;      // 3
+    static const size_t BoxCountX = SudokuTy::BoxCountX;      // 3
+    static const size_t BoxCountY = SudokuTy::BoxCountY;      // 3
+
+    static const size_t Rows = SudokuTy::Rows;
+    static const size_t Cols = SudokuTy::Cols;
+    static const size_t Numbers = SudokuTy::Numbers;
+    static const size_t BoardSize = SudokuTy::BoardSize;
+
+    // 3! stack orders * (3!)^3 column orders inside the stacks
+    static const size_t kColPerms = 6 * 6 * 6 * 6;
+
+    // Upper bound of the live partial transforms, only reached by nearly
+    // empty or highly symmetric puzzles. Truncating keeps the result a valid
+    // transform of the input, the form just stops being canonical.
+    static const size_t kMaxStates = 65536;
+
+    static const uint64_t kEmptyLabel = 0x0F;
+
+    static_assert((BoxCellsX == 3 && BoxCellsY == 3 && BoxCountX == 3 && BoxCountY == 3),
+                  "Canonicalizer only supports the 9x9 sudoku.");
+
+private:
+#pragma pack(push, 1)
+
+    struct PartialState {
+        uint16_t col_perm;
+        uint8_t  transpose;
+        uint8_t  used_bands;
+        uint8_t  used_rows;         // The used rows of current band
+        uint8_t  next_label;
+        uint8_t  rows[Rows];
+        uint8_t  labels[Numbers + 1];
+    };
+
+#pragma pack(pop)
+
+    struct ColPermTable {
+        uint8_t cols[kColPerms][Cols];
+
+        // The column permutations that move the givens of a row pattern to the
+        // left most: best_perms[best_first[mask], best_first[mask + 1])
+        uint32_t best_first[(1U << Cols) + 1];
+        uint32_t best_mask[1U << Cols];
+        std::vector<uint16_t> best_perms;
+
+        ColPermTable() {
+            static const uint8_t perms3[6][3] = {
+                { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 },
+                { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+            };
+            size_t index = 0;
+            for (size_t s = 0; s < 6; s++) {
+                for (size_t p0 = 0; p0 < 6; p0++) {
+                    for (size_t p1 = 0; p1 < 6; p1++) {
+                        for (size_t p2 = 0; p2 < 6; p2++) {
+                            const size_t inner[3] = { p0, p1, p2 };
+                            for (size_t stack = 0; stack < 3; stack++) {
+                                size_t src_stack = perms3[s][stack];
+                                for (size_t i = 0; i < 3; i++) {
+                                    this->cols[index][stack * 3 + i] =
+                                        (uint8_t)(src_stack * 3 + perms3[inner[stack]][i]);
+                                }
+                            }
+                            index++;
+                        }
+                    }
+                }
+            }
+            assert(index == kColPerms);
+
+            for (uint32_t mask = 0; mask < (1U << Cols); mask++) {
+                uint32_t max_mask = 0;
+                for (size_t cp = 0; cp < kColPerms; cp++) {
+                    uint32_t perm_mask = permute_mask(mask, this->cols[cp]);
+                    if (perm_mask > max_mask)
+                        max_mask = perm_mask;
+                }
+                this->best_mask[mask] = max_mask;
+                this->best_first[mask] = (uint32_t)this->best_perms.size();
+                for (size_t cp = 0; cp < kColPerms; cp++) {
+                    if (permute_mask(mask, this->cols[cp]) == max_mask) {
+                        this->best_perms.push_back((uint16_t)cp);
+                    }
+                }
+            }
+            this->best_first[1U << Cols] = (uint32_t)this->best_perms.size();
+        }
+
+        static uint32_t permute_mask(uint32_t mask, const uint8_t * cols) {
+            uint32_t perm_mask = 0;
+            for (size_t col = 0; col < Cols; col++) {
+                perm_mask = (perm_mask << 1) | ((mask >> (Cols - 1 - cols[col])) & 1U);
+            }
+            return perm_mask;
+        }
+    };
+
+    static const ColPermTable & col_perm_table() {
+        // Thread-safe since C++11
+        static const ColPermTable s_table;
+        return s_table;
+    }
+
+    uint8_t grids_[2][BoardSize];
+    std::vector<PartialState> states_;
+    std::vector<PartialState> next_states_;
+
+public:
+    Canonicalizer() {
+        this->states_.reserve(4096);
+        this->next_states_.reserve(4096);
+    }
+    ~Canonicalizer() {}
+
+    // Returns the number of partial transforms visited, out = T(in).
+    size_t canonicalize(const Board & in, Board & out, transform_t & transform) {
+        const ColPermTable & table = col_perm_table();
+
+        for (size_t row = 0; row < Rows; row++) {
+            for (size_t col = 0; col < Cols; col++) {
+                char val = in.cells[row * Cols + col];
+                uint8_t num = (val >= '1' && val <= '9') ? (uint8_t)(val - '0') : 0;
+                this->grids_[0][row * Cols + col] = num;
+                this->grids_[1][col * Rows + row] = num;
+            }
+        }
+
+        size_t visited = 0;
+        this->states_.clear();
+
+        // Row 0: the smallest row has the most givens pushed to the left,
+        // its value only depends on the given pattern.
+        uint32_t best_mask = 0;
+        uint32_t row_masks[2][Rows];
+        for (size_t t = 0; t < 2; t++) {
+            for (size_t row = 0; row < Rows; row++) {
+                const uint8_t * grid_row = &this->grids_[t][row * Cols];
+                uint32_t mask = 0;
+                for (size_t col = 0; col < Cols; col++) {
+                    mask = (mask << 1) | ((grid_row[col] != 0) ? 1U : 0U);
+                }
+                row_masks[t][row] = mask;
+                if (table.best_mask[mask] > best_mask)
+                    best_mask = table.best_mask[mask];
+            }
+        }
+
+        for (size_t t = 0; t < 2; t++) {
+            for (size_t row = 0; row < Rows; row++) {
+                uint32_t mask = row_masks[t][row];
+                if (table.best_mask[mask] != best_mask)
+                    continue;
+                const uint8_t * grid_row = &this->grids_[t][row * Cols];
+                for (uint32_t i = table.best_first[mask]; i < table.best_first[mask + 1]; i++) {
+                    if (this->states_.size() >= kMaxStates)
+                        break;
+                    size_t cp = table.best_perms[i];
+                    const uint8_t * cols = table.cols[cp];
+                    PartialState state;
+                    std::memset(&state, 0, sizeof(state));
+                    state.col_perm = (uint16_t)cp;
+                    state.transpose = (uint8_t)t;
+                    state.used_bands = (uint8_t)(1U << (row / BoxCellsY));
+                    state.used_rows = (uint8_t)(1U << (row % BoxCellsY));
+                    state.next_label = 1;
+                    state.rows[0] = (uint8_t)row;
+                    for (size_t col = 0; col < Cols; col++) {
+                        uint8_t num = grid_row[cols[col]];
+                        if (num != 0 && state.labels[num] == 0) {
+                            state.labels[num] = state.next_label++;
+                        }
+                    }
+                    this->states_.push_back(state);
+                    visited++;
+                }
+            }
+        }
+
+        // Row 1 ~ 8
+        for (size_t level = 1; level < Rows; level++) {
+            uint64_t best_value = uint64_t(-1);
+            this->next_states_.clear();
+            for (size_t i = 0; i < this->states_.size(); i++) {
+                const PartialState & state = this->states_[i];
+                const uint8_t * grid = this->grids_[state.transpose];
+                const uint8_t * cols = table.cols[state.col_perm];
+
+                size_t first_row, last_row;
+                if ((level % BoxCellsY) == 0) {
+                    first_row = 0;
+                    last_row = Rows;
+                }
+                else {
+                    size_t band = state.rows[level - 1] / BoxCellsY;
+                    first_row = band * BoxCellsY;
+                    last_row = first_row + BoxCellsY;
+                }
+
+                for (size_t row = first_row; row < last_row; row++) {
+                    size_t band = row / BoxCellsY;
+                    if ((level % BoxCellsY) == 0) {
+                        if ((state.used_bands & (1U << band)) != 0)
+                            continue;
+                    }
+                    else {
+                        if ((state.used_rows & (1U << (row % BoxCellsY))) != 0)
+                            continue;
+                    }
+
+                    uint8_t labels[Numbers + 1];
+                    std::memcpy(labels, state.labels, sizeof(labels));
+                    uint8_t next_label = state.next_label;
+
+                    const uint8_t * grid_row = &grid[row * Cols];
+                    uint64_t value = 0;
+                    for (size_t col = 0; col < Cols; col++) {
+                        uint8_t num = grid_row[cols[col]];
+                        if (num != 0 && labels[num] == 0) {
+                            labels[num] = next_label++;
+                        }
+                        value = (value << 4) | ((num != 0) ? labels[num] : kEmptyLabel);
+                    }
+                    visited++;
+
+                    if (value > best_value)
+                        continue;
+                    if (value < best_value) {
+                        best_value = value;
+                        this->next_states_.clear();
+                    }
+                    if (this->next_states_.size() >= kMaxStates)
+                        continue;
+
+                    PartialState next_state = state;
+                    if ((level % BoxCellsY) == 0) {
+                        next_state.used_bands |= (uint8_t)(1U << band);
+                        next_state.used_rows = 0;
+                    }
+                    next_state.used_rows |= (uint8_t)(1U << (row % BoxCellsY));
+                    next_state.next_label = next_label;
+                    next_state.rows[level] = (uint8_t)row;
+                    std::memcpy(next_state.labels, labels, sizeof(labels));
+                    this->next_states_.push_back(next_state);
+                }
+            }
+            std::swap(this->states_, this->next_states_);
+        }
+
+        assert(this->states_.size() > 0);
+        const PartialState & best = this->states_[0];
+
+        transform.transpose = best.transpose;
+        std::memcpy(transform.rows, best.rows, sizeof(transform.rows));
+        std::memcpy(transform.cols, table.cols[best.col_perm], sizeof(transform.cols));
+
+        // The digits absent from the puzzle take the remaining labels in order.
+        uint8_t next_label = best.next_label;
+        transform.nums[0] = 0;
+        for (size_t num = 1; num <= Numbers; num++) {
+            if (best.labels[num] != 0)
+                transform.nums[num] = best.labels[num];
+            else
+                transform.nums[num] = next_label++;
+        }
+        assert(next_label == Numbers + 1);
+
+        transform.apply(in, out);
+        return visited;
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_CANONICAL_H
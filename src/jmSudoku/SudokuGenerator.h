@@ -0,0 +1,479 @@
+
+#ifndef JM_SUDOKU_GENERATOR_H
+#define JM_SUDOKU_GENERATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>    // For std::shuffle()
+
+#include "Sudoku.h"
+#include "SudokuCanonical.h"
+#include "SudokuSolver_v3.h"
+#include "SudokuUnits.h"
+#include "SudokuSolver_units.h"
+
+//
+// Puzzle generator on top of the solution counting mode of the solvers.
+//
+// A full grid is made by filling the three diagonal boxes with random
+// permutations, completing them with the solver and applying a random
+// transform. Then the clues are removed in a random order, a removal is
+// kept only if the puzzle still has a unique solution, which is checked
+// with a search that stops at the second answer. A removed clue whose
+// cell is forced by its neighbors (a naked single) skips the search.
+//
+// The SudokuSolver must provide search<SearchMode::OneAnswer>(board)
+// and count_solutions(board), see v3::Solver.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy, typename SudokuSolver = v3::Solver<SudokuTy>>
+class Generator {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef SudokuSolver                        solver_type;
+    typedef typename SudokuTy::board_type       Board;
+    typedef Transform<SudokuTy>                 transform_t;
+    typedef std::mt19937                        random_gen;
+
+    static const size_t Rows = sudoku_t::Rows;
+    static const size_t Cols = sudoku_t::Cols;
+    static const size_t Boxes = sudoku_t::Boxes;
+    static const size_t BoxSize = sudoku_t::BoxSize;
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t Neighbors = sudoku_t::Neighbors;
+
+    struct Options {
+        size_t  target_clues;       // 0: stop at the first minimal puzzle
+        size_t  max_attempts;       // Full grids tried to reach the target_clues
+
+        Options() : target_clues(0), max_attempts(64) {}
+        Options(size_t targetClues, size_t maxAttempts = 64)
+            : target_clues(targetClues), max_attempts(maxAttempts) {}
+    };
+
+    struct Stats {
+        size_t  full_grids;
+        size_t  searches;           // Uniqueness checks done by the solver
+        size_t  forced_cells;       // Uniqueness checks skipped by a naked single
+        size_t  failed_attempts;    // Minimal puzzles above the target_clues
+
+        Stats() { this->reset(); }
+
+        void reset() {
+            this->full_grids = 0;
+            this->searches = 0;
+            this->forced_cells = 0;
+            this->failed_attempts = 0;
+        }
+
+        void add(const Stats & other) {
+            this->full_grids += other.full_grids;
+            this->searches += other.searches;
+            this->forced_cells += other.forced_cells;
+            this->failed_attempts += other.failed_attempts;
+        }
+    };
+
+private:
+    solver_type     solver_;
+    random_gen      rng_;
+    Stats           stats_;
+
+public:
+    Generator(uint32_t seed = 0) : rng_(seed) {}
+    ~Generator() {}
+
+    void seed(uint32_t seed) {
+        this->rng_.seed(seed);
+    }
+
+    const Stats & stats() const { return this->stats_; }
+    void reset_stats() { this->stats_.reset(); }
+
+    static size_t count_clues(const Board & board) {
+        size_t clues = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (board.cells[pos] != '.')
+                clues++;
+        }
+        return clues;
+    }
+
+    void make_full_grid(Board & grid) {
+        Board board;
+        for (;;) {
+            sudoku_t::clear_board(board);
+
+            // The diagonal boxes don't see each other.
+            for (size_t box = 0; box < Boxes; box += (sudoku_t::BoxCountX + 1)) {
+                char nums[Numbers];
+                for (size_t num = 0; num < Numbers; num++) {
+                    nums[num] = (char)('1' + num);
+                }
+                std::shuffle(&nums[0], &nums[Numbers], this->rng_);
+                for (size_t cell = 0; cell < BoxSize; cell++) {
+                    size_t pos = sudoku_t::boxes_info[box * BoxSize + cell].pos;
+                    board.cells[pos] = nums[cell];
+                }
+            }
+
+            if (this->solver_.template search<SearchMode::OneAnswer>(board) != 0)
+                break;
+        }
+        this->stats_.full_grids++;
+
+        // The search always completes a grid in the same way.
+        transform_t transform;
+        transform.random(this->rng_);
+        transform.apply(board, grid);
+    }
+
+    //
+    // Removes the clues of the grid in a random order, keeps the puzzle unique.
+    // Stops when target_clues is reached or no clue can be removed any more,
+    // returns the number of the clues left.
+    //
+    size_t remove_clues(const Board & grid, Board & puzzle, size_t target_clues = 0) {
+        uint8_t order[BoardSize];
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            order[pos] = (uint8_t)pos;
+        }
+        std::shuffle(&order[0], &order[BoardSize], this->rng_);
+
+        puzzle = grid;
+        size_t clues = count_clues(puzzle);
+        for (size_t i = 0; i < BoardSize; i++) {
+            if (clues <= target_clues)
+                break;
+            size_t pos = order[i];
+            char val = puzzle.cells[pos];
+            if (val == '.')
+                continue;
+
+            puzzle.cells[pos] = '.';
+            if (this->is_forced_cell(puzzle, pos)) {
+                this->stats_.forced_cells++;
+                clues--;
+                continue;
+            }
+
+            this->stats_.searches++;
+            if (this->solver_.count_solutions(puzzle) == 1)
+                clues--;
+            else
+                puzzle.cells[pos] = val;
+        }
+        return clues;
+    }
+
+    // Returns false if the options.target_clues is not reached.
+    bool generate(Board & puzzle, const Options & options = Options()) {
+        size_t max_attempts = (options.max_attempts != 0) ? options.max_attempts : 1;
+        Board grid;
+        for (size_t attempt = 0; attempt < max_attempts; attempt++) {
+            this->make_full_grid(grid);
+            size_t clues = this->remove_clues(grid, puzzle, options.target_clues);
+            if (clues <= options.target_clues || options.target_clues == 0)
+                return true;
+            this->stats_.failed_attempts++;
+        }
+        return false;
+    }
+
+private:
+    // All the other numbers are seen by the neighbors of the cell.
+    bool is_forced_cell(const Board & puzzle, size_t pos) const {
+        uint32_t num_bits = 0;
+        const uint8_t * neighbors = sudoku_t::neighbor_cells[pos].cells;
+        for (size_t i = 0; i < Neighbors; i++) {
+            char val = puzzle.cells[neighbors[i]];
+            if (val != '.')
+                num_bits |= 1U << (val - '1');
+        }
+        return (BitUtils::popcnt32(num_bits) == (Numbers - 1));
+    }
+};
+
+//
+// Generates count puzzles on threads, each thread has its own generator
+// seeded by (seed + thread index). Returns the number of the puzzles that
+// reached the target_clues, they are appended to the puzzles grouped by
+// thread (the puzzles of thread 0 first, each group in its own order).
+//
+template <typename SudokuTy, typename SudokuSolver = v3::Solver<SudokuTy>>
+size_t generate_puzzles(std::vector<typename SudokuTy::board_type> & puzzles,
+                        size_t count,
+                        const typename Generator<SudokuTy, SudokuSolver>::Options & options,
+                        size_t threads = 0,
+                        uint32_t seed = 0,
+                        typename Generator<SudokuTy, SudokuSolver>::Stats * stats = nullptr)
+{
+    typedef Generator<SudokuTy, SudokuSolver>       generator_t;
+    typedef typename generator_t::Stats             Stats;
+    typedef typename SudokuTy::board_type           Board;
+
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+    }
+
+    // Fill the static mask tables before the workers build their own solvers.
+    {
+        SudokuSolver solver;
+        (void)solver;
+    }
+
+    std::atomic<size_t> next_index(0);
+    std::vector<std::vector<Board>> thread_puzzles(threads);
+    std::vector<Stats> thread_stats(threads);
+
+    auto worker = [&](size_t thread_id) {
+        generator_t generator(seed + (uint32_t)thread_id * 0x9E3779B9U);
+        Board puzzle;
+        while (next_index.fetch_add(1, std::memory_order_relaxed) < count) {
+            if (generator.generate(puzzle, options)) {
+                thread_puzzles[thread_id].push_back(puzzle);
+            }
+        }
+        thread_stats[thread_id] = generator.stats();
+    };
+
+    if (threads == 1) {
+        worker(0);
+    }
+    else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            workers.emplace_back(worker, i);
+        }
+        for (size_t i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+    }
+
+    size_t generated = 0;
+    for (size_t i = 0; i < threads; i++) {
+        puzzles.insert(puzzles.end(), thread_puzzles[i].begin(), thread_puzzles[i].end());
+        generated += thread_puzzles[i].size();
+        if (stats != nullptr)
+            stats->add(thread_stats[i]);
+    }
+    return generated;
+}
+
+//
+// Puzzle generator of the sudoku variants, on a solver that takes the Units
+// (see units::Solver and dlx::units::Solver).
+//
+// The transforms of the Generator don't keep the extra units, so a full grid
+// is completed by the solver from a few random givens, under a small poll
+// budget (a bad start is dropped, not proven unsolvable). The clues are
+// removed like Generator::remove_clues(), a cell is forced by its peers.
+//
+template <typename SudokuTy, typename SudokuSolver = units::Solver<SudokuTy>>
+class UnitsGenerator {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef SudokuSolver                        solver_type;
+    typedef typename SudokuTy::board_type       Board;
+    typedef Units<SudokuTy>                     units_t;
+    typedef std::mt19937                        random_gen;
+
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+
+    // The random givens of a full grid, and the budget to complete it: the
+    // Units engines poll the control at the guesses only.
+    static const size_t kSeedGivens = Numbers;
+    static const size_t kMaxGridPolls = 256;
+
+    struct Stats {
+        size_t  full_grids;
+        size_t  dropped_grids;      // Random givens that were not completed
+        size_t  searches;           // Uniqueness checks done by the solver
+        size_t  forced_cells;       // Uniqueness checks skipped by a naked single
+
+        Stats() { this->reset(); }
+
+        void reset() {
+            this->full_grids = 0;
+            this->dropped_grids = 0;
+            this->searches = 0;
+            this->forced_cells = 0;
+        }
+    };
+
+private:
+    const units_t & units_;
+    solver_type     solver_;
+    random_gen      rng_;
+    Stats           stats_;
+
+public:
+    UnitsGenerator(const units_t & units, uint32_t seed = 0)
+        : units_(units), solver_(units), rng_(seed) {}
+    ~UnitsGenerator() {}
+
+    void seed(uint32_t seed) {
+        this->rng_.seed(seed);
+    }
+
+    const Stats & stats() const { return this->stats_; }
+    void reset_stats() { this->stats_.reset(); }
+
+    void make_full_grid(Board & grid) {
+        // The polls are counted by the control, whatever the StatsTy is.
+        SearchControl control;
+        control.set_max_polls(kMaxGridPolls);
+        this->solver_.set_control(&control);
+        for (;;) {
+            sudoku_t::clear_board(grid);
+
+            uint8_t order[BoardSize];
+            for (size_t pos = 0; pos < BoardSize; pos++) {
+                order[pos] = (uint8_t)pos;
+            }
+            std::shuffle(&order[0], &order[BoardSize], this->rng_);
+
+            bool is_valid = true;
+            for (size_t i = 0; i < kSeedGivens && is_valid; i++) {
+                size_t pos = order[i];
+                uint32_t candidates = ~this->peer_nums(grid, pos) & (uint32_t)((size_t(1) << Numbers) - 1);
+                is_valid = (candidates != 0);
+                if (is_valid) {
+                    size_t count = BitUtils::popcnt32(candidates);
+                    size_t pick = std::uniform_int_distribution<size_t>(0, count - 1)(this->rng_);
+                    for (size_t k = 0; k < pick; k++) {
+                        candidates &= candidates - 1;
+                    }
+                    grid.cells[pos] = (char)('1' + BitUtils::bsf32(candidates));
+                }
+            }
+
+            control.reset();
+            if (is_valid && this->solver_.solve(grid))
+                break;
+            this->stats_.dropped_grids++;
+        }
+        this->solver_.set_control(nullptr);
+        this->stats_.full_grids++;
+    }
+
+    //
+    // Removes the clues of the grid in a random order, keeps the puzzle unique.
+    // Returns the number of the clues left, the puzzle is minimal.
+    //
+    size_t remove_clues(const Board & grid, Board & puzzle) {
+        uint8_t order[BoardSize];
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            order[pos] = (uint8_t)pos;
+        }
+        std::shuffle(&order[0], &order[BoardSize], this->rng_);
+
+        puzzle = grid;
+        size_t clues = BoardSize;
+        for (size_t i = 0; i < BoardSize; i++) {
+            size_t pos = order[i];
+            char val = puzzle.cells[pos];
+            puzzle.cells[pos] = '.';
+            if (BitUtils::popcnt32(this->peer_nums(puzzle, pos)) == (Numbers - 1)) {
+                this->stats_.forced_cells++;
+                clues--;
+                continue;
+            }
+
+            this->stats_.searches++;
+            if (this->solver_.count_solutions(puzzle) == 1)
+                clues--;
+            else
+                puzzle.cells[pos] = val;
+        }
+        return clues;
+    }
+
+    size_t generate(Board & puzzle) {
+        Board grid;
+        this->make_full_grid(grid);
+        return this->remove_clues(grid, puzzle);
+    }
+
+private:
+    // The numbers in the peers of the cell.
+    uint32_t peer_nums(const Board & board, size_t pos) const {
+        uint32_t num_bits = 0;
+        const typename units_t::cell_mask_t & peers = this->units_.peers(pos);
+        for (size_t w = 0; w < units_t::cell_mask_t::kWords; w++) {
+            size_t bits = peers.words[w];
+            while (bits != 0) {
+                size_t bit = BitUtils::ls1b(bits);
+                size_t peer = w * units_t::cell_mask_t::kWordBits + BitUtils::bsf(bit);
+                bits ^= bit;
+                char val = board.cells[peer];
+                if (val != '.')
+                    num_bits |= 1U << (val - '1');
+            }
+        }
+        return num_bits;
+    }
+};
+
+//
+// Text format: 81 characters per line, '.' is an empty cell.
+// Binary format: 81 bytes per puzzle, 0 is an empty cell, 1-9 are the numbers.
+//
+template <typename SudokuTy>
+bool write_puzzles(const char * filename,
+                   const std::vector<typename SudokuTy::board_type> & puzzles,
+                   bool is_binary = false)
+{
+    std::ofstream ofs;
+    ofs.open(filename, is_binary ? (std::ios::out | std::ios::trunc | std::ios::binary)
+                                 : (std::ios::out | std::ios::trunc));
+    if (!ofs.good())
+        return false;
+
+    char line[SudokuTy::BoardSize + 1];
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+            char val = puzzles[i].cells[pos];
+            if (is_binary)
+                line[pos] = (val != '.') ? (char)(val - '0') : (char)0;
+            else
+                line[pos] = val;
+        }
+        if (is_binary) {
+            ofs.write(line, SudokuTy::BoardSize);
+        }
+        else {
+            line[SudokuTy::BoardSize] = '\n';
+            ofs.write(line, SudokuTy::BoardSize + 1);
+        }
+    }
+
+    bool success = ofs.good();
+    ofs.close();
+    return success;
+}
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_GENERATOR_H
@@ -0,0 +1,794 @@
+
+#ifndef JM_SUDOKU_GRADER_H
+#define JM_SUDOKU_GRADER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+#include <atomic>
+#include <thread>
+
+#include "Sudoku.h"
+#include "BitUtils.h"
+
+//
+// Difficulty grading by human style techniques.
+//
+// The grader keeps the candidates of every cell as a bit mask and solves with
+// an ordered ladder of techniques, after every step it starts again from the
+// easiest one. Only when no technique applies it guesses a cell with the
+// fewest candidates, and goes on with the ladder in every branch.
+//
+// A step is one placement for the singles, and one technique instance that
+// eliminates some candidates for the others. The rating is the weight of the
+// hardest technique used.
+//
+namespace jmSudoku {
+
+enum Technique {
+    HiddenSingle,
+    NakedSingle,
+    LockedCandidates,
+    NakedPair,
+    HiddenPair,
+    NakedTriple,
+    HiddenTriple,
+    XWing,
+    Swordfish,
+    XYWing,
+    XYChain,
+    Guess,
+    TechniqueLast
+};
+
+template <typename SudokuTy>
+class Grader {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef typename SudokuTy::CellInfo         CellInfo;
+
+    static const size_t Rows = sudoku_t::Rows;
+    static const size_t Cols = sudoku_t::Cols;
+    static const size_t Boxes = sudoku_t::Boxes;
+    static const size_t BoxSize = sudoku_t::BoxSize;
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t Neighbors = sudoku_t::Neighbors;
+
+    static const size_t Units = Rows + Cols + Boxes;
+    static const size_t UnitSize = Numbers;
+
+    static const uint32_t kAllNumbers = (uint32_t)sudoku_t::kAllNumberBits;
+    static const size_t kMaxSubsetSize = 4;
+    static const size_t kMaxChainLength = 8;
+
+    struct Result {
+        bool        solved;
+        uint32_t    hardest;            // Technique
+        double      rating;
+        uint32_t    steps[TechniqueLast];
+
+        void reset() {
+            this->solved = false;
+            this->hardest = HiddenSingle;
+            this->rating = 0.0;
+            std::memset((void *)&this->steps[0], 0, sizeof(this->steps));
+        }
+    };
+
+    static const char * technique_name(size_t technique) {
+        static const char * names[TechniqueLast] = {
+            "Hidden single",
+            "Naked single",
+            "Locked candidates",
+            "Naked pair",
+            "Hidden pair",
+            "Naked triple",
+            "Hidden triple",
+            "X-Wing",
+            "Swordfish",
+            "XY-Wing",
+            "XY-Chain",
+            "Guess"
+        };
+        return (technique < TechniqueLast) ? names[technique] : "Unknown";
+    }
+
+    static double technique_weight(size_t technique) {
+        static const double weights[TechniqueLast] = {
+            1.2, 2.3, 2.6, 3.0, 3.4, 3.6, 4.0, 4.2, 4.6, 5.0, 6.5, 9.0
+        };
+        return (technique < TechniqueLast) ? weights[technique] : 0.0;
+    }
+
+    static const char * rating_band(double rating) {
+        if (rating <= technique_weight(NakedSingle))
+            return "Easy";
+        else if (rating <= technique_weight(HiddenTriple))
+            return "Medium";
+        else if (rating <= technique_weight(XYWing))
+            return "Hard";
+        else if (rating <= technique_weight(XYChain))
+            return "Expert";
+        else
+            return "Extreme";
+    }
+
+private:
+    struct State {
+        uint16_t    cands[BoardSize];   // 0 if the cell is filled
+        uint8_t     cells[BoardSize];   // 0 or the number (1 - 9)
+        size_t      empties;
+    };
+
+    struct Tables {
+        uint8_t     units[Units][UnitSize];
+        uint8_t     cell_units[BoardSize][3];
+
+        Tables() {
+            for (size_t pos = 0; pos < BoardSize; pos++) {
+                const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                this->units[cellInfo.row][cellInfo.col] = (uint8_t)pos;
+                this->units[Rows + cellInfo.col][cellInfo.row] = (uint8_t)pos;
+                this->units[Rows + Cols + cellInfo.box][cellInfo.cell] = (uint8_t)pos;
+                this->cell_units[pos][0] = cellInfo.row;
+                this->cell_units[pos][1] = (uint8_t)(Rows + cellInfo.col);
+                this->cell_units[pos][2] = (uint8_t)(Rows + Cols + cellInfo.box);
+            }
+        }
+    };
+
+    static const Tables & tables() {
+        static const Tables s_tables;
+        return s_tables;
+    }
+
+    const Tables &  tables_;
+    Result *        result_;
+
+    static uint32_t popcnt(uint32_t bits) {
+        return BitUtils::popcnt32(bits);
+    }
+
+    static bool is_peer(size_t pos1, size_t pos2) {
+        const CellInfo & cellInfo1 = sudoku_t::cell_info[pos1];
+        const CellInfo & cellInfo2 = sudoku_t::cell_info[pos2];
+        return ((cellInfo1.row == cellInfo2.row) || (cellInfo1.col == cellInfo2.col) ||
+                (cellInfo1.box == cellInfo2.box));
+    }
+
+public:
+    Grader() : tables_(tables()), result_(nullptr) {}
+    ~Grader() {}
+
+    //
+    // Returns false if the puzzle has no solution, a puzzle with more
+    // than one solution is graded along the first solution found.
+    //
+    bool grade(const Board & puzzle, Board & solution, Result & result) {
+        result.reset();
+        this->result_ = &result;
+
+        State state;
+        bool success = this->init_state(state, puzzle);
+        if (success) {
+            success = this->search(state);
+        }
+        if (success) {
+            for (size_t pos = 0; pos < BoardSize; pos++) {
+                solution.cells[pos] = (char)('0' + state.cells[pos]);
+            }
+        }
+
+        result.solved = success;
+        result.hardest = HiddenSingle;
+        result.rating = 0.0;
+        for (size_t technique = 0; technique < TechniqueLast; technique++) {
+            if (result.steps[technique] != 0 && technique_weight(technique) > result.rating) {
+                result.hardest = (uint32_t)technique;
+                result.rating = technique_weight(technique);
+            }
+        }
+        this->result_ = nullptr;
+        return success;
+    }
+
+private:
+    bool init_state(State & state, const Board & puzzle) {
+        state.empties = BoardSize;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            state.cands[pos] = (uint16_t)kAllNumbers;
+            state.cells[pos] = 0;
+        }
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            char val = puzzle.cells[pos];
+            if (val >= '1' && val <= '9') {
+                size_t num = (size_t)(val - '1');
+                if ((state.cands[pos] & (1U << num)) == 0)
+                    return false;
+                this->place(state, pos, num);
+            }
+        }
+        return true;
+    }
+
+    void place(State & state, size_t pos, size_t num) {
+        assert(state.cells[pos] == 0);
+        state.cells[pos] = (uint8_t)(num + 1);
+        state.cands[pos] = 0;
+        state.empties--;
+
+        uint16_t mask = (uint16_t)~(1U << num);
+        const uint8_t * neighbors = sudoku_t::neighbor_cells[pos].cells;
+        for (size_t i = 0; i < Neighbors; i++) {
+            state.cands[neighbors[i]] &= mask;
+        }
+    }
+
+    bool is_consistent(const State & state) const {
+        for (size_t unit = 0; unit < Units; unit++) {
+            const uint8_t * cells = this->tables_.units[unit];
+            uint32_t nums = 0, placed = 0;
+            for (size_t i = 0; i < UnitSize; i++) {
+                size_t pos = cells[i];
+                if (state.cells[pos] != 0) {
+                    placed |= 1U << (state.cells[pos] - 1);
+                }
+                else {
+                    if (state.cands[pos] == 0)
+                        return false;
+                    nums |= state.cands[pos];
+                }
+            }
+            if ((nums | placed) != kAllNumbers)
+                return false;
+        }
+        return true;
+    }
+
+    // The positions in the unit of every number.
+    void get_unit_positions(const State & state, size_t unit, uint32_t positions[Numbers]) const {
+        const uint8_t * cells = this->tables_.units[unit];
+        for (size_t num = 0; num < Numbers; num++) {
+            positions[num] = 0;
+        }
+        for (size_t i = 0; i < UnitSize; i++) {
+            uint32_t cands = state.cands[cells[i]];
+            while (cands != 0) {
+                uint32_t num = BitUtils::bsf(cands);
+                positions[num] |= 1U << i;
+                cands &= cands - 1;
+            }
+        }
+    }
+
+    bool search(State & state) {
+        int status = this->solve_logic(state);
+        if (status > 0)
+            return true;
+        if (status < 0)
+            return false;
+
+        // Guess a cell with the fewest candidates.
+        size_t min_pos = 0;
+        uint32_t min_size = uint32_t(-1);
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (state.cells[pos] == 0) {
+                uint32_t size = popcnt(state.cands[pos]);
+                if (size < min_size) {
+                    min_size = size;
+                    min_pos = pos;
+                    if (size <= 2)
+                        break;
+                }
+            }
+        }
+
+        uint32_t cands = state.cands[min_pos];
+        while (cands != 0) {
+            size_t num = BitUtils::bsf(cands);
+            cands &= cands - 1;
+
+            State next_state = state;
+            this->result_->steps[Guess]++;
+            this->place(next_state, min_pos, num);
+            if (this->search(next_state)) {
+                state = next_state;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns 1 if solved, 0 if no technique applies, -1 if a contradiction.
+    int solve_logic(State & state) {
+        uint32_t * steps = this->result_->steps;
+        while (state.empties != 0) {
+            if (!this->is_consistent(state))
+                return -1;
+
+            size_t count;
+            if ((count = this->hidden_singles(state)) != 0) {
+                steps[HiddenSingle] += (uint32_t)count;
+                continue;
+            }
+            if ((count = this->naked_singles(state)) != 0) {
+                steps[NakedSingle] += (uint32_t)count;
+                continue;
+            }
+            if (this->locked_candidates(state)) {
+                steps[LockedCandidates]++;
+                continue;
+            }
+            if (this->naked_subset(state, 2)) {
+                steps[NakedPair]++;
+                continue;
+            }
+            if (this->hidden_subset(state, 2)) {
+                steps[HiddenPair]++;
+                continue;
+            }
+            if (this->naked_subset(state, 3)) {
+                steps[NakedTriple]++;
+                continue;
+            }
+            if (this->hidden_subset(state, 3)) {
+                steps[HiddenTriple]++;
+                continue;
+            }
+            if (this->basic_fish(state, 2)) {
+                steps[XWing]++;
+                continue;
+            }
+            if (this->basic_fish(state, 3)) {
+                steps[Swordfish]++;
+                continue;
+            }
+            if (this->xy_wing(state)) {
+                steps[XYWing]++;
+                continue;
+            }
+            if (this->xy_chain(state)) {
+                steps[XYChain]++;
+                continue;
+            }
+            return 0;
+        }
+        return 1;
+    }
+
+    size_t hidden_singles(State & state) {
+        size_t count = 0;
+        for (size_t unit = 0; unit < Units; unit++) {
+            const uint8_t * cells = this->tables_.units[unit];
+            uint32_t once = 0, twice = 0;
+            for (size_t i = 0; i < UnitSize; i++) {
+                uint32_t cands = state.cands[cells[i]];
+                twice |= once & cands;
+                once |= cands;
+            }
+            uint32_t singles = once & ~twice;
+            while (singles != 0) {
+                size_t num = BitUtils::bsf(singles);
+                singles &= singles - 1;
+                uint32_t num_bit = 1U << num;
+                for (size_t i = 0; i < UnitSize; i++) {
+                    size_t pos = cells[i];
+                    if ((state.cands[pos] & num_bit) != 0) {
+                        this->place(state, pos, num);
+                        count++;
+                        break;
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    size_t naked_singles(State & state) {
+        size_t count = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            uint32_t cands = state.cands[pos];
+            if (cands != 0 && (cands & (cands - 1)) == 0) {
+                this->place(state, pos, BitUtils::bsf(cands));
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // Removes the mask from the cands of the cell, returns true if changed.
+    static bool eliminate(State & state, size_t pos, uint32_t mask) {
+        uint32_t cands = state.cands[pos];
+        if ((cands & mask) != 0) {
+            state.cands[pos] = (uint16_t)(cands & ~mask);
+            return true;
+        }
+        return false;
+    }
+
+    bool locked_candidates(State & state) {
+        for (size_t unit = 0; unit < Units; unit++) {
+            uint32_t positions[Numbers];
+            this->get_unit_positions(state, unit, positions);
+            const uint8_t * cells = this->tables_.units[unit];
+            size_t unit_type = (unit < Rows) ? 0 : ((unit < Rows + Cols) ? 1 : 2);
+
+            for (size_t num = 0; num < Numbers; num++) {
+                uint32_t num_positions = positions[num];
+                if (popcnt(num_positions) < 2)
+                    continue;
+
+                // The cells of the number share another unit: pointing if the
+                // unit is a box, claiming if it is a row or a column.
+                size_t first = cells[BitUtils::bsf(num_positions)];
+                for (size_t k = 0; k < 3; k++) {
+                    size_t other_unit = this->tables_.cell_units[first][k];
+                    if (other_unit == unit)
+                        continue;
+                    bool is_shared = true;
+                    uint32_t bits = num_positions;
+                    while (bits != 0) {
+                        size_t pos = cells[BitUtils::bsf(bits)];
+                        bits &= bits - 1;
+                        if (this->tables_.cell_units[pos][k] != other_unit) {
+                            is_shared = false;
+                            break;
+                        }
+                    }
+                    if (!is_shared)
+                        continue;
+
+                    bool changed = false;
+                    const uint8_t * other_cells = this->tables_.units[other_unit];
+                    for (size_t i = 0; i < UnitSize; i++) {
+                        size_t pos = other_cells[i];
+                        if (this->tables_.cell_units[pos][unit_type] != unit)
+                            changed |= eliminate(state, pos, 1U << num);
+                    }
+                    if (changed)
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool naked_subset(State & state, size_t subset_size) {
+        for (size_t unit = 0; unit < Units; unit++) {
+            const uint8_t * cells = this->tables_.units[unit];
+            uint8_t list[UnitSize];
+            size_t list_size = 0;
+            for (size_t i = 0; i < UnitSize; i++) {
+                uint32_t size = popcnt(state.cands[cells[i]]);
+                if (size >= 2 && size <= subset_size)
+                    list[list_size++] = (uint8_t)i;
+            }
+            if (list_size < subset_size)
+                continue;
+
+            size_t index[kMaxSubsetSize];
+            if (this->find_naked_subset(state, cells, list, list_size, subset_size, 0, 0, 0, index))
+                return true;
+        }
+        return false;
+    }
+
+    bool find_naked_subset(State & state, const uint8_t * cells, const uint8_t * list, size_t list_size,
+                           size_t subset_size, size_t depth, size_t start, uint32_t nums, size_t * index) {
+        if (depth == subset_size) {
+            if (popcnt(nums) != subset_size)
+                return false;
+            uint32_t members = 0;
+            for (size_t i = 0; i < subset_size; i++) {
+                members |= 1U << list[index[i]];
+            }
+            bool changed = false;
+            for (size_t i = 0; i < UnitSize; i++) {
+                if ((members & (1U << i)) == 0)
+                    changed |= eliminate(state, cells[i], nums);
+            }
+            return changed;
+        }
+        if (depth >= kMaxSubsetSize)
+            return false;
+        for (size_t i = start; i < list_size; i++) {
+            uint32_t new_nums = nums | state.cands[cells[list[i]]];
+            if (popcnt(new_nums) > subset_size)
+                continue;
+            index[depth] = i;
+            if (this->find_naked_subset(state, cells, list, list_size, subset_size,
+                                        depth + 1, i + 1, new_nums, index))
+                return true;
+        }
+        return false;
+    }
+
+    bool hidden_subset(State & state, size_t subset_size) {
+        for (size_t unit = 0; unit < Units; unit++) {
+            uint32_t positions[Numbers];
+            this->get_unit_positions(state, unit, positions);
+
+            uint8_t list[Numbers];
+            size_t list_size = 0;
+            for (size_t num = 0; num < Numbers; num++) {
+                uint32_t size = popcnt(positions[num]);
+                if (size >= 2 && size <= subset_size)
+                    list[list_size++] = (uint8_t)num;
+            }
+            if (list_size < subset_size)
+                continue;
+
+            size_t index[kMaxSubsetSize];
+            if (this->find_hidden_subset(state, unit, positions, list, list_size,
+                                         subset_size, 0, 0, 0, index))
+                return true;
+        }
+        return false;
+    }
+
+    bool find_hidden_subset(State & state, size_t unit, const uint32_t * positions,
+                            const uint8_t * list, size_t list_size, size_t subset_size,
+                            size_t depth, size_t start, uint32_t cells_mask, size_t * index) {
+        if (depth == subset_size) {
+            if (popcnt(cells_mask) != subset_size)
+                return false;
+            uint32_t nums = 0;
+            for (size_t i = 0; i < subset_size; i++) {
+                nums |= 1U << list[index[i]];
+            }
+            bool changed = false;
+            const uint8_t * cells = this->tables_.units[unit];
+            while (cells_mask != 0) {
+                size_t i = BitUtils::bsf(cells_mask);
+                cells_mask &= cells_mask - 1;
+                changed |= eliminate(state, cells[i], ~nums & kAllNumbers);
+            }
+            return changed;
+        }
+        if (depth >= kMaxSubsetSize)
+            return false;
+        for (size_t i = start; i < list_size; i++) {
+            uint32_t new_cells_mask = cells_mask | positions[list[i]];
+            if (popcnt(new_cells_mask) > subset_size)
+                continue;
+            index[depth] = i;
+            if (this->find_hidden_subset(state, unit, positions, list, list_size, subset_size,
+                                         depth + 1, i + 1, new_cells_mask, index))
+                return true;
+        }
+        return false;
+    }
+
+    // X-Wing (fish_size = 2) and Swordfish (fish_size = 3), rows or columns as the base.
+    bool basic_fish(State & state, size_t fish_size) {
+        for (size_t num = 0; num < Numbers; num++) {
+            uint32_t num_bit = 1U << num;
+            for (size_t dir = 0; dir < 2; dir++) {
+                uint32_t lines[Rows];
+                uint8_t list[Rows];
+                size_t list_size = 0;
+                for (size_t line = 0; line < Rows; line++) {
+                    const uint8_t * cells = this->tables_.units[dir * Rows + line];
+                    uint32_t mask = 0;
+                    for (size_t i = 0; i < UnitSize; i++) {
+                        if ((state.cands[cells[i]] & num_bit) != 0)
+                            mask |= 1U << i;
+                    }
+                    lines[line] = mask;
+                    uint32_t size = popcnt(mask);
+                    if (size >= 2 && size <= fish_size)
+                        list[list_size++] = (uint8_t)line;
+                }
+                if (list_size < fish_size)
+                    continue;
+
+                size_t index[kMaxSubsetSize];
+                if (this->find_fish(state, num, dir, lines, list, list_size, fish_size, 0, 0, 0, index))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    bool find_fish(State & state, size_t num, size_t dir, const uint32_t * lines,
+                   const uint8_t * list, size_t list_size, size_t fish_size,
+                   size_t depth, size_t start, uint32_t cover, size_t * index) {
+        if (depth == fish_size) {
+            if (popcnt(cover) != fish_size)
+                return false;
+            uint32_t base = 0;
+            for (size_t i = 0; i < fish_size; i++) {
+                base |= 1U << list[index[i]];
+            }
+            // The cover lines are the other direction.
+            bool changed = false;
+            while (cover != 0) {
+                size_t line = BitUtils::bsf(cover);
+                cover &= cover - 1;
+                const uint8_t * cells = this->tables_.units[(1 - dir) * Rows + line];
+                for (size_t i = 0; i < UnitSize; i++) {
+                    if ((base & (1U << i)) == 0)
+                        changed |= eliminate(state, cells[i], 1U << num);
+                }
+            }
+            return changed;
+        }
+        if (depth >= kMaxSubsetSize)
+            return false;
+        for (size_t i = start; i < list_size; i++) {
+            uint32_t new_cover = cover | lines[list[i]];
+            if (popcnt(new_cover) > fish_size)
+                continue;
+            index[depth] = i;
+            if (this->find_fish(state, num, dir, lines, list, list_size, fish_size,
+                                depth + 1, i + 1, new_cover, index))
+                return true;
+        }
+        return false;
+    }
+
+    // Removes the num from the cells that see both pos1 and pos2.
+    bool eliminate_common_peers(State & state, size_t pos1, size_t pos2, size_t num) {
+        bool changed = false;
+        const uint8_t * neighbors = sudoku_t::neighbor_cells[pos1].cells;
+        for (size_t i = 0; i < Neighbors; i++) {
+            size_t pos = neighbors[i];
+            if (pos != pos2 && (state.cands[pos] & (1U << num)) != 0 && is_peer(pos, pos2)) {
+                changed |= eliminate(state, pos, 1U << num);
+            }
+        }
+        return changed;
+    }
+
+    bool xy_wing(State & state) {
+        for (size_t pivot = 0; pivot < BoardSize; pivot++) {
+            uint32_t pivot_cands = state.cands[pivot];
+            if (popcnt(pivot_cands) != 2)
+                continue;
+
+            const uint8_t * neighbors = sudoku_t::neighbor_cells[pivot].cells;
+            for (size_t i = 0; i < Neighbors; i++) {
+                size_t pincer1 = neighbors[i];
+                uint32_t cands1 = state.cands[pincer1];
+                if (popcnt(cands1) != 2 || popcnt(cands1 & pivot_cands) != 1)
+                    continue;
+                // pivot = {a, b}, pincer1 = {a, c}, pincer2 = {b, c}
+                uint32_t cands2 = (pivot_cands ^ cands1);
+                uint32_t c_bit = cands1 & ~pivot_cands;
+                for (size_t j = i + 1; j < Neighbors; j++) {
+                    size_t pincer2 = neighbors[j];
+                    if (state.cands[pincer2] != cands2)
+                        continue;
+                    if (this->eliminate_common_peers(state, pincer1, pincer2, BitUtils::bsf(c_bit)))
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    //
+    // A chain of bivalue cells, each one sees the next one and shares a number
+    // with it: if the first cell isn't x, the last cell must be x. So x can be
+    // removed from the cells that see both ends.
+    //
+    bool xy_chain(State & state) {
+        bool visited[BoardSize];
+        std::memset((void *)&visited[0], 0, sizeof(visited));
+        for (size_t start = 0; start < BoardSize; start++) {
+            uint32_t cands = state.cands[start];
+            if (popcnt(cands) != 2)
+                continue;
+            visited[start] = true;
+            uint32_t bits = cands;
+            while (bits != 0) {
+                size_t x = BitUtils::bsf(bits);
+                bits &= bits - 1;
+                size_t on_num = BitUtils::bsf(cands & ~(1U << x));
+                if (this->find_xy_chain(state, start, x, start, on_num, 1, visited))
+                    return true;
+            }
+            visited[start] = false;
+        }
+        return false;
+    }
+
+    bool find_xy_chain(State & state, size_t start, size_t x, size_t pos, size_t on_num,
+                       size_t length, bool * visited) {
+        if (length >= kMaxChainLength)
+            return false;
+        const uint8_t * neighbors = sudoku_t::neighbor_cells[pos].cells;
+        for (size_t i = 0; i < Neighbors; i++) {
+            size_t next = neighbors[i];
+            uint32_t cands = state.cands[next];
+            if (visited[next] || popcnt(cands) != 2 || (cands & (1U << on_num)) == 0)
+                continue;
+            size_t next_on_num = BitUtils::bsf(cands & ~(1U << on_num));
+            // The length of the shortest chain (3 cells) is the XY-Wing.
+            if (next_on_num == x && length >= 3) {
+                if (this->eliminate_common_peers(state, start, next, x))
+                    return true;
+            }
+            visited[next] = true;
+            bool found = this->find_xy_chain(state, start, x, next, next_on_num, length + 1, visited);
+            visited[next] = false;
+            if (found)
+                return true;
+        }
+        return false;
+    }
+};
+
+//
+// Grades the puzzles on threads, the results and the solutions are stored
+// in the order of the puzzles. Returns the number of the solved puzzles.
+//
+template <typename SudokuTy>
+size_t grade_puzzles(const std::vector<typename SudokuTy::board_type> & puzzles,
+                     std::vector<typename SudokuTy::board_type> & solutions,
+                     std::vector<typename Grader<SudokuTy>::Result> & results,
+                     size_t threads = 0)
+{
+    static const size_t kChunkSize = 64;
+
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+    }
+
+    size_t count = puzzles.size();
+    solutions.resize(count);
+    results.resize(count);
+
+    std::atomic<size_t> next_index(0);
+    std::atomic<size_t> solved(0);
+
+    auto worker = [&]() {
+        Grader<SudokuTy> grader;
+        size_t local_solved = 0;
+        for (;;) {
+            size_t first = next_index.fetch_add(kChunkSize, std::memory_order_relaxed);
+            if (first >= count)
+                break;
+            size_t last = (first + kChunkSize < count) ? (first + kChunkSize) : count;
+            for (size_t i = first; i < last; i++) {
+                if (grader.grade(puzzles[i], solutions[i], results[i]))
+                    local_solved++;
+            }
+        }
+        solved.fetch_add(local_solved, std::memory_order_relaxed);
+    };
+
+    if (threads == 1) {
+        worker();
+    }
+    else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            workers.emplace_back(worker);
+        }
+        for (size_t i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+    }
+
+    return solved.load();
+}
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_GRADER_H
@@ -0,0 +1,221 @@
+
+#if defined(_MSC_VER)
+#define __MMX__
+#define __SSE__
+#define __SSE2__
+#define __SSE3__
+#define __SSSE3__
+#define __SSE4A__
+#define __SSE4a__
+#define __SSE4_1__
+#define __SSE4_2__
+#define __POPCNT__
+#define __LZCNT__
+#define __AVX__
+#define __AVX2__
+#define __3dNOW__
+#endif
+
+#define JM_SUDOKU_BUILD_LIB
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memcpy()
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "Sudoku.h"
+#include "BasicSolver.hpp"
+#include "SudokuSolver_v3.h"
+
+#include "SudokuLib.h"
+
+using namespace jmSudoku;
+
+namespace {
+
+// The stats counters of the solvers are thread_local, every count of them
+// calls __tls_get_addr() in a shared library. The guesses are counted by the
+// solver itself.
+typedef v3::Solver<Sudoku, v3::DefaultPolicy, NoStats>  solver_t;
+typedef Sudoku::board_type                              Board;
+
+std::once_flag s_init_flag;
+
+void init_tables()
+{
+    Sudoku::initialize();
+    // The first solver initializes the shared mask tables.
+    solver_t solver;
+    (void)solver;
+}
+
+solver_t & get_thread_solver()
+{
+    std::call_once(s_init_flag, init_tables);
+    static thread_local solver_t s_thread_solver;
+    return s_thread_solver;
+}
+
+bool parse_board(const char * in, Board & board)
+{
+    for (size_t pos = 0; pos < Sudoku::BoardSize; pos++) {
+        char val = in[pos];
+        if (val >= '1' && val <= '9')
+            board.cells[pos] = val;
+        else if (val == '.' || val == '0')
+            board.cells[pos] = '.';
+        else
+            return false;
+    }
+    return true;
+}
+
+int solve_one(solver_t & solver, const char * in, char * out,
+              uint32_t flags, jm_stats * stats)
+{
+    Board board;
+    int status;
+    bool is_searched = false;
+
+    // An inconsistent board is rejected by the input check of search().
+    if (!parse_board(in, board)) {
+        status = JM_INVALID;
+    }
+    else if ((flags & JM_CHECK_UNIQUE) != 0) {
+        is_searched = true;
+        size_t answers = solver.search<SearchMode::MoreThanOneAnswer>(board);
+        if (answers == 1) {
+            std::memcpy(out, solver.answers()[0].cells, Sudoku::BoardSize);
+            status = JM_SOLVED;
+        }
+        else {
+            status = (answers == 0) ? JM_NO_SOLUTION : JM_MULTIPLE;
+        }
+    }
+    else {
+        is_searched = true;
+        if (solver.search<SearchMode::OneAnswer>(board) != 0) {
+            std::memcpy(out, board.cells, Sudoku::BoardSize);
+            status = JM_SOLVED;
+        }
+        else {
+            status = JM_NO_SOLUTION;
+        }
+    }
+
+    if (stats != nullptr) {
+        stats->puzzles++;
+        switch (status) {
+            case JM_SOLVED:         stats->solved++;        break;
+            case JM_NO_SOLUTION:    stats->no_solution++;   break;
+            case JM_MULTIPLE:       stats->multiple++;      break;
+            default:                stats->invalid++;       break;
+        }
+        // The counter is cleared by every search that passes the input check.
+        if (is_searched && solver_t::get_last_check() == BoardCheck::BoardValid) {
+            stats->num_guesses += solver.guesses();
+        }
+    }
+    return status;
+}
+
+void add_stats(jm_stats & total, const jm_stats & stats)
+{
+    total.puzzles += stats.puzzles;
+    total.solved += stats.solved;
+    total.no_solution += stats.no_solution;
+    total.multiple += stats.multiple;
+    total.invalid += stats.invalid;
+    total.num_guesses += stats.num_guesses;
+    total.num_unique_candidate += stats.num_unique_candidate;
+    total.num_failed_return += stats.num_failed_return;
+}
+
+} // namespace
+
+extern "C" {
+
+JM_SUDOKU_API int jm_abi_version(void)
+{
+    return JM_SUDOKU_ABI_VERSION;
+}
+
+JM_SUDOKU_API int jm_solve(const char in[81], char out[81], jm_stats * stats)
+{
+    if (in == nullptr || out == nullptr)
+        return JM_INVALID;
+    return solve_one(get_thread_solver(), in, out, 0, stats);
+}
+
+JM_SUDOKU_API size_t jm_solve_batch(const char * in, size_t n, size_t stride,
+                                    char * out, const jm_opts * opts)
+{
+    static const size_t kChunkSize = 256;
+
+    if (in == nullptr || out == nullptr || stride < Sudoku::BoardSize)
+        return 0;
+
+    size_t threads = (opts != nullptr) ? opts->threads : 0;
+    uint32_t flags = (opts != nullptr) ? opts->flags : 0;
+    uint8_t * status = (opts != nullptr) ? opts->status : nullptr;
+    jm_stats * stats = (opts != nullptr) ? opts->stats : nullptr;
+
+    if (threads > n / kChunkSize)
+        threads = n / kChunkSize;
+
+    std::atomic<size_t> next_index(0);
+    std::atomic<size_t> solved(0);
+    std::mutex stats_mutex;
+
+    auto worker = [&]() {
+        solver_t & solver = get_thread_solver();
+        jm_stats local_stats;
+        std::memset((void *)&local_stats, 0, sizeof(local_stats));
+        size_t local_solved = 0;
+        for (;;) {
+            size_t first = next_index.fetch_add(kChunkSize, std::memory_order_relaxed);
+            if (first >= n)
+                break;
+            size_t last = (first + kChunkSize < n) ? (first + kChunkSize) : n;
+            for (size_t i = first; i < last; i++) {
+                int result = solve_one(solver, in + i * stride, out + i * stride, flags,
+                                       (stats != nullptr) ? &local_stats : nullptr);
+                if (result == JM_SOLVED)
+                    local_solved++;
+                if (status != nullptr)
+                    status[i] = (uint8_t)result;
+            }
+        }
+        solved.fetch_add(local_solved, std::memory_order_relaxed);
+        if (stats != nullptr) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            add_stats(*stats, local_stats);
+        }
+    };
+
+    // The calling thread is one of the workers.
+    std::vector<std::thread> workers;
+    if (threads > 1) {
+        workers.reserve(threads - 1);
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back(worker);
+        }
+    }
+    worker();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    return solved.load();
+}
+
+} // extern "C"
@@ -0,0 +1,87 @@
+
+#ifndef JM_SUDOKU_LIB_H
+#define JM_SUDOKU_LIB_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+//
+// C ABI of libjmsudoku.
+//
+// A puzzle is 81 chars, '1' - '9' are the givens, '.' or '0' are the empty
+// cells. Every thread that calls the library keeps its own solver alive, the
+// static tables are initialized once by the first call.
+//
+#if defined(_WIN32) || defined(__CYGWIN__)
+  #if defined(JM_SUDOKU_BUILD_LIB)
+    #define JM_SUDOKU_API   __declspec(dllexport)
+  #else
+    #define JM_SUDOKU_API   __declspec(dllimport)
+  #endif
+#elif defined(__GNUC__) || defined(__clang__)
+  #define JM_SUDOKU_API     __attribute__((visibility("default")))
+#else
+  #define JM_SUDOKU_API
+#endif
+
+#define JM_SUDOKU_ABI_VERSION   1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum jm_status {
+    JM_SOLVED = 0,
+    JM_NO_SOLUTION = 1,
+    JM_MULTIPLE = 2,        // Only with JM_CHECK_UNIQUE
+    JM_INVALID = 3          // A char that is not a number or an empty cell
+};
+
+enum jm_flags {
+    JM_CHECK_UNIQUE = 0x0001
+};
+
+// The counters are added to, clear the struct before the first call.
+// The library doesn't count num_unique_candidate and num_failed_return,
+// they are kept for the ABI and stay 0.
+typedef struct jm_stats {
+    uint64_t    puzzles;
+    uint64_t    solved;
+    uint64_t    no_solution;
+    uint64_t    multiple;
+    uint64_t    invalid;
+    uint64_t    num_guesses;
+    uint64_t    num_unique_candidate;
+    uint64_t    num_failed_return;
+} jm_stats;
+
+typedef struct jm_opts {
+    uint32_t    threads;    // 0 or 1: the calling thread only
+    uint32_t    flags;      // jm_flags
+    uint8_t *   status;     // jm_status of every puzzle, may be NULL
+    jm_stats *  stats;      // May be NULL
+    void *      reserved[4];
+} jm_opts;
+
+JM_SUDOKU_API int jm_abi_version(void);
+
+// Returns jm_status, out may be the same as in.
+JM_SUDOKU_API int jm_solve(const char in[81], char out[81], jm_stats * stats);
+
+//
+// Solves n puzzles, the i-th puzzle is at in + i * stride and its answer is
+// written to out + i * stride (stride >= 81), so a text buffer of lines can
+// be solved in place. Returns the number of the solved puzzles.
+//
+JM_SUDOKU_API size_t jm_solve_batch(const char * in, size_t n, size_t stride,
+                                    char * out, const jm_opts * opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JM_SUDOKU_LIB_H
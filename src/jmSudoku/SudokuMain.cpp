@@ -38,7 +38,10 @@
 #include <fstream>
 #include <cstring>      // For std::memset()
 #include <vector>
+#include <string>
 #include <bitset>
+#include <random>
+#include <algorithm>     // For std::sort()
 
 #include "Sudoku.h"
 #include "TestCase.h"
@@ -47,6 +50,9 @@
 #include "SudokuSolver_dlx_v1.h"
 #include "SudokuSolver_dlx_v2.h"
 #include "SudokuSolver_dlx_v3.h"
+#include "SudokuSolver_dlx_v4.h"
+#include "SudokuSolver_dlx_v5.h"
+#include "SudokuSolver_dlx_units.h"
 
 #include "SudokuSolver_v1.h"
 #include "SudokuSolver_v2.h"
@@ -55,20 +61,66 @@
 #include "SudokuSolver_v3e.h"
 #include "SudokuSolver_v3.h"
 #include "SudokuSolver_v4.h"
+#include "SudokuSolver_units.h"
+
+#include "SudokuCanonical.h"
+#include "SudokuCache.h"
+#include "SudokuSession.h"
+#include "SudokuGenerator.h"
+#include "SudokuGrader.h"
+#include "SudokuStream.h"
+#include "SudokuBatch.h"
+#include "SudokuParallel.h"
+#include "SudokuPortfolio.h"
+#include "SudokuRouter.h"
+#include "SudokuVerify.h"
+#include "SudokuSink.h"
+#include "SudokuMinimal.h"
+#include "SudokuUnits.h"
 
 #include "CPUWarmUp.h"
 #include "StopWatch.h"
+#include "CacheCounter.h"
 
 using namespace jmSudoku;
 
 static const size_t kEnableDlxV1Solution =   1;
 static const size_t kEnableDlxV2Solution =   1;
 static const size_t kEnableDlxV3Solution =   1;
+static const size_t kEnableDlxV4Solution =   1;
+static const size_t kEnableDlxV5Solution =   1;
 
 static const size_t kEnableV1Solution =   1;
 static const size_t kEnableV2Solution =   1;
 static const size_t kEnableV3Solution =   1;
 
+// The benchmark suites, turn on the ones being worked on.
+static const size_t kEnableCacheTest =    0;
+static const size_t kEnableSessionTest =  0;
+static const size_t kEnableGeneratorTest = 0;
+static const size_t kEnableGraderTest =  0;
+static const size_t kEnableBatchTest =   0;
+static const size_t kEnableParallelTest = 0;
+static const size_t kEnablePortfolioTest = 0;
+static const size_t kEnableBudgetTest =   0;
+static const size_t kEnableRouterTest =   0;
+static const size_t kEnableCheckTest =    0;
+static const size_t kEnableInitBoardTest = 0;
+static const size_t kEnableLazySelectTest = 0;
+static const size_t kEnableTuningTest =   0;
+static const size_t kEnableStatsTest =    0;
+static const size_t kEnableEnumerateTest = 0;
+static const size_t kEnableMinimalTest =  0;
+static const size_t kEnableLayoutTest =   0;
+static const size_t kEnableCompactStateTest = 0;
+static const size_t kEnableBacktrackTest = 0;
+static const size_t kEnableDlxBitsetTest = 0;
+static const size_t kEnableDancingCellsTest = 0;
+static const size_t kEnableVariantTest =  0;
+
+// Verify every answer of run_sudoku_test() inline.
+static const size_t kEnableVerifyAnswers = 1;
+
 // Index: [0 - 4]
 #define TEST_CASE_INDEX         4
 
@@ -182,6 +234,22 @@ void run_a_testcase(size_t index)
         run_solver_testcase<dlx::v3::Solver<SudokuTy>>(index);
     }
 
+    if (kEnableDlxV4Solution)
+    {
+        printf("------------------------------------------\n\n");
+        printf("jmSudoku: dlx::v4::Solution - Algorithm X on bitsets\n\n");
+
+        run_solver_testcase<dlx::v4::Solver<SudokuTy>>(index);
+    }
+
+    if (kEnableDlxV5Solution)
+    {
+        printf("------------------------------------------\n\n");
+        printf("jmSudoku: dlx::v5::Solution - Dancing Cells\n\n");
+
+        run_solver_testcase<dlx::v5::Solver<SudokuTy>>(index);
+    }
+
     if (kEnableV1Solution)
     {
         printf("------------------------------------------\n\n");
@@ -247,7 +315,9 @@ void run_sudoku_test(const char * filename, const char * name)
 
     size_t puzzleCount = 0;
     size_t puzzleSolved = 0;
+    size_t wrongAnswers = 0;
     double total_time = 0.0;
+    double verify_time = 0.0;
 
     BasicSolver<SudokuTy> basicSolver;
 
@@ -270,6 +340,7 @@ void run_sudoku_test(const char * filename, const char * name)
                 size_t num_grids = read_sudoku_board<SudokuTy>(board, line);
                 // Sudoku::BoardSize = 81
                 if (num_grids >= SudokuTy::BoardSize) {
+                    Board puzzle = board;
                     sw.start();
                     bool success = solver.solve(board);
                     sw.stop();
@@ -277,6 +348,15 @@ void run_sudoku_test(const char * filename, const char * name)
                     double elapsed_time = sw.getElapsedMillisec();
                     total_time += elapsed_time;
                     if (success) {
+                        if (kEnableVerifyAnswers) {
+                            sw.start();
+                            bool is_correct = verify_solution(puzzle, board);
+                            sw.stop();
+                            verify_time += sw.getElapsedMillisec();
+                            if (!is_correct)
+                                wrongAnswers++;
+                        }
+
                         total_guesses += BasicSolverTy::num_guesses;
                         total_unique_candidate += BasicSolverTy::num_unique_candidate;
                         total_failed_return += BasicSolverTy::num_failed_return;
@@ -318,6 +398,11 @@ void run_sudoku_test(const char * filename, const char * name)
     printf("Total puzzle count = %u, puzzle solved = %u, total_no_guess: %" PRIuPTR ", no_guess %% = %0.1f %%\n\n",
            (uint32_t)puzzleCount, (uint32_t)puzzleSolved, total_no_guess, no_guess_percent);
     printf("Total elapsed time: %0.3f ms\n\n", total_time);
+    if (kEnableVerifyAnswers) {
+        printf("Inline verify: wrong answers = %u, verify time: %0.3f ms (%0.2f %% of the solve time)\n\n",
+               (uint32_t)wrongAnswers, verify_time,
+               (total_time != 0.0) ? (verify_time * 100.0 / total_time) : 0.0);
+    }
     printf("recur_counter: %" PRIuPTR "\n\n"
            "total_guesses: %" PRIuPTR ", total_failed_return: %" PRIuPTR ", total_unique_candidate: %" PRIuPTR "\n\n"
            "guess %% = %0.1f %%, failed_return %% = %0.1f %%, unique_candidate %% = %0.1f %%\n\n",
@@ -335,54 +420,2797 @@ void run_sudoku_test(const char * filename, const char * name)
     printf("------------------------------------------\n\n");
 }
 
-int main(int argc, char * argv[])
+template <typename SudokuTy = Sudoku>
+size_t load_sudoku_puzzles(const char * filename,
+                           std::vector<typename SudokuTy::board_type> & puzzles)
 {
-    const char * filename = nullptr;
-    const char * out_file = nullptr;
-    if (argc > 2) {
-        filename = argv[1];
-        out_file = argv[2];
+    typedef typename SudokuTy::board_type Board;
+
+    puzzles.clear();
+    std::ifstream ifs;
+    try {
+        ifs.open(filename, std::ios::in);
+        if (ifs.good()) {
+            while (!ifs.eof()) {
+                char line[256];
+                std::memset(line, 0, 16);
+                ifs.getline(line, sizeof(line) - 1);
+
+                Board board;
+                size_t num_grids = read_sudoku_board<SudokuTy>(board, line);
+                // Sudoku::BoardSize = 81
+                if (num_grids >= SudokuTy::BoardSize) {
+                    puzzles.push_back(board);
+                }
+            }
+            ifs.close();
+        }
     }
-    else if (argc > 1) {
-        filename = argv[1];
+    catch (std::exception & ex) {
+        std::cout << "Exception info: " << ex.what() << std::endl << std::endl;
     }
+    return puzzles.size();
+}
 
-    jtest::CPU::warmup(1000);
+template <typename SudokuSolver>
+void run_sudoku_cache_test(const char * filename, const char * name)
+{
+    typedef typename SudokuSolver::sudoku_t         SudokuTy;
+    typedef typename SudokuSolver::Board            Board;
 
-    Sudoku::initialize();
+    printf("jmSudoku: %s::Solver + SolutionCache\n\n", name);
 
-    v4::Solver<Sudoku> solver;
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
 
-    if (1)
-    {
-        if (filename == nullptr) {
-            run_a_testcase(TEST_CASE_INDEX);
+    SudokuSolver solver;
+    Canonicalizer<SudokuTy> canonicalizer;
+    SolutionCache<SudokuTy> cache;
+    std::mt19937 rng(20210816);
+
+    jtest::StopWatch sw;
+
+    // Pass 0: the original puzzles fill the cache,
+    // Pass 1: every puzzle is replaced by a random equivalent one.
+    for (size_t pass = 0; pass < 2; pass++) {
+        size_t hits = 0, puzzleSolved = 0, wrongAnswers = 0;
+        size_t total_visited = 0;
+        double canonical_time = 0.0, lookup_time = 0.0, solve_time = 0.0;
+
+        for (size_t i = 0; i < puzzleCount; i++) {
+            Board puzzle = puzzles[i];
+            if (pass != 0) {
+                Transform<SudokuTy> random_transform;
+                random_transform.random(rng);
+                random_transform.apply(puzzles[i], puzzle);
+            }
+
+            Board board = puzzle;
+            Board key, answer;
+            Transform<SudokuTy> transform;
+
+            sw.start();
+            total_visited += canonicalizer.canonicalize(board, key, transform);
+            sw.stop();
+            canonical_time += sw.getElapsedMillisec();
+
+            sw.start();
+            bool is_hit = cache.find(key, answer);
+            if (is_hit) {
+                transform.apply_inverse(answer, board);
+            }
+            sw.stop();
+            lookup_time += sw.getElapsedMillisec();
+
+            bool success = is_hit;
+            if (!is_hit) {
+                sw.start();
+                success = solver.solve(board);
+                sw.stop();
+                solve_time += sw.getElapsedMillisec();
+                if (success) {
+                    transform.apply(board, answer);
+                    cache.insert(key, answer);
+                }
+            }
+
+            if (success) {
+                hits += is_hit ? 1 : 0;
+                puzzleSolved++;
+                if (!verify_solution(puzzle, board))
+                    wrongAnswers++;
+            }
+        }
+
+        double total_time = canonical_time + lookup_time + solve_time;
+        printf("Pass #%u (%s puzzles): puzzle count = %u, puzzle solved = %u, wrong answers = %u\n\n",
+               (uint32_t)(pass + 1), (pass == 0) ? "original" : "transformed",
+               (uint32_t)puzzleCount, (uint32_t)puzzleSolved, (uint32_t)wrongAnswers);
+        printf("cache hits = %u, hit rate = %0.1f %%, cache size = %u\n\n",
+               (uint32_t)hits, calc_percent(hits, puzzleCount), (uint32_t)cache.size());
+        printf("Total elapsed time: %0.3f ms (canonical: %0.3f ms, lookup: %0.3f ms, solve: %0.3f ms)\n\n",
+               total_time, canonical_time, lookup_time, solve_time);
+        if (puzzleCount != 0) {
+            printf("%0.1f usec/puzzle, %0.2f usec/canonical, %0.1f transforms/canonical, %0.1f puzzles/sec\n\n",
+                   total_time * 1000.0 / puzzleCount,
+                   canonical_time * 1000.0 / puzzleCount,
+                   (double)total_visited / puzzleCount,
+                   puzzleCount / (total_time / 1000.0));
         }
     }
 
-    if (0)
-    {
-        if (filename != nullptr) {
-#ifdef NDEBUG
-            run_sudoku_test<dlx::v1::Solver<Sudoku>>(filename, "dlx::v1");
-            run_sudoku_test<dlx::v2::Solver<Sudoku>>(filename, "dlx::v2");
-#endif
-            run_sudoku_test<dlx::v3::Solver<Sudoku>>(filename, "dlx::v3");
+    printf("Total cache hit rate = %0.1f %%\n\n", cache.hit_rate());
+    printf("------------------------------------------\n\n");
+}
 
-            run_sudoku_test<v1::Solver<Sudoku>>(filename, "dfs::v1");
-            run_sudoku_test<v2::Solver<Sudoku>>(filename, "dfs::v2");
-            run_sudoku_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
-            run_sudoku_test<v3b::Solver<Sudoku>>(filename, "dfs::v3b");
-            run_sudoku_test<v3e::Solver<Sudoku>>(filename, "dfs::v3e");
-            run_sudoku_test<v3::Solver<Sudoku>>(filename, "dfs::v3");
+//
+// Replays a random edit script on every puzzle: the empty cells are filled in
+// a random order, now and then a wrong number is placed, checked and erased.
+// Pass 0 only edits the v3::Session, pass 1 also asks is_still_solvable()
+// after every edit, pass 2 re-solves the whole board after every edit.
+//
+template <typename SudokuSolver>
+void run_sudoku_session_test(const char * filename, const char * name, size_t maxPuzzles = 5000)
+{
+    typedef typename SudokuSolver::sudoku_t         SudokuTy;
+    typedef typename SudokuSolver::Board            Board;
+
+    static const char * pass_names[3] = { "Session edit only", "Session + check  ", "Re-solve         " };
+
+    printf("jmSudoku: v3::Session vs %s::Solver re-solve\n\n", name);
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > maxPuzzles)
+        puzzles.resize(maxPuzzles);
+    size_t puzzleCount = puzzles.size();
+
+    SudokuSolver solver;
+    std::vector<Board> solutions(puzzleCount);
+    for (size_t i = 0; i < puzzleCount; i++) {
+        solutions[i] = puzzles[i];
+        solver.solve(solutions[i]);
+    }
+
+    v3::Session<SudokuTy> session;
+    std::vector<char> results[3];
+    size_t total_edits[3] = { 0, 0, 0 };
+    double total_time[3] = { 0.0, 0.0, 0.0 };
+    size_t bad_hints = 0, total_hints = 0;
+
+    jtest::StopWatch sw;
+    for (size_t pass = 0; pass < 3; pass++) {
+        results[pass].reserve(puzzleCount * 128);
+        sw.start();
+        for (size_t i = 0; i < puzzleCount; i++) {
+            const Board & solution = solutions[i];
+            Board board = puzzles[i];
+            if (pass != 2) {
+                session.load(puzzles[i]);
+            }
+
+            uint8_t empties[SudokuTy::BoardSize];
+            size_t empty_count = 0;
+            for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+                if (board.cells[pos] == '.')
+                    empties[empty_count++] = (uint8_t)pos;
+            }
+
+            std::mt19937 rng((uint32_t)i);
+            std::shuffle(&empties[0], &empties[empty_count], rng);
+
+            for (size_t n = 0; n < empty_count; n++) {
+                size_t pos = empties[n];
+                size_t answer = (size_t)(solution.cells[pos] - '0');
+                if ((rng() % 4) == 0) {
+                    size_t wrong = (answer + 1 + rng() % (SudokuTy::Numbers - 1) - 1) % SudokuTy::Numbers + 1;
+                    bool solvable = false;
+                    if (pass != 2) {
+                        session.place(pos, wrong);
+                        if (pass == 1)
+                            solvable = session.is_still_solvable();
+                        session.erase(pos);
+                    }
+                    else {
+                        // A wrong number that repeats a given is rejected by the input
+                        // check of solve(), any other one fails in the search.
+                        Board input = board;
+                        input.cells[pos] = (char)(wrong + '0');
+                        Board temp = input;
+                        solvable = solver.solve(temp) && verify_solution(input, temp);
+                    }
+                    results[pass].push_back(solvable ? 1 : 0);
+                    total_edits[pass] += 2;
+                }
+
+                if (pass == 1 && (n % 8) == 0) {
+                    size_t hint_pos, hint_num;
+                    if (session.hint(hint_pos, hint_num)) {
+                        total_hints++;
+                        if (solution.cells[hint_pos] != (char)(hint_num + '0'))
+                            bad_hints++;
+                    }
+                }
+
+                bool solvable = false;
+                if (pass != 2) {
+                    session.place(pos, answer);
+                    if (pass == 1)
+                        solvable = session.is_still_solvable();
+                }
+                else {
+                    board.cells[pos] = (char)(answer + '0');
+                    Board temp = board;
+                    solvable = solver.solve(temp) && verify_solution(board, temp);
+                }
+                results[pass].push_back(solvable ? 1 : 0);
+                total_edits[pass]++;
+            }
         }
+        sw.stop();
+        total_time[pass] = sw.getElapsedMillisec();
     }
-    else
-    {
-        if (filename != nullptr) {
-            run_sudoku_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
-            run_sudoku_test<v3b::Solver<Sudoku>>(filename, "dfs::v3b");
-            run_sudoku_test<v3::Solver<Sudoku>, true>(filename, "dfs::v3");
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < results[1].size(); i++) {
+        if (i >= results[2].size() || results[1][i] != results[2][i])
+            mismatches++;
+    }
+
+    printf("Total puzzle count = %u, edits = %u, mismatches = %u, hints = %u, bad hints = %u\n\n",
+           (uint32_t)puzzleCount, (uint32_t)total_edits[1], (uint32_t)mismatches,
+           (uint32_t)total_hints, (uint32_t)bad_hints);
+    for (size_t pass = 0; pass < 3; pass++) {
+        printf("%s: total elapsed time: %0.3f ms, %0.1f nsec/edit\n\n",
+               pass_names[pass], total_time[pass],
+               (total_edits[pass] != 0) ? (total_time[pass] * 1000000.0 / total_edits[pass]) : 0.0);
+    }
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// Generates puzzles for every clue band (the minimal puzzles, then some
+// target clue counts), reports puzzles/sec and the number of guesses
+// the v3 solver needs for them. The uniqueness is checked by dlx::v3, not
+// by the solver of the generator. The minimal puzzles are written to out_file.
+//
+template <typename SudokuSolver>
+void run_sudoku_generator_test(const char * out_file, const char * name,
+                               size_t threads = 0, bool is_binary = false)
+{
+    typedef typename SudokuSolver::sudoku_t                 SudokuTy;
+    typedef typename SudokuSolver::Board                    Board;
+    typedef Generator<SudokuTy, SudokuSolver>               generator_t;
+    typedef typename generator_t::Options                   Options;
+    typedef typename generator_t::Stats                     Stats;
+    typedef BasicSolver<SudokuTy>                           BasicSolverTy;
+
+    struct Band {
+        const char *    name;
+        size_t          target_clues;
+        size_t          count;
+    };
+
+    static const Band bands[] = {
+        { "minimal ", 0,  2000 },
+        { "<= 25   ", 25, 1000 },
+        { "<= 23   ", 23, 200  },
+        { "<= 22   ", 22, 50   },
+        { "<= 21   ", 21, 10   },
+    };
+
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+    }
+
+    printf("jmSudoku: Generator + %s::Solver, threads = %u\n\n", name, (uint32_t)threads);
+
+    jtest::StopWatch sw;
+    for (size_t i = 0; i < sizeof(bands) / sizeof(bands[0]); i++) {
+        const Band & band = bands[i];
+        Options options(band.target_clues, 256);
+        Stats stats;
+        std::vector<Board> puzzles;
+
+        sw.start();
+        size_t generated = generate_puzzles<SudokuTy, SudokuSolver>(puzzles, band.count, options,
+                                                                    threads, (uint32_t)(i + 1), &stats);
+        sw.stop();
+        double elapsed_time = sw.getElapsedMillisec();
+
+        // Check the puzzles, the guesses of the solver grade their difficulty.
+        SudokuSolver solver;
+        dlx::v3::Solver<SudokuTy> checker;
+        size_t total_clues = 0, not_unique = 0;
+        size_t no_guess = 0, total_guesses = 0;
+        for (size_t n = 0; n < generated; n++) {
+            total_clues += generator_t::count_clues(puzzles[n]);
+            if (checker.count_solutions(puzzles[n]) != 1)
+                not_unique++;
+            Board board = puzzles[n];
+            solver.template search<SearchMode::OneAnswer>(board);
+            total_guesses += BasicSolverTy::num_guesses;
+            if (BasicSolverTy::num_guesses == 0)
+                no_guess++;
+        }
+
+        printf("Clues %s: generated = %u / %u, not unique = %u, avg clues = %0.2f, "
+               "no guess = %0.1f %%, avg guesses = %0.1f\n",
+               band.name, (uint32_t)generated, (uint32_t)band.count, (uint32_t)not_unique,
+               (generated != 0) ? ((double)total_clues / generated) : 0.0,
+               calc_percent(no_guess, generated),
+               (generated != 0) ? ((double)total_guesses / generated) : 0.0);
+        printf("                full grids = %u, searches = %u, forced cells = %u, failed attempts = %u\n",
+               (uint32_t)stats.full_grids, (uint32_t)stats.searches,
+               (uint32_t)stats.forced_cells, (uint32_t)stats.failed_attempts);
+        printf("                elapsed time: %0.3f ms, %0.1f puzzles/sec\n\n",
+               elapsed_time, (elapsed_time != 0.0) ? (generated / (elapsed_time / 1000.0)) : 0.0);
+
+        if (band.target_clues == 0 && out_file != nullptr) {
+            if (write_puzzles<SudokuTy>(out_file, puzzles, is_binary))
+                printf("%u puzzles written to %s\n\n", (uint32_t)generated, out_file);
+            else
+                printf("Can't write the puzzles to %s\n\n", out_file);
+        }
+    }
+
+    printf("------------------------------------------\n\n");
+}
+
+template <typename SudokuTy>
+void display_grade_result(const typename Grader<SudokuTy>::Result & result, size_t index)
+{
+    typedef Grader<SudokuTy> grader_t;
+
+    printf("#%u: rating = %0.1f (%s), hardest = %s, steps = {", (uint32_t)(index + 1),
+           result.rating, grader_t::rating_band(result.rating),
+           grader_t::technique_name(result.hardest));
+    bool is_first = true;
+    for (size_t technique = 0; technique < TechniqueLast; technique++) {
+        if (result.steps[technique] != 0) {
+            printf("%s %s: %u", is_first ? "" : ",", grader_t::technique_name(technique),
+                   (uint32_t)result.steps[technique]);
+            is_first = false;
+        }
+    }
+    printf(" }\n");
+}
+
+template <typename SudokuTy>
+void run_sudoku_grader_test(const char * filename, size_t threads = 0)
+{
+    typedef typename SudokuTy::board_type       Board;
+    typedef Grader<SudokuTy>                    grader_t;
+    typedef typename grader_t::Result           Result;
+
+    static const size_t kDisplayResults = 5;
+
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+    }
+
+    printf("jmSudoku: Grader, threads = %u\n\n", (uint32_t)threads);
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    std::vector<Board> solutions;
+    std::vector<Result> results;
+
+    jtest::StopWatch sw;
+    sw.start();
+    size_t puzzleSolved = grade_puzzles<SudokuTy>(puzzles, solutions, results, threads);
+    sw.stop();
+    double elapsed_time = sw.getElapsedMillisec();
+
+    size_t wrongAnswers = 0;
+    size_t total_steps[TechniqueLast] = { 0 };
+    size_t hardest_count[TechniqueLast] = { 0 };
+    for (size_t i = 0; i < puzzleCount; i++) {
+        const Result & result = results[i];
+        if (!result.solved)
+            continue;
+        if (!verify_solution(puzzles[i], solutions[i]))
+            wrongAnswers++;
+        for (size_t technique = 0; technique < TechniqueLast; technique++) {
+            total_steps[technique] += result.steps[technique];
+        }
+        hardest_count[result.hardest]++;
+    }
+
+    for (size_t i = 0; i < puzzleCount && i < kDisplayResults; i++) {
+        display_grade_result<SudokuTy>(results[i], i);
+    }
+    printf("\n");
+
+    printf("Technique            Steps      Hardest in\n");
+    for (size_t technique = 0; technique < TechniqueLast; technique++) {
+        printf("%-18s %9u %9u (%0.1f %%)\n", grader_t::technique_name(technique),
+               (uint32_t)total_steps[technique], (uint32_t)hardest_count[technique],
+               calc_percent(hardest_count[technique], puzzleSolved));
+    }
+    printf("\n");
+
+    printf("Total puzzle count = %u, puzzle solved = %u, wrong answers = %u\n\n",
+           (uint32_t)puzzleCount, (uint32_t)puzzleSolved, (uint32_t)wrongAnswers);
+    printf("Total elapsed time: %0.3f ms\n\n", elapsed_time);
+    if (puzzleCount != 0) {
+        printf("%0.1f usec/puzzle, %0.1f puzzles/sec\n\n",
+               elapsed_time * 1000.0 / puzzleCount, puzzleCount / (elapsed_time / 1000.0));
+    }
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The throughput of verify_solution() and of verify_solution_scalar() on the
+// answers of a batch. A quarter of the answers is kept, the others are broken
+// (two cells of a row swapped, a cell that is not a number, a cell changed),
+// both verifiers have to agree on every one.
+//
+template <typename SudokuTy>
+void run_sudoku_verify_test(const std::vector<typename SudokuTy::board_type> & puzzles,
+                            const std::vector<typename SudokuTy::board_type> & answers,
+                            size_t repeats = 20)
+{
+    typedef typename SudokuTy::board_type   Board;
+
+    size_t count = answers.size();
+    std::vector<Board> tests = answers;
+    for (size_t i = 0; i < count; i++) {
+        Board & test = tests[i];
+        size_t pos = (i * 7) % SudokuTy::BoardSize;
+        switch (i % 4) {
+            case 0: {
+                size_t pos2 = (pos % SudokuTy::Cols == SudokuTy::Cols - 1) ? (pos - 1) : (pos + 1);
+                std::swap(test.cells[pos], test.cells[pos2]);
+                break;
+            }
+            case 1:
+                test.cells[pos] = '0';
+                break;
+            case 2:
+                test.cells[pos] = (char)((test.cells[pos] - '1' + 1) % 9 + '1');
+                break;
+            default:
+                break;
+        }
+    }
+
+    std::vector<uint8_t> results(count), results_scalar(count);
+    jtest::StopWatch sw;
+
+    size_t correct = 0;
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        correct = verify_solutions(puzzles.data(), tests.data(), count, results.data());
+    }
+    sw.stop();
+    double simd_time = sw.getElapsedMillisec();
+
+    size_t correct_scalar = 0;
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        correct_scalar = 0;
+        for (size_t i = 0; i < count; i++) {
+            results_scalar[i] = verify_solution_scalar(puzzles[i], tests[i]) ? 1 : 0;
+            correct_scalar += results_scalar[i];
+        }
+    }
+    sw.stop();
+    double scalar_time = sw.getElapsedMillisec();
+
+    size_t disagreements = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (results[i] != results_scalar[i])
+            disagreements++;
+    }
+
+    size_t total = count * repeats;
+    printf("Verify %u answers x %u: correct = %u (scalar: %u), disagreements = %u\n",
+           (uint32_t)count, (uint32_t)repeats, (uint32_t)correct, (uint32_t)correct_scalar,
+           (uint32_t)disagreements);
+    printf("simd: %0.2f ns/grid, %0.1f M grids/sec, scalar: %0.2f ns/grid, %0.1f M grids/sec\n\n",
+           (total != 0) ? (simd_time * 1000000.0 / total) : 0.0,
+           (simd_time != 0.0) ? (total / simd_time / 1000.0) : 0.0,
+           (total != 0) ? (scalar_time * 1000000.0 / total) : 0.0,
+           (scalar_time != 0.0) ? (total / scalar_time / 1000.0) : 0.0);
+}
+
+//
+// Solves the file with the static and the work-stealing schedules,
+// reports the busy and idle time of every thread.
+//
+template <typename SudokuSolver>
+void run_sudoku_batch_test(const char * filename, const char * name, size_t threads = 0)
+{
+    typedef typename SudokuSolver::sudoku_t             SudokuTy;
+    typedef typename SudokuSolver::Board                Board;
+    typedef BatchRunner<SudokuSolver>                   batch_runner_t;
+    typedef typename batch_runner_t::ThreadStats        ThreadStats;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    batch_runner_t runner(threads);
+    printf("jmSudoku: BatchRunner + %s::Solver, threads = %u\n\n", name, (uint32_t)runner.threads());
+
+    std::vector<Board> answers[batch_runner_t::ScheduleLast];
+    std::vector<uint8_t> solved;
+    for (size_t schedule = 0; schedule < batch_runner_t::ScheduleLast; schedule++) {
+        size_t puzzleSolved = runner.run(puzzles, answers[schedule], solved,
+                                         (typename batch_runner_t::Schedule)schedule);
+        size_t wrongAnswers = 0;
+        for (size_t i = 0; i < puzzleCount; i++) {
+            if (solved[i] && !verify_solution(puzzles[i], answers[schedule][i]))
+                wrongAnswers++;
+        }
+
+        printf("Schedule: %s, puzzle solved = %u / %u, rejected = %u, wrong answers = %u, elapsed time: %0.3f ms\n\n",
+               batch_runner_t::schedule_name(schedule), (uint32_t)puzzleSolved, (uint32_t)puzzleCount,
+               (uint32_t)(puzzleCount - runner.check_count(BoardCheck::BoardValid)),
+               (uint32_t)wrongAnswers, runner.elapsed_time());
+
+        const std::vector<ThreadStats> & thread_stats = runner.thread_stats();
+        double max_busy = 0.0, total_busy = 0.0, total_idle = 0.0;
+        printf("Thread   Puzzles   Chunks   Steals    Busy (ms)    Idle (ms)\n");
+        for (size_t i = 0; i < thread_stats.size(); i++) {
+            const ThreadStats & stats = thread_stats[i];
+            printf("%6u %9u %8u %8u %12.3f %12.3f\n", (uint32_t)i,
+                   (uint32_t)stats.puzzles, (uint32_t)stats.chunks, (uint32_t)stats.steals,
+                   stats.busy_time, stats.idle_time);
+            total_busy += stats.busy_time;
+            total_idle += stats.idle_time;
+            if (stats.busy_time > max_busy)
+                max_busy = stats.busy_time;
+        }
+        double avg_busy = (thread_stats.size() != 0) ? (total_busy / thread_stats.size()) : 0.0;
+        printf("\nmax busy / avg busy = %0.3f, idle = %0.1f %% of the thread time\n\n",
+               (avg_busy != 0.0) ? (max_busy / avg_busy) : 0.0,
+               (total_busy + total_idle != 0.0) ? (total_idle * 100.0 / (total_busy + total_idle)) : 0.0);
+    }
+
+    size_t differences = 0;
+    for (size_t i = 0; i < puzzleCount; i++) {
+        if (std::memcmp(answers[0][i].cells, answers[1][i].cells, SudokuTy::BoardSize) != 0)
+            differences++;
+    }
+    printf("Answers that differ between the schedules: %u\n\n", (uint32_t)differences);
+
+    run_sudoku_verify_test<SudokuTy>(puzzles, answers[batch_runner_t::WorkStealing]);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// One answer: the hardest puzzles of the file (by the guesses of the v3
+// solver), solved by the v3 solver and by the ParallelSearch.
+// All answers: the first puzzles with some givens removed, the answers are
+// counted by the v3 solver and by the ParallelSearch.
+//
+template <typename SudokuTy>
+void run_sudoku_parallel_test(const char * filename, size_t threads = 0,
+                              size_t hardPuzzles = 20, size_t countPuzzles = 5,
+                              size_t removedClues = 1)
+{
+    typedef typename SudokuTy::board_type               Board;
+    typedef v3::Solver<SudokuTy>                        SolverTy;
+    typedef BasicSolver<SudokuTy>                       BasicSolverTy;
+    typedef ParallelSearch<SudokuTy>                    parallel_search_t;
+    typedef typename parallel_search_t::Stats           Stats;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    SolverTy solver;
+    parallel_search_t parallel(threads);
+    printf("jmSudoku: ParallelSearch + dfs::v3::Solver, threads = %u\n\n", (uint32_t)parallel.threads());
+
+    // Pick the hardest puzzles.
+    std::vector<std::pair<size_t, size_t>> guesses(puzzleCount);
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        solver.template search<SearchMode::OneAnswer>(board);
+        guesses[i] = std::make_pair(BasicSolverTy::num_guesses, i);
+    }
+    std::sort(guesses.begin(), guesses.end(),
+              [](const std::pair<size_t, size_t> & lhs, const std::pair<size_t, size_t> & rhs) {
+                  return (lhs.first > rhs.first);
+              });
+    if (hardPuzzles > puzzleCount)
+        hardPuzzles = puzzleCount;
+
+    jtest::StopWatch sw;
+    double serial_time = 0.0, parallel_time = 0.0;
+    size_t wrongAnswers = 0, total_subproblems = 0, total_skipped = 0;
+    for (size_t n = 0; n < hardPuzzles; n++) {
+        const Board & puzzle = puzzles[guesses[n].second];
+        Board board = puzzle;
+        sw.start();
+        solver.template search<SearchMode::OneAnswer>(board);
+        sw.stop();
+        serial_time += sw.getElapsedMillisec();
+
+        Board board2 = puzzle;
+        sw.start();
+        size_t answers = parallel.template search<SearchMode::OneAnswer>(board2);
+        sw.stop();
+        parallel_time += sw.getElapsedMillisec();
+
+        const Stats & stats = parallel.stats();
+        total_subproblems += stats.subproblems;
+        total_skipped += stats.skipped;
+        if (answers != 1 || !verify_solution(puzzle, board2))
+            wrongAnswers++;
+    }
+    printf("One answer: %u hardest puzzles (%u - %u guesses), wrong answers = %u\n",
+           (uint32_t)hardPuzzles, (uint32_t)guesses[0].first,
+           (uint32_t)guesses[(hardPuzzles != 0) ? (hardPuzzles - 1) : 0].first, (uint32_t)wrongAnswers);
+    printf("serial: %0.3f ms, parallel: %0.3f ms, subproblems = %u, skipped after the stop = %u\n\n",
+           serial_time, parallel_time, (uint32_t)total_subproblems, (uint32_t)total_skipped);
+
+    // Count all the answers of the puzzles with removed givens.
+    if (countPuzzles > puzzleCount)
+        countPuzzles = puzzleCount;
+    size_t mismatches = 0, total_answers = 0;
+    serial_time = 0.0;
+    parallel_time = 0.0;
+    for (size_t n = 0; n < countPuzzles; n++) {
+        Board puzzle = puzzles[n];
+        size_t removed = 0;
+        for (size_t pos = 0; pos < SudokuTy::BoardSize && removed < removedClues; pos++) {
+            if (puzzle.cells[pos] != '.') {
+                puzzle.cells[pos] = '.';
+                removed++;
+            }
+        }
+
+        Board board = puzzle;
+        sw.start();
+        size_t answers = solver.template search<SearchMode::AllAnswers>(board);
+        sw.stop();
+        serial_time += sw.getElapsedMillisec();
+
+        Board board2 = puzzle;
+        sw.start();
+        size_t answers2 = parallel.template search<SearchMode::AllAnswers>(board2);
+        sw.stop();
+        parallel_time += sw.getElapsedMillisec();
+
+        total_answers += answers;
+        if (answers != answers2)
+            mismatches++;
+    }
+    printf("All answers: %u puzzles with %u givens removed, answers = %u, mismatches = %u\n",
+           (uint32_t)countPuzzles, (uint32_t)removedClues, (uint32_t)total_answers, (uint32_t)mismatches);
+    printf("serial: %0.3f ms, parallel: %0.3f ms\n\n", serial_time, parallel_time);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// All the answers of the first puzzles with some givens removed: kept in
+// the answers() vector by search<AllAnswers>, and streamed by enumerate()
+// into an AnswerSink on a MappedFile. The lines of the file must be the
+// answers of the vector in the same order. Then a visitor stops the
+// enumeration after stopAfter answers.
+//
+template <typename SudokuTy>
+void run_sudoku_enumerate_test(const char * filename, size_t countPuzzles = 5,
+                               size_t removedClues = 1, size_t stopAfter = 1000)
+{
+    typedef typename SudokuTy::board_type               Board;
+    typedef v3::Solver<SudokuTy>                        SolverTy;
+    typedef AnswerSink<SudokuTy>                        answer_sink_t;
+
+    static const char * kOutputFile = "enumerate_output.txt";
+    static const size_t kOutputCapacity = size_t(256) * 1024 * 1024;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (countPuzzles > puzzles.size())
+        countPuzzles = puzzles.size();
+
+    SolverTy solver;
+    printf("jmSudoku: dfs::v3::Solver, all answers by search() and by enumerate()\n\n");
+
+    jtest::StopWatch sw;
+    double vector_time = 0.0, sink_time = 0.0;
+    size_t total_answers = 0, max_vector_bytes = 0, max_file_bytes = 0;
+    size_t mismatches = 0, truncated = 0, early_stops = 0;
+    for (size_t n = 0; n < countPuzzles; n++) {
+        Board puzzle = puzzles[n];
+        size_t removed = 0;
+        for (size_t pos = 0; pos < SudokuTy::BoardSize && removed < removedClues; pos++) {
+            if (puzzle.cells[pos] != '.') {
+                puzzle.cells[pos] = '.';
+                removed++;
+            }
+        }
+
+        Board board = puzzle;
+        sw.start();
+        size_t answers = solver.template search<SearchMode::AllAnswers>(board);
+        sw.stop();
+        vector_time += sw.getElapsedMillisec();
+        total_answers += answers;
+        size_t vector_bytes = solver.answers().capacity() * sizeof(Board);
+        if (vector_bytes > max_vector_bytes)
+            max_vector_bytes = vector_bytes;
+
+        MappedFile output;
+        if (!output.create(kOutputFile, kOutputCapacity)) {
+            printf("Can't map the output file %s\n\n", kOutputFile);
+            return;
+        }
+        answer_sink_t sink(output.data(), output.capacity());
+        sw.start();
+        size_t streamed = solver.enumerate(puzzle, sink);
+        sw.stop();
+        sink_time += sw.getElapsedMillisec();
+        if (sink.size() > max_file_bytes)
+            max_file_bytes = sink.size();
+
+        if (sink.is_full()) {
+            truncated++;
+        }
+        else if (streamed != answers || sink.answers() != answers) {
+            mismatches++;
+        }
+        else {
+            const std::vector<Board> & answer_list = solver.answers();
+            for (size_t i = 0; i < answers; i++) {
+                const char * line = output.data() + i * answer_sink_t::kLineSize;
+                if (std::memcmp(line, &answer_list[i].cells[0], SudokuTy::BoardSize) != 0 ||
+                    line[SudokuTy::BoardSize] != '\n') {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+        output.close(sink.size());
+
+        size_t visited = 0;
+        auto stop_visitor = [&visited, stopAfter](const Board & answer) -> bool {
+            (void)answer;
+            return (++visited < stopAfter);
+        };
+        size_t stopped = solver.enumerate(puzzle, stop_visitor);
+        if (stopped == ((answers < stopAfter) ? answers : stopAfter))
+            early_stops++;
+    }
+    std::remove(kOutputFile);
+
+    printf("%u puzzles with %u givens removed, answers = %u, mismatches = %u, truncated = %u\n",
+           (uint32_t)countPuzzles, (uint32_t)removedClues, (uint32_t)total_answers,
+           (uint32_t)mismatches, (uint32_t)truncated);
+    printf("search():    %9.3f ms, answers() vector: %8.2f MB at most\n",
+           vector_time, (double)max_vector_bytes / (1024.0 * 1024.0));
+    printf("enumerate(): %9.3f ms, mapped file:      %8.2f MB at most, no heap per answer\n",
+           sink_time, (double)max_file_bytes / (1024.0 * 1024.0));
+    printf("Stopped by the visitor after %u answers: %u / %u puzzles\n\n",
+           (uint32_t)stopAfter, (uint32_t)early_stops, (uint32_t)countPuzzles);
+
+    printf("------------------------------------------\n\n");
+}
+
+// The naive minimality check: a uniqueness search without every clue.
+template <typename SudokuSolver>
+static bool is_minimal_naive(SudokuSolver & solver, const typename SudokuSolver::Board & puzzle)
+{
+    typedef typename SudokuSolver::Board Board;
+    if (solver.count_solutions(puzzle) != 1)
+        return false;
+    Board board = puzzle;
+    for (size_t pos = 0; pos < SudokuSolver::BoardSize; pos++) {
+        char val = board.cells[pos];
+        if (val != '.') {
+            board.cells[pos] = '.';
+            if (solver.count_solutions(board) == 1)
+                return false;
+            board.cells[pos] = val;
+        }
+    }
+    return true;
+}
+
+//
+// The minimality check of the puzzles of the file (which are all minimal
+// if they have 17 clues), and of the same puzzles with one more clue from
+// their solution (which are never minimal): the naive check, the
+// MinimalChecker on one thread and on the given threads.
+//
+template <typename SudokuTy>
+void run_sudoku_minimal_test(const char * filename, size_t max_puzzles = 4096, size_t threads = 2)
+{
+    typedef typename SudokuTy::board_type               Board;
+    typedef v3::Solver<SudokuTy>                        SolverTy;
+    typedef v3::MinimalChecker<SudokuTy>                checker_t;
+
+    static const size_t kMethods = 3;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    SolverTy solver;
+
+    // The puzzles with one more clue, from the solution.
+    std::vector<Board> extended(puzzleCount);
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        extended[i] = puzzles[i];
+        if (solver.template search<SearchMode::OneAnswer>(board) != 0) {
+            for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+                if (extended[i].cells[pos] == '.') {
+                    extended[i].cells[pos] = board.cells[pos];
+                    break;
+                }
+            }
+        }
+    }
+
+    checker_t checker(1);
+    checker_t parallel_checker(threads);
+    printf("jmSudoku: minimality check, %u puzzles, MinimalChecker threads = 1 and %u\n\n",
+           (uint32_t)puzzleCount, (uint32_t)parallel_checker.threads());
+
+    static const char * method_names[kMethods] = { "naive", "incremental", "parallel" };
+    jtest::StopWatch sw;
+    for (size_t set = 0; set < 2; set++) {
+        const std::vector<Board> & boards = (set == 0) ? puzzles : extended;
+        size_t minimal[kMethods] = { 0, 0, 0 };
+        double elapsed_time[kMethods] = { 0.0, 0.0, 0.0 };
+        std::vector<uint8_t> results(puzzleCount * kMethods);
+        checker.reset_stats();
+        for (size_t method = 0; method < kMethods; method++) {
+            sw.start();
+            for (size_t i = 0; i < puzzleCount; i++) {
+                bool is_minimal;
+                if (method == 0)
+                    is_minimal = is_minimal_naive(solver, boards[i]);
+                else if (method == 1)
+                    is_minimal = checker.is_minimal(boards[i]);
+                else
+                    is_minimal = parallel_checker.is_minimal(boards[i]);
+                results[i * kMethods + method] = is_minimal ? 1 : 0;
+                minimal[method] += is_minimal ? 1 : 0;
+            }
+            sw.stop();
+            elapsed_time[method] = sw.getElapsedMillisec();
+        }
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < puzzleCount; i++) {
+            if (results[i * kMethods + 1] != results[i * kMethods] ||
+                results[i * kMethods + 2] != results[i * kMethods])
+                mismatches++;
+        }
+
+        printf("%s:\n", (set == 0) ? "The puzzles" : "The puzzles with one more clue");
+        for (size_t method = 0; method < kMethods; method++) {
+            printf("%-12s minimal: %6u, %9.3f ms, %10.1f puzzles/s\n", method_names[method],
+                   (uint32_t)minimal[method], elapsed_time[method],
+                   (elapsed_time[method] != 0.0) ? (puzzleCount * 1000.0 / elapsed_time[method]) : 0.0);
+        }
+        const typename checker_t::Stats & stats = checker.stats();
+        printf("mismatches = %u, incremental: %0.1f placements, %0.1f searches per puzzle\n\n",
+               (uint32_t)mismatches,
+               (puzzleCount != 0) ? ((double)stats.placements / puzzleCount) : 0.0,
+               (puzzleCount != 0) ? ((double)stats.searches / puzzleCount) : 0.0);
+    }
+
+    printf("------------------------------------------\n\n");
+}
+
+// The latency of the percent-th percentile, the latencies are sorted.
+static double latency_percentile(const std::vector<double> & latencies, double percent)
+{
+    if (latencies.empty())
+        return 0.0;
+    size_t index = (size_t)(percent / 100.0 * (double)(latencies.size() - 1) + 0.5);
+    return latencies[index];
+}
+
+static void display_latency(const char * name, std::vector<double> & latencies)
+{
+    double total_time = 0.0;
+    for (size_t i = 0; i < latencies.size(); i++) {
+        total_time += latencies[i];
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-10s %9.3f  %7.2f  %7.2f  %7.2f  %8.2f  %8.2f\n",
+           name, total_time / 1000.0,
+           latency_percentile(latencies, 50.0), latency_percentile(latencies, 99.0),
+           latency_percentile(latencies, 99.9), latency_percentile(latencies, 100.0),
+           (latencies.size() != 0) ? (total_time / latencies.size()) : 0.0);
+}
+
+//
+// The latency of every puzzle (usec) for the v3 solver, the dlx::v3 solver
+// and the Portfolio of them, with the tail percentiles.
+//
+template <typename SudokuTy>
+void run_sudoku_portfolio_test(const char * filename, size_t maxGuesses = 0)
+{
+    typedef typename SudokuTy::board_type               Board;
+    typedef v3::Solver<SudokuTy>                        SolverTy;
+    typedef dlx::v3::Solver<SudokuTy>                   RacerTy;
+    typedef Portfolio<SudokuTy>                         portfolio_t;
+    typedef typename portfolio_t::Stats                 Stats;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    SolverTy solver;
+    RacerTy racer;
+    portfolio_t portfolio(maxGuesses);
+    printf("jmSudoku: Portfolio of dfs::v3 and dlx::v3, max guesses of v3 = %u\n\n",
+           (uint32_t)portfolio.max_guesses());
+
+    std::vector<double> latencies[3];
+    for (size_t i = 0; i < 3; i++) {
+        latencies[i].resize(puzzleCount);
+    }
+
+    jtest::StopWatch sw;
+    size_t wrongAnswers[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        sw.start();
+        size_t answers = solver.template search<SearchMode::OneAnswer>(board);
+        sw.stop();
+        latencies[0][i] = sw.getElapsedMicrosec();
+        if (answers == 0 || !verify_solution(puzzles[i], board))
+            wrongAnswers[0]++;
+
+        board = puzzles[i];
+        sw.start();
+        bool success = racer.solve(board);
+        sw.stop();
+        latencies[1][i] = sw.getElapsedMicrosec();
+        if (!success || !verify_solution(puzzles[i], board))
+            wrongAnswers[1]++;
+
+        board = puzzles[i];
+        sw.start();
+        success = portfolio.solve(board);
+        sw.stop();
+        latencies[2][i] = sw.getElapsedMicrosec();
+        if (!success || !verify_solution(puzzles[i], board))
+            wrongAnswers[2]++;
+    }
+
+    printf("Solver     Total (ms)  p50 (us)  p99 (us) p99.9 (us) max (us) avg (us)\n");
+    display_latency("dfs::v3", latencies[0]);
+    display_latency("dlx::v3", latencies[1]);
+    display_latency("portfolio", latencies[2]);
+    printf("\n");
+
+    const Stats & stats = portfolio.stats();
+    printf("Wrong answers: v3 = %u, dlx::v3 = %u, portfolio = %u\n\n",
+           (uint32_t)wrongAnswers[0], (uint32_t)wrongAnswers[1], (uint32_t)wrongAnswers[2]);
+    printf("Portfolio: puzzles = %u, in budget = %u, races = %u (%0.2f %%), v3 wins = %u, dlx::v3 wins = %u\n\n",
+           (uint32_t)stats.puzzles, (uint32_t)stats.in_budget, (uint32_t)stats.races,
+           calc_percent(stats.races, stats.puzzles),
+           (uint32_t)stats.solver_wins, (uint32_t)stats.racer_wins);
+
+    printf("------------------------------------------\n\n");
+}
+
+// A complete search for one answer, v3::Solver::solve() only fills the singles.
+template <typename SudokuSolver>
+static bool solve_puzzle(SudokuSolver & solver, typename SudokuSolver::Board & board)
+{
+    return solver.solve(board);
+}
+
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
+static bool solve_puzzle(v3::Solver<SudokuTy, PolicyTy, StatsTy> & solver, typename SudokuTy::board_type & board)
+{
+    return (solver.template search<SearchMode::OneAnswer>(board) != 0);
+}
+
+//
+// The cost of the SearchControl checks (a budget that is never reached) and
+// the statuses with a tight budget of guesses and with a tight deadline.
+//
+template <typename SudokuSolver>
+void run_sudoku_budget_test(const char * filename, const char * name,
+                            size_t maxGuesses = 20, double deadlineUs = 20.0)
+{
+    typedef typename SudokuSolver::sudoku_t         SudokuTy;
+    typedef typename SudokuSolver::Board            Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    SudokuSolver solver;
+
+    // Every puzzle is solved without and with the control in turn, so the
+    // noise of the machine hits both of them alike.
+    SearchControl control(size_t(-2), uint64_t(-2));
+    uint64_t pass_ticks[2] = { 0, 0 };
+    jtest::StopWatch sw;
+    uint64_t start_ticks = SearchControl::read_tsc();
+    sw.start();
+    for (size_t round = 0; round < 3; round++) {
+        for (size_t i = 0; i < puzzleCount; i++) {
+            for (size_t n = 0; n < 2; n++) {
+                // Pass 1: both checks of the budget run, but never stop the search.
+                size_t pass = (n + i + round) & 1;
+                solver.set_control((pass == 0) ? nullptr : &control);
+                Board board = puzzles[i];
+                uint64_t ticks = SearchControl::read_tsc();
+                solve_puzzle(solver, board);
+                pass_ticks[pass] += SearchControl::read_tsc() - ticks;
+            }
+        }
+    }
+    sw.stop();
+    uint64_t total_ticks = SearchControl::read_tsc() - start_ticks;
+    double ticks_per_us = (double)total_ticks / (sw.getElapsedMillisec() * 1000.0);
+    double best_time[2];
+    for (size_t pass = 0; pass < 2; pass++) {
+        best_time[pass] = (double)pass_ticks[pass] / ticks_per_us / 1000.0 / 3.0;
+    }
+
+    size_t status_count[2][SearchStatusLast] = { { 0 } };
+    for (size_t pass = 0; pass < 2; pass++) {
+        control.set_max_guesses(0);
+        control.set_deadline(0);
+        solver.set_control(&control);
+        for (size_t i = 0; i < puzzleCount; i++) {
+            Board board = puzzles[i];
+            control.reset();
+            if (pass == 0) {
+                control.set_max_guesses(maxGuesses);
+            }
+            else {
+                control.set_timeout((uint64_t)(deadlineUs * ticks_per_us));
+            }
+            bool success = solve_puzzle(solver, board);
+            status_count[pass][control.status(success)]++;
+        }
+    }
+    solver.set_control(nullptr);
+
+    printf("%-8s  no control: %9.3f ms, with control: %9.3f ms, overhead = %5.2f %% (per pass)\n",
+           name, best_time[0], best_time[1],
+           (best_time[0] != 0.0) ? ((best_time[1] - best_time[0]) * 100.0 / best_time[0]) : 0.0);
+    printf("          max guesses %-4u: %s = %u, %s = %u\n",
+           (uint32_t)maxGuesses,
+           SearchControl::status_name(SearchStatus::Solved), (uint32_t)status_count[0][SearchStatus::Solved],
+           SearchControl::status_name(SearchStatus::BudgetExceeded),
+           (uint32_t)status_count[0][SearchStatus::BudgetExceeded]);
+    printf("          deadline %0.0f us  : %s = %u, %s = %u\n\n",
+           deadlineUs,
+           SearchControl::status_name(SearchStatus::Solved), (uint32_t)status_count[1][SearchStatus::Solved],
+           SearchControl::status_name(SearchStatus::BudgetExceeded),
+           (uint32_t)status_count[1][SearchStatus::BudgetExceeded]);
+}
+
+//
+// The time of every solver of the Router on every puzzle (best of 3 runs),
+// the total time of every fixed choice, of the oracle (the fastest solver
+// of every puzzle) and of the routing by a table trained on this file
+// (in sample). The regret is the time over the oracle.
+//
+template <typename SudokuTy>
+void run_sudoku_router_test(const char * filename)
+{
+    typedef typename SudokuTy::board_type               Board;
+    typedef Router<SudokuTy>                            router_t;
+
+    static const size_t kSolvers = router_t::SolverLast;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    router_t router;
+    printf("jmSudoku: Router of dfs::v3, dfs::v3e and dlx::v3, buckets = %u\n\n",
+           (uint32_t)router_t::kBuckets);
+
+    jtest::StopWatch sw;
+    std::vector<double> times(puzzleCount * kSolvers, 0.0);
+    size_t wrongAnswers = 0;
+    for (size_t round = 0; round < 3; round++) {
+        for (size_t i = 0; i < puzzleCount; i++) {
+            for (size_t solver_id = 0; solver_id < kSolvers; solver_id++) {
+                Board board = puzzles[i];
+                sw.start();
+                bool success = router.solve_by(solver_id, board);
+                sw.stop();
+                double elapsed_time = sw.getElapsedMicrosec();
+                double & best_time = times[i * kSolvers + solver_id];
+                if (round == 0 || elapsed_time < best_time)
+                    best_time = elapsed_time;
+                if (round == 0 && (!success || !verify_solution(puzzles[i], board)))
+                    wrongAnswers++;
+            }
+        }
+    }
+
+    uint8_t trained_table[router_t::kBuckets];
+    router.train(puzzles, times, trained_table);
+
+    double fixed_time[kSolvers] = { 0.0 };
+    double oracle_time = 0.0, trained_time = 0.0;
+    size_t oracle_wins[kSolvers] = { 0 };
+    std::vector<size_t> bucket_count(router_t::kBuckets, 0);
+    for (size_t i = 0; i < puzzleCount; i++) {
+        typename router_t::Features features;
+        router.get_features(puzzles[i], features);
+        size_t bucket = router_t::get_bucket(features);
+        bucket_count[bucket]++;
+
+        size_t best_id = 0;
+        for (size_t solver_id = 0; solver_id < kSolvers; solver_id++) {
+            double elapsed_time = times[i * kSolvers + solver_id];
+            fixed_time[solver_id] += elapsed_time;
+            if (elapsed_time < times[i * kSolvers + best_id])
+                best_id = solver_id;
+        }
+        oracle_wins[best_id]++;
+        oracle_time += times[i * kSolvers + best_id];
+        trained_time += times[i * kSolvers + trained_table[bucket]];
+    }
+
+    // v3 alone, then the routing by the default table, all v3, without the features.
+    sw.start();
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        router.solve_by(router_t::SolverV3, board);
+    }
+    sw.stop();
+    double v3_time = sw.getElapsedMillisec();
+
+    router_t default_router;
+    sw.start();
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        default_router.solve(board);
+    }
+    sw.stop();
+    double default_time = sw.getElapsedMillisec();
+
+    // The routing itself by the trained table, with the cost of the features.
+    router.set_table(trained_table);
+    sw.start();
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board board = puzzles[i];
+        router.solve(board);
+    }
+    sw.stop();
+    double routed_time = sw.getElapsedMillisec();
+
+    double feature_time;
+    size_t total_buckets = 0;
+    sw.start();
+    for (size_t i = 0; i < puzzleCount; i++) {
+        typename router_t::Features features;
+        router.get_features(puzzles[i], features);
+        total_buckets += router_t::get_bucket(features);
+    }
+    sw.stop();
+    feature_time = sw.getElapsedMillisec();
+
+    size_t used_buckets = 0, max_bucket_count = 0;
+    for (size_t bucket = 0; bucket < router_t::kBuckets; bucket++) {
+        if (bucket_count[bucket] != 0)
+            used_buckets++;
+        if (bucket_count[bucket] > max_bucket_count)
+            max_bucket_count = bucket_count[bucket];
+    }
+
+    printf("Puzzle count = %u, wrong answers = %u, features: %0.1f ns/puzzle (%u)\n",
+           (uint32_t)puzzleCount, (uint32_t)wrongAnswers,
+           (puzzleCount != 0) ? (feature_time * 1000000.0 / puzzleCount) : 0.0,
+           (uint32_t)(total_buckets & 0xFF));
+    printf("Buckets used = %u, the largest one has %0.1f %% of the puzzles\n\n",
+           (uint32_t)used_buckets, calc_percent(max_bucket_count, puzzleCount));
+
+    printf("Choice           Total (ms)   Regret (ms)   Regret (%%)\n");
+    for (size_t solver_id = 0; solver_id < kSolvers; solver_id++) {
+        printf("always %-9s %11.3f   %11.3f   %9.2f   (oracle wins = %u)\n",
+               router_t::solver_name(solver_id), fixed_time[solver_id] / 1000.0,
+               (fixed_time[solver_id] - oracle_time) / 1000.0,
+               calc_percent(fixed_time[solver_id] - oracle_time, oracle_time),
+               (uint32_t)oracle_wins[solver_id]);
+    }
+    printf("trained table    %11.3f   %11.3f   %9.2f   (in sample)\n", trained_time / 1000.0,
+           (trained_time - oracle_time) / 1000.0, (trained_time - oracle_time) * 100.0 / oracle_time);
+    printf("oracle           %11.3f\n\n", oracle_time / 1000.0);
+
+    printf("dfs::v3 alone: %0.3f ms, routed by the default table: %0.3f ms\n", v3_time, default_time);
+    printf("Routed by the trained table: %0.3f ms (", routed_time);
+    for (size_t solver_id = 0; solver_id < kSolvers; solver_id++) {
+        printf("%s = %u%s", router_t::solver_name(solver_id), (uint32_t)router.routed(solver_id),
+               (solver_id + 1 < kSolvers) ? ", " : ")\n\n");
+    }
+
+    printf("The table trained on this file:\n\n");
+    router_t::print_table(trained_table);
+    printf("\n");
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// Places the number of the given at from into an empty cell of its unit,
+// the cell must not see the number in its other units.
+//
+template <typename SudokuTy>
+static bool add_conflict(typename SudokuTy::board_type & board, size_t unit_type)
+{
+    typedef typename SudokuTy::CellInfo CellInfo;
+
+    for (size_t from = 0; from < SudokuTy::BoardSize; from++) {
+        char val = board.cells[from];
+        if (val == '.')
+            continue;
+        const CellInfo & fromInfo = SudokuTy::cell_info[from];
+        for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+            const CellInfo & cellInfo = SudokuTy::cell_info[pos];
+            if (board.cells[pos] != '.')
+                continue;
+            bool in_unit = (unit_type == 0) ? (cellInfo.row == fromInfo.row) :
+                          ((unit_type == 1) ? (cellInfo.col == fromInfo.col) : (cellInfo.box == fromInfo.box));
+            if (!in_unit)
+                continue;
+            bool sees_other = false;
+            for (size_t peer = 0; peer < SudokuTy::BoardSize; peer++) {
+                if (board.cells[peer] != val)
+                    continue;
+                const CellInfo & peerInfo = SudokuTy::cell_info[peer];
+                if ((unit_type != 0 && peerInfo.row == cellInfo.row) ||
+                    (unit_type != 1 && peerInfo.col == cellInfo.col) ||
+                    (unit_type != 2 && peerInfo.box == cellInfo.box)) {
+                    sees_other = true;
+                    break;
+                }
+            }
+            if (!sees_other) {
+                board.cells[pos] = val;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//
+// Fills some empty peers of an empty cell with its candidates, without a
+// conflict, until the cell has no candidate.
+//
+template <typename SudokuTy>
+static bool add_no_candidate(typename SudokuTy::board_type & board)
+{
+    typedef typename SudokuTy::board_type   Board;
+    typedef typename SudokuTy::CellInfo     CellInfo;
+
+    for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+        if (board.cells[pos] != '.')
+            continue;
+        Board test = board;
+        const CellInfo & cellInfo = SudokuTy::cell_info[pos];
+        for (size_t peer = 0; peer < SudokuTy::BoardSize; peer++) {
+            const CellInfo & peerInfo = SudokuTy::cell_info[peer];
+            if (peer == pos || test.cells[peer] != '.' ||
+                (peerInfo.row != cellInfo.row && peerInfo.col != cellInfo.col && peerInfo.box != cellInfo.box))
+                continue;
+            // The first number that fits the peer and is still a candidate of the cell.
+            for (char val = '1'; val <= '9'; val++) {
+                bool seen = false;
+                for (size_t n = 0; n < SudokuTy::BoardSize; n++) {
+                    if (test.cells[n] != val)
+                        continue;
+                    const CellInfo & info = SudokuTy::cell_info[n];
+                    if (info.row == cellInfo.row || info.col == cellInfo.col || info.box == cellInfo.box ||
+                        info.row == peerInfo.row || info.col == peerInfo.col || info.box == peerInfo.box) {
+                        seen = true;
+                        break;
+                    }
+                }
+                if (!seen) {
+                    test.cells[peer] = val;
+                    break;
+                }
+            }
+            if (check_board_scalar(test) == BoardCheck::NoCandidate) {
+                board = test;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//
+// Every puzzle of the file gets one fault (or none): an invalid char, a
+// number twice in a row, a column or a box, or an empty cell without a
+// candidate. The SIMD check has to agree with the scalar check on all of
+// them and on random boards, the solvers have to reject the faulty ones.
+//
+template <typename SudokuTy>
+void run_sudoku_check_test(const char * filename, size_t repeats = 20)
+{
+    typedef typename SudokuTy::board_type   Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    size_t puzzleCount = puzzles.size();
+
+    printf("jmSudoku: check_board() of the input, faulty puzzles from %u puzzles\n\n", (uint32_t)puzzleCount);
+
+    std::vector<Board> tests = puzzles;
+    for (size_t i = 0; i < puzzleCount; i++) {
+        Board & test = tests[i];
+        switch (i % BoardCheck::BoardCheckLast) {
+            case BoardCheck::InvalidChar:
+                test.cells[(i * 7) % SudokuTy::BoardSize] = 'x';
+                break;
+            case BoardCheck::RowConflict:
+                add_conflict<SudokuTy>(test, 0);
+                break;
+            case BoardCheck::ColConflict:
+                add_conflict<SudokuTy>(test, 1);
+                break;
+            case BoardCheck::BoxConflict:
+                add_conflict<SudokuTy>(test, 2);
+                break;
+            case BoardCheck::NoCandidate:
+                add_no_candidate<SudokuTy>(test);
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t checks[BoardCheck::BoardCheckLast] = { 0 };
+    size_t disagreements = 0;
+    std::vector<uint8_t> results(puzzleCount);
+    for (size_t i = 0; i < puzzleCount; i++) {
+        BoardCheck check = check_board(tests[i]);
+        results[i] = (uint8_t)check;
+        checks[check]++;
+        if (check != check_board_scalar(tests[i]))
+            disagreements++;
+    }
+
+    // Random boards, one of 8 cells gets a random number.
+    std::mt19937 rng(20211018);
+    std::uniform_int_distribution<int> cell_dist(0, 71);
+    size_t randomCount = puzzleCount * 4;
+    size_t random_checks[BoardCheck::BoardCheckLast] = { 0 };
+    for (size_t i = 0; i < randomCount; i++) {
+        Board board;
+        for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+            int num = cell_dist(rng);
+            board.cells[pos] = (num < 9) ? (char)('1' + num) : ((num == 71 && (i & 1)) ? '0' : '.');
+        }
+        BoardCheck check = check_board(board);
+        random_checks[check]++;
+        if (check != check_board_scalar(board))
+            disagreements++;
+    }
+
+    printf("Faulty puzzles:");
+    for (size_t n = 0; n < BoardCheck::BoardCheckLast; n++) {
+        printf(" %s = %u%s", board_check_name(n), (uint32_t)checks[n],
+               (n + 1 < BoardCheck::BoardCheckLast) ? "," : "\n");
+    }
+    printf("Random boards: ");
+    for (size_t n = 0; n < BoardCheck::BoardCheckLast; n++) {
+        printf(" %s = %u%s", board_check_name(n), (uint32_t)random_checks[n],
+               (n + 1 < BoardCheck::BoardCheckLast) ? "," : "\n");
+    }
+    printf("Disagreements of the simd and the scalar check: %u\n\n", (uint32_t)disagreements);
+
+    jtest::StopWatch sw;
+    size_t valid_simd = 0, valid_scalar = 0;
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < puzzleCount; i++) {
+            valid_simd += (check_board(tests[i]) == BoardCheck::BoardValid) ? 1 : 0;
+        }
+    }
+    sw.stop();
+    double simd_time = sw.getElapsedMillisec();
+
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < puzzleCount; i++) {
+            valid_scalar += (check_board_scalar(tests[i]) == BoardCheck::BoardValid) ? 1 : 0;
+        }
+    }
+    sw.stop();
+    double scalar_time = sw.getElapsedMillisec();
+
+    size_t total = puzzleCount * repeats;
+    printf("check_board(): %0.2f ns/grid, check_board_scalar(): %0.2f ns/grid\n",
+           (total != 0) ? (simd_time * 1000000.0 / total) : 0.0,
+           (total != 0) ? (scalar_time * 1000000.0 / total) : 0.0);
+    printf("Passed: check_board() = %u, check_board_scalar() = %u\n\n",
+           (uint32_t)(valid_simd / repeats), (uint32_t)(valid_scalar / repeats));
+
+    // The solve() entries of the solvers, the faulty puzzles are rejected.
+    v3::Solver<SudokuTy> v3_solver;
+    v3e::Solver<SudokuTy> v3e_solver;
+    dlx::v3::Solver<SudokuTy> dlx_solver;
+    const char * names[3] = { "dfs::v3", "dfs::v3e", "dlx::v3" };
+    for (size_t solver_id = 0; solver_id < 3; solver_id++) {
+        double valid_time = 0.0, faulty_time = 0.0;
+        size_t validCount = 0, rejected = 0, mismatches = 0;
+        for (size_t i = 0; i < puzzleCount; i++) {
+            Board board = tests[i];
+            sw.start();
+            bool success;
+            if (solver_id == 0)
+                success = solve_puzzle(v3_solver, board);
+            else if (solver_id == 1)
+                success = v3e_solver.solve(board);
+            else
+                success = dlx_solver.solve(board);
+            sw.stop();
+
+            size_t last_check = BasicSolver<SudokuTy>::get_last_check();
+            if (last_check != results[i])
+                mismatches++;
+            if (results[i] == BoardCheck::BoardValid) {
+                valid_time += sw.getElapsedMillisec();
+                validCount++;
+                if (!success || !verify_solution(tests[i], board))
+                    mismatches++;
+            }
+            else {
+                faulty_time += sw.getElapsedMillisec();
+                rejected += success ? 0 : 1;
+            }
+        }
+        size_t faultyCount = puzzleCount - validCount;
+        printf("%-8s valid: %u, %0.3f us/puzzle, faulty: %u rejected / %u, %0.3f us/puzzle, mismatches = %u\n",
+               names[solver_id], (uint32_t)validCount,
+               (validCount != 0) ? (valid_time * 1000.0 / validCount) : 0.0,
+               (uint32_t)rejected, (uint32_t)faultyCount,
+               (faultyCount != 0) ? (faulty_time * 1000.0 / faultyCount) : 0.0,
+               (uint32_t)mismatches);
+    }
+    printf("\n");
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// init_board() of v3 and v3e by the scalar and the SIMD path: the states
+// have to be bit-identical on every puzzle, the time is measured on the
+// puzzles that the singles solve (no guess), where init_board() dominates.
+//
+template <typename SudokuSolver>
+void run_sudoku_init_board_test(const std::vector<typename SudokuSolver::Board> & puzzles,
+                                const std::vector<typename SudokuSolver::Board> & no_guess,
+                                const char * name, size_t repeats = 20)
+{
+    typedef typename SudokuSolver::Board Board;
+
+    SudokuSolver solver;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        if (!solver.check_init_board(board))
+            mismatches++;
+    }
+
+    size_t count = no_guess.size();
+    std::vector<Board> boards = no_guess;
+    jtest::StopWatch sw;
+
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < count; i++) {
+            solver.init_board_scalar(boards[i]);
+        }
+    }
+    sw.stop();
+    double scalar_time = sw.getElapsedMillisec();
+
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < count; i++) {
+            solver.init_board_simd(boards[i]);
+        }
+    }
+    sw.stop();
+    double simd_time = sw.getElapsedMillisec();
+
+    size_t solved = 0;
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < count; i++) {
+            Board board = no_guess[i];
+            solved += solve_puzzle(solver, board) ? 1 : 0;
+        }
+    }
+    sw.stop();
+    double solve_time = sw.getElapsedMillisec();
+
+    size_t total = count * repeats;
+    double scalar_ns = (total != 0) ? (scalar_time * 1000000.0 / total) : 0.0;
+    double simd_ns = (total != 0) ? (simd_time * 1000000.0 / total) : 0.0;
+    double solve_ns = (total != 0) ? (solve_time * 1000000.0 / total) : 0.0;
+    printf("%-8s state mismatches = %u / %u, init_board(): scalar %0.1f ns, simd %0.1f ns (%0.2fx)\n",
+           name, (uint32_t)mismatches, (uint32_t)puzzles.size(), scalar_ns, simd_ns,
+           (simd_ns != 0.0) ? (scalar_ns / simd_ns) : 0.0);
+    printf("%-8s solve(): %0.1f ns/puzzle, solved = %u / %u, init_board() share: scalar %0.1f %%, simd %0.1f %%\n\n",
+           name, solve_ns, (uint32_t)(solved / repeats), (uint32_t)count,
+           (solve_ns - simd_ns + scalar_ns != 0.0) ? (scalar_ns * 100.0 / (solve_ns - simd_ns + scalar_ns)) : 0.0,
+           (solve_ns != 0.0) ? (simd_ns * 100.0 / solve_ns) : 0.0);
+}
+
+template <typename SudokuTy>
+void run_sudoku_init_board_tests(const char * filename)
+{
+    typedef typename SudokuTy::board_type Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+
+    // The no-guess subset: the puzzles that the singles of v3 solve.
+    std::vector<Board> no_guess;
+    {
+        v3::Solver<SudokuTy> solver;
+        for (size_t i = 0; i < puzzles.size(); i++) {
+            Board board = puzzles[i];
+            if (solver.solve(board))
+                no_guess.push_back(puzzles[i]);
+        }
+    }
+
+    printf("jmSudoku: init_board(), %u puzzles, %u without a guess\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)no_guess.size());
+
+    run_sudoku_init_board_test<v3::Solver<SudokuTy>>(puzzles, no_guess, "dfs::v3");
+    run_sudoku_init_board_test<v3e::Solver<SudokuTy>>(puzzles, no_guess, "dfs::v3e");
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The eager and the lazy literal selection of v3 on the same puzzles: the
+// answers must match, the lazy one may fill a few more singles before it
+// sees a dead row/col/box literal.
+//
+template <typename SudokuTy>
+void run_sudoku_lazy_select_test(const char * filename, size_t rounds = 5)
+{
+    typedef typename SudokuTy::board_type Board;
+    typedef v3::Solver<SudokuTy> SudokuSolver;
+    typedef BasicSolver<SudokuTy> basic_solver_t;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+
+    SudokuSolver solver;
+
+    printf("jmSudoku: dfs::v3 literal selection, %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    static const char * mode_names[2] = { "eager", "lazy" };
+    std::vector<Board> answers[2];
+    size_t total_nodes[2] = { 0, 0 };
+    uint64_t best_ticks[2] = { uint64_t(-1), uint64_t(-1) };
+    double best_time[2] = { 0.0, 0.0 };
+
+    // The modes take turns, so that both see the same state of the machine.
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t turn = 0; turn < 2; turn++) {
+            size_t mode = (round & 1) ^ turn;
+            solver.set_lazy_select(mode != 0);
+            if (round == 0)
+                answers[mode].resize(puzzles.size());
+
+            size_t nodes = 0;
+            jtest::StopWatch sw;
+            sw.start();
+            uint64_t start_ticks = SearchControl::read_tsc();
+            for (size_t i = 0; i < puzzles.size(); i++) {
+                Board board = puzzles[i];
+                solve_puzzle(solver, board);
+                nodes += basic_solver_t::get_num_guesses() +
+                         basic_solver_t::get_num_unique_candidate();
+                if (round == 0)
+                    answers[mode][i] = board;
+            }
+            uint64_t ticks = SearchControl::read_tsc() - start_ticks;
+            sw.stop();
+
+            total_nodes[mode] = nodes;
+            if (ticks < best_ticks[mode]) {
+                best_ticks[mode] = ticks;
+                best_time[mode] = sw.getElapsedMillisec();
+            }
+        }
+    }
+    solver.set_lazy_select(V3_LAZY_LITERAL_SELECT != 0);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        if (std::memcmp(&answers[0][i], &answers[1][i], sizeof(Board)) != 0)
+            mismatches++;
+    }
+
+    for (size_t mode = 0; mode < 2; mode++) {
+        printf("%-5s : nodes = %" PRIuPTR ", %0.1f cycles/node, %0.3f us/puzzle\n",
+               mode_names[mode], total_nodes[mode],
+               (total_nodes[mode] != 0) ? ((double)best_ticks[mode] / total_nodes[mode]) : 0.0,
+               (puzzles.size() != 0) ? (best_time[mode] * 1000.0 / puzzles.size()) : 0.0);
+    }
+    printf("answer mismatches = %u, speedup = %0.2fx\n\n",
+           (uint32_t)mismatches, (best_time[1] != 0.0) ? (best_time[0] / best_time[1]) : 0.0);
+
+    printf("------------------------------------------\n\n");
+}
+
+struct TuningResult {
+    std::string name;
+    std::string policy;
+    double      time;           // us/puzzle, the best round
+};
+
+template <typename SudokuSolver>
+static double time_tuning_config(SudokuSolver & solver,
+                                 const std::vector<typename SudokuSolver::Board> & puzzles,
+                                 size_t rounds)
+{
+    typedef typename SudokuSolver::Board Board;
+
+    double best_time = 0.0;
+    for (size_t round = 0; round < rounds; round++) {
+        jtest::StopWatch sw;
+        sw.start();
+        for (size_t i = 0; i < puzzles.size(); i++) {
+            Board board = puzzles[i];
+            solve_puzzle(solver, board);
+        }
+        sw.stop();
+        double elapsed_time = sw.getElapsedMillisec();
+        if (round == 0 || elapsed_time < best_time)
+            best_time = elapsed_time;
+    }
+    return (puzzles.size() != 0) ? (best_time * 1000.0 / puzzles.size()) : 0.0;
+}
+
+template <typename SudokuTy, bool SaveCountSize, bool SimdCopyBoard, bool RecoverAllBoxes,
+          bool CompactState>
+static void tune_v3_policy(const std::vector<typename SudokuTy::board_type> & puzzles,
+                           size_t rounds, std::vector<TuningResult> & results)
+{
+    for (size_t lazy = 0; lazy < 2; lazy++) {
+        typedef v3::SolverPolicy<SaveCountSize, SimdCopyBoard, RecoverAllBoxes, true, true,
+                                 CompactState, v3::UndoLog> policy_t;
+        v3::Solver<SudokuTy, policy_t> solver;
+        solver.set_lazy_select(lazy != 0);
+
+        char policy[128];
+        snprintf(policy, sizeof(policy), "v3::SolverPolicy<%s, %s, %s, true, %s, %s>",
+                 SaveCountSize ? "true" : "false", SimdCopyBoard ? "true" : "false",
+                 RecoverAllBoxes ? "true" : "false", lazy ? "true" : "false",
+                 CompactState ? "true" : "false");
+
+        TuningResult result;
+        result.name = "dfs::v3";
+        result.policy = policy;
+        result.time = time_tuning_config(solver, puzzles, rounds);
+        results.push_back(result);
+    }
+}
+
+template <typename SudokuTy, bool SaveCountSize, bool SimdCopyBoard, bool RecoverAllBoxes>
+static void tune_v3e_policy(const std::vector<typename SudokuTy::board_type> & puzzles,
+                            size_t rounds, std::vector<TuningResult> & results)
+{
+    typedef v3e::SolverPolicy<SaveCountSize, SimdCopyBoard, RecoverAllBoxes, true> policy_t;
+    v3e::Solver<SudokuTy, policy_t> solver;
+
+    char policy[128];
+    snprintf(policy, sizeof(policy), "v3e::SolverPolicy<%s, %s, %s, true>",
+             SaveCountSize ? "true" : "false", SimdCopyBoard ? "true" : "false",
+             RecoverAllBoxes ? "true" : "false");
+
+    TuningResult result;
+    result.name = "dfs::v3e";
+    result.policy = policy;
+    result.time = time_tuning_config(solver, puzzles, rounds);
+    results.push_back(result);
+}
+
+template <typename SudokuTy, bool UseStdBitset>
+static void tune_v1_policy(const std::vector<typename SudokuTy::board_type> & puzzles,
+                           size_t rounds, std::vector<TuningResult> & results)
+{
+    typedef v1::SolverPolicy<UseStdBitset> policy_t;
+    v1::Solver<SudokuTy, policy_t> solver;
+
+    TuningResult result;
+    result.name = "dfs::v1";
+    result.policy = UseStdBitset ? "v1::SolverPolicy<true>" : "v1::SolverPolicy<false>";
+    result.time = time_tuning_config(solver, puzzles, rounds);
+    results.push_back(result);
+}
+
+//
+// Times the useful combinations of the solver policies on the first
+// max_puzzles puzzles (best of the rounds) and reports the fastest one of
+// every solver on this CPU. The scalar copy of the board always restores
+// all the boxes, so it isn't combined with kRecoverAllBoxes = false.
+//
+template <typename SudokuTy>
+void run_sudoku_tuning_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 3)
+{
+    typedef typename SudokuTy::board_type Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: solver policy tuning, %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    std::vector<TuningResult> results;
+    tune_v3_policy<SudokuTy, true,  true,  true,  false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, true,  true,  false, false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, true,  false, true,  false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, false, true,  true,  false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, false, true,  false, false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, false, false, true,  false>(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, true,  true,  true,  true >(puzzles, rounds, results);
+    tune_v3_policy<SudokuTy, false, true,  true,  true >(puzzles, rounds, results);
+
+    tune_v3e_policy<SudokuTy, true,  true,  true >(puzzles, rounds, results);
+    tune_v3e_policy<SudokuTy, true,  true,  false>(puzzles, rounds, results);
+    tune_v3e_policy<SudokuTy, true,  false, true >(puzzles, rounds, results);
+    tune_v3e_policy<SudokuTy, false, true,  true >(puzzles, rounds, results);
+
+    tune_v1_policy<SudokuTy, false>(puzzles, rounds, results);
+    tune_v1_policy<SudokuTy, true >(puzzles, rounds, results);
+
+    printf("Solver     Policy                                                    us/puzzle\n");
+    printf("------------------------------------------------------------------------------\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        printf("%-10s %-56s %10.3f\n", results[i].name.c_str(), results[i].policy.c_str(), results[i].time);
+    }
+    printf("\n");
+
+    printf("The fastest policies on this CPU:\n\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        size_t best = i;
+        bool is_first = true;
+        for (size_t j = 0; j < results.size(); j++) {
+            if (results[j].name != results[i].name)
+                continue;
+            if (j < i)
+                is_first = false;
+            if (results[j].time < results[best].time)
+                best = j;
+        }
+        if (is_first) {
+            printf("%-10s typedef %s TunedPolicy;  // %0.3f us/puzzle\n",
+                   results[best].name.c_str(), results[best].policy.c_str(), results[best].time);
+        }
+    }
+    printf("\n");
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The same solver with NoStats, BasicStats and DetailedStats. The three of
+// them take turns in every round, the best round of every one is reported.
+//
+template <typename NoStatsSolver, typename BasicStatsSolver, typename DetailedStatsSolver>
+static void time_stats_policies(const char * name,
+                                const std::vector<typename NoStatsSolver::Board> & puzzles,
+                                size_t rounds)
+{
+    NoStatsSolver no_stats_solver;
+    BasicStatsSolver basic_stats_solver;
+    DetailedStatsSolver detailed_stats_solver;
+
+    static const char * stats_names[3] = { "NoStats", "BasicStats", "DetailedStats" };
+    double best_time[3] = { 0.0, 0.0, 0.0 };
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t n = 0; n < 3; n++) {
+            size_t stats = (n + round) % 3;
+            double time;
+            if (stats == 0)
+                time = time_tuning_config(no_stats_solver, puzzles, 1);
+            else if (stats == 1)
+                time = time_tuning_config(basic_stats_solver, puzzles, 1);
+            else
+                time = time_tuning_config(detailed_stats_solver, puzzles, 1);
+            if (round == 0 || time < best_time[stats])
+                best_time[stats] = time;
+        }
+    }
+
+    for (size_t stats = 0; stats < 3; stats++) {
+        printf("%-10s %-14s %10.3f us/puzzle, %8.1f puzzles/s, %+6.2f %%\n",
+               (stats == 0) ? name : "", stats_names[stats], best_time[stats],
+               (best_time[stats] != 0.0) ? (1000000.0 / best_time[stats]) : 0.0,
+               (best_time[0] != 0.0) ? ((best_time[stats] - best_time[0]) * 100.0 / best_time[0]) : 0.0);
+    }
+    printf("\n");
+}
+
+//
+// The throughput of the statistics policies, and the depth histograms that
+// DetailedStats collects with dfs::v3, in buckets of 8 levels.
+//
+template <typename SudokuTy>
+void run_sudoku_stats_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 5)
+{
+    typedef typename SudokuTy::board_type   Board;
+    typedef BasicSolver<SudokuTy>           basic_solver_t;
+
+    static const size_t kDepthBucket = 8;
+    static const size_t kDepthBuckets = (basic_solver_t::kMaxDepth + kDepthBucket - 1) / kDepthBucket;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: statistics policies, %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    time_stats_policies<v3::Solver<SudokuTy, v3::DefaultPolicy, NoStats>,
+                        v3::Solver<SudokuTy, v3::DefaultPolicy, BasicStats>,
+                        v3::Solver<SudokuTy, v3::DefaultPolicy, DetailedStats>>("dfs::v3", puzzles, rounds);
+    time_stats_policies<v3e::Solver<SudokuTy, v3e::DefaultPolicy, NoStats>,
+                        v3e::Solver<SudokuTy, v3e::DefaultPolicy, BasicStats>,
+                        v3e::Solver<SudokuTy, v3e::DefaultPolicy, DetailedStats>>("dfs::v3e", puzzles, rounds);
+    time_stats_policies<v1::Solver<SudokuTy, v1::DefaultPolicy, NoStats>,
+                        v1::Solver<SudokuTy, v1::DefaultPolicy, BasicStats>,
+                        v1::Solver<SudokuTy, v1::DefaultPolicy, DetailedStats>>("dfs::v1", puzzles, rounds);
+    time_stats_policies<dlx::v3::Solver<SudokuTy, NoStats>,
+                        dlx::v3::Solver<SudokuTy, BasicStats>,
+                        dlx::v3::Solver<SudokuTy, DetailedStats>>("dlx::v3", puzzles, rounds);
+
+    v3::Solver<SudokuTy, v3::DefaultPolicy, DetailedStats> solver;
+
+    basic_solver_t::reset_depth_statistics();
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        solve_puzzle(solver, board);
+    }
+
+    const size_t * guess_depths = basic_solver_t::get_guess_depths();
+    const size_t * unique_depths = basic_solver_t::get_unique_depths();
+    const size_t * failed_depths = basic_solver_t::get_failed_depths();
+
+    printf("dfs::v3 DetailedStats, by the depth of the search:\n\n");
+    printf("Depth        guesses     unique     failed\n");
+    printf("------------------------------------------\n");
+    for (size_t bucket = 0; bucket < kDepthBuckets; bucket++) {
+        size_t guesses = 0, uniques = 0, failed = 0;
+        size_t first = bucket * kDepthBucket;
+        size_t last = first + kDepthBucket;
+        if (last > basic_solver_t::kMaxDepth)
+            last = basic_solver_t::kMaxDepth;
+        for (size_t depth = first; depth < last; depth++) {
+            guesses += guess_depths[depth];
+            uniques += unique_depths[depth];
+            failed += failed_depths[depth];
+        }
+        printf("%2u - %-2u  %10u %10u %10u\n", (uint32_t)first, (uint32_t)(last - 1),
+               (uint32_t)guesses, (uint32_t)uniques, (uint32_t)failed);
+    }
+    printf("\n");
+
+    printf("------------------------------------------\n\n");
+}
+
+struct CompactStateResult {
+    size_t      nodes;
+    uint64_t    ticks;          // The best round
+    double      time;
+    uint64_t    l1_reads;       // The round of the best ticks
+    uint64_t    l1_misses;
+};
+
+template <typename SudokuSolver>
+static void time_compact_state_mode(SudokuSolver & solver,
+                                    const std::vector<typename SudokuSolver::Board> & puzzles,
+                                    std::vector<typename SudokuSolver::Board> & answers,
+                                    jtest::CacheCounter & counter, CompactStateResult & result)
+{
+    typedef typename SudokuSolver::Board Board;
+    typedef typename SudokuSolver::basic_solver_t basic_solver_t;
+
+    answers.resize(puzzles.size());
+    size_t nodes = 0;
+    jtest::StopWatch sw;
+    counter.start();
+    sw.start();
+    uint64_t start_ticks = SearchControl::read_tsc();
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        solve_puzzle(solver, board);
+        nodes += basic_solver_t::get_num_guesses() + basic_solver_t::get_num_unique_candidate();
+        answers[i] = board;
+    }
+    uint64_t ticks = SearchControl::read_tsc() - start_ticks;
+    sw.stop();
+    counter.stop();
+
+    result.nodes = nodes;
+    if (ticks < result.ticks) {
+        result.ticks = ticks;
+        result.time = sw.getElapsedMillisec();
+        result.l1_reads = counter.reads();
+        result.l1_misses = counter.misses();
+    }
+}
+
+//
+// The padded and the compact state of v3 (kCompactState): the sizes of the
+// Count, the RecoverState and the Solver, the stack of the RecoverStates at
+// the deepest search, and the time and the L1 data cache misses (where the
+// host has the counters) of both modes in turns, best of the rounds. The
+// answers and the nodes of the two modes must be the same.
+//
+template <typename SudokuTy>
+void run_sudoku_compact_state_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 5)
+{
+    typedef typename SudokuTy::board_type   Board;
+    typedef v3::DefaultPolicy               base_t;
+    typedef v3::SolverPolicy<base_t::kSaveCountSize, base_t::kSimdCopyBoard, base_t::kRecoverAllBoxes,
+                             base_t::kSimdInitBoard, base_t::kLazySelect, false,
+                             base_t::kBacktrack> padded_policy_t;
+    typedef v3::SolverPolicy<base_t::kSaveCountSize, base_t::kSimdCopyBoard, base_t::kRecoverAllBoxes,
+                             base_t::kSimdInitBoard, base_t::kLazySelect, true,
+                             base_t::kBacktrack> compact_policy_t;
+    typedef v3::Solver<SudokuTy, padded_policy_t>   PaddedSolver;
+    typedef v3::Solver<SudokuTy, compact_policy_t>  CompactSolver;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    size_t max_empties = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        size_t empties = 0;
+        for (size_t pos = 0; pos < SudokuTy::BoardSize; pos++) {
+            if (puzzles[i].cells[pos] == '.')
+                empties++;
+        }
+        if (empties > max_empties)
+            max_empties = empties;
+    }
+
+    printf("jmSudoku: dfs::v3 compact RecoverState, %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    // The RecoverState of a level is aligned to 32 bytes on the stack.
+    size_t padded_level = (sizeof(typename PaddedSolver::recover_state_type) + 31) & ~size_t(31);
+    size_t compact_level = (sizeof(typename CompactSolver::recover_state_type) + 31) & ~size_t(31);
+    printf("sizeof(State)        = %u\n", (uint32_t)sizeof(typename PaddedSolver::state_type));
+    printf("sizeof(Count)        = %u padded, %u compact\n",
+           (uint32_t)sizeof(typename PaddedSolver::count_type),
+           (uint32_t)sizeof(typename CompactSolver::count_type));
+    printf("sizeof(RecoverState) = %u padded, %u compact\n",
+           (uint32_t)sizeof(typename PaddedSolver::recover_state_type),
+           (uint32_t)sizeof(typename CompactSolver::recover_state_type));
+    printf("sizeof(Solver)       = %u padded, %u compact\n",
+           (uint32_t)sizeof(PaddedSolver), (uint32_t)sizeof(CompactSolver));
+    printf("RecoverStates of %u levels: %0.1f KB padded, %0.1f KB compact\n\n",
+           (uint32_t)max_empties, (double)(padded_level * max_empties) / 1024.0,
+           (double)(compact_level * max_empties) / 1024.0);
+
+    PaddedSolver padded_solver;
+    CompactSolver compact_solver;
+
+    jtest::CacheCounter counter;
+    static const char * mode_names[2] = { "padded", "compact" };
+    std::vector<Board> answers[2];
+    CompactStateResult results[2];
+    for (size_t mode = 0; mode < 2; mode++) {
+        std::memset((void *)&results[mode], 0, sizeof(CompactStateResult));
+        results[mode].ticks = uint64_t(-1);
+    }
+
+    // The modes take turns, so that both see the same state of the machine.
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t turn = 0; turn < 2; turn++) {
+            size_t mode = (round & 1) ^ turn;
+            if (mode == 0)
+                time_compact_state_mode(padded_solver, puzzles, answers[0], counter, results[0]);
+            else
+                time_compact_state_mode(compact_solver, puzzles, answers[1], counter, results[1]);
+        }
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        if (std::memcmp(&answers[0][i], &answers[1][i], sizeof(Board)) != 0)
+            mismatches++;
+    }
+
+    for (size_t mode = 0; mode < 2; mode++) {
+        const CompactStateResult & result = results[mode];
+        printf("%-7s : nodes = %" PRIuPTR ", %0.1f cycles/node, %0.3f us/puzzle",
+               mode_names[mode], result.nodes,
+               (result.nodes != 0) ? ((double)result.ticks / result.nodes) : 0.0,
+               (puzzles.size() != 0) ? (result.time * 1000.0 / puzzles.size()) : 0.0);
+        if (counter.is_available()) {
+            printf(", L1D read misses = %0.3f %%\n",
+                   (result.l1_reads != 0) ? ((double)result.l1_misses * 100.0 / result.l1_reads) : 0.0);
+        }
+        else {
+            printf(", L1D read misses = n/a\n");
+        }
+    }
+    printf("answer mismatches = %u, node mismatches = %u, speedup = %0.2fx\n\n",
+           (uint32_t)mismatches, (uint32_t)((results[0].nodes != results[1].nodes) ? 1 : 0),
+           (results[1].time != 0.0) ? (results[0].time / results[1].time) : 0.0);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The undo-log and the snapshot backtracking of v3 (kBacktrack): the bytes
+// that a level keeps, and the time of both modes in turns, best of the
+// rounds. The answers and the nodes of the two modes must be the same.
+//
+template <typename SudokuTy>
+void run_sudoku_backtrack_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 5)
+{
+    typedef typename SudokuTy::board_type   Board;
+    typedef v3::DefaultPolicy               base_t;
+    typedef v3::SolverPolicy<base_t::kSaveCountSize, base_t::kSimdCopyBoard, base_t::kRecoverAllBoxes,
+                             base_t::kSimdInitBoard, base_t::kLazySelect, base_t::kCompactState,
+                             v3::UndoLog>   undo_log_policy_t;
+    typedef v3::SolverPolicy<base_t::kSaveCountSize, base_t::kSimdCopyBoard, base_t::kRecoverAllBoxes,
+                             base_t::kSimdInitBoard, base_t::kLazySelect, base_t::kCompactState,
+                             v3::Snapshot>  snapshot_policy_t;
+    typedef v3::Solver<SudokuTy, undo_log_policy_t> UndoLogSolver;
+    typedef v3::Solver<SudokuTy, snapshot_policy_t> SnapshotSolver;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: dfs::v3 undo-log vs snapshot backtracking, %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    printf("bytes of a level: %u undo-log (RecoverState), %u snapshot (State + Count)\n\n",
+           (uint32_t)sizeof(typename UndoLogSolver::backtrack_state_type),
+           (uint32_t)sizeof(typename SnapshotSolver::backtrack_state_type));
+
+    UndoLogSolver undo_log_solver;
+    SnapshotSolver snapshot_solver;
+
+    jtest::CacheCounter counter;
+    static const char * mode_names[2] = { "undo-log", "snapshot" };
+    std::vector<Board> answers[2];
+    CompactStateResult results[2];
+    for (size_t mode = 0; mode < 2; mode++) {
+        std::memset((void *)&results[mode], 0, sizeof(CompactStateResult));
+        results[mode].ticks = uint64_t(-1);
+    }
+
+    // The modes take turns, so that both see the same state of the machine.
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t turn = 0; turn < 2; turn++) {
+            size_t mode = (round & 1) ^ turn;
+            if (mode == 0)
+                time_compact_state_mode(undo_log_solver, puzzles, answers[0], counter, results[0]);
+            else
+                time_compact_state_mode(snapshot_solver, puzzles, answers[1], counter, results[1]);
+        }
+    }
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        if (std::memcmp(&answers[0][i], &answers[1][i], sizeof(Board)) != 0)
+            mismatches++;
+    }
+
+    for (size_t mode = 0; mode < 2; mode++) {
+        const CompactStateResult & result = results[mode];
+        printf("%-8s : nodes = %" PRIuPTR ", %0.1f cycles/node, %0.3f us/puzzle\n",
+               mode_names[mode], result.nodes,
+               (result.nodes != 0) ? ((double)result.ticks / result.nodes) : 0.0,
+               (puzzles.size() != 0) ? (result.time * 1000.0 / puzzles.size()) : 0.0);
+    }
+    printf("answer mismatches = %u, node mismatches = %u, snapshot speedup = %0.2fx\n\n",
+           (uint32_t)mismatches, (uint32_t)((results[0].nodes != results[1].nodes) ? 1 : 0),
+           (results[1].time != 0.0) ? (results[0].time / results[1].time) : 0.0);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The linked lists of dlx::v3 against the bitsets of dlx::v4 on the same
+// puzzles, best of the rounds. Both answers are verified.
+//
+template <typename SudokuTy>
+void run_sudoku_dlx_bitset_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 3)
+{
+    typedef typename SudokuTy::board_type Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: dlx::v3 (linked lists) vs dlx::v4 (bitsets), %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    dlx::v3::Solver<SudokuTy> dlx_v3;
+    dlx::v4::Solver<SudokuTy> dlx_v4;
+
+    size_t wrong_answers[2] = { 0, 0 };
+    size_t v4_nodes = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        if (!dlx_v3.solve(board) || !verify_solution(puzzles[i], board))
+            wrong_answers[0]++;
+
+        board = puzzles[i];
+        if (!dlx_v4.solve(board) || !verify_solution(puzzles[i], board))
+            wrong_answers[1]++;
+        v4_nodes += dlx::v4::Solver<SudokuTy>::get_total_search_counter();
+    }
+
+    double v3_time = time_tuning_config(dlx_v3, puzzles, rounds);
+    double v4_time = time_tuning_config(dlx_v4, puzzles, rounds);
+
+    printf("dlx::v3 : %0.3f us/puzzle, wrong answers = %u\n",
+           v3_time, (uint32_t)wrong_answers[0]);
+    printf("dlx::v4 : %0.3f us/puzzle, wrong answers = %u, nodes = %" PRIuPTR "\n",
+           v4_time, (uint32_t)wrong_answers[1], v4_nodes);
+    printf("dlx::v4 speedup = %0.2fx\n\n", (v4_time != 0.0) ? (v3_time / v4_time) : 0.0);
+
+    printf("------------------------------------------\n\n");
+}
+
+template <typename SudokuSolver>
+static void count_dlx_traffic(const std::vector<typename SudokuSolver::Board> & puzzles,
+                              size_t & wrong_answers, size_t & nodes, size_t & mems)
+{
+    typedef typename SudokuSolver::Board        Board;
+    typedef typename SudokuSolver::solver_type  solver_type;
+
+    SudokuSolver solver;
+    wrong_answers = 0;
+    nodes = 0;
+    mems = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        if (!solver.solve(board) || !verify_solution(puzzles[i], board))
+            wrong_answers++;
+        nodes += solver_type::get_total_search_counter();
+        mems += solver_type::get_num_mems();
+    }
+}
+
+//
+// The linked lists of dlx::v3 against the sparse sets of dlx::v5 (dancing
+// cells): the answers, the nodes and the mems of cover/uncover per puzzle
+// (DetailedStats), then the time (BasicStats), best of the rounds.
+//
+template <typename SudokuTy>
+void run_sudoku_dancing_cells_test(const char * filename, size_t max_puzzles = 8192, size_t rounds = 3)
+{
+    typedef typename SudokuTy::board_type Board;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: dlx::v3 (dancing links) vs dlx::v5 (dancing cells), %u puzzles, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)rounds);
+
+    static const char * names[2] = { "dlx::v3", "dlx::v5" };
+    size_t wrong_answers[2], nodes[2], mems[2];
+    count_dlx_traffic<dlx::v3::Solver<SudokuTy, DetailedStats>>(puzzles, wrong_answers[0], nodes[0], mems[0]);
+    count_dlx_traffic<dlx::v5::Solver<SudokuTy, DetailedStats>>(puzzles, wrong_answers[1], nodes[1], mems[1]);
+
+    dlx::v3::Solver<SudokuTy> dlx_v3;
+    dlx::v5::Solver<SudokuTy> dlx_v5;
+    double times[2];
+    times[0] = time_tuning_config(dlx_v3, puzzles, rounds);
+    times[1] = time_tuning_config(dlx_v5, puzzles, rounds);
+
+    double count = (puzzles.size() != 0) ? (double)puzzles.size() : 1.0;
+    for (size_t i = 0; i < 2; i++) {
+        printf("%s : %0.3f us/puzzle, %0.1f nodes/puzzle, %0.0f mems/puzzle, %0.1f mems/node, wrong answers = %u\n",
+               names[i], times[i], (double)nodes[i] / count, (double)mems[i] / count,
+               (nodes[i] != 0) ? ((double)mems[i] / nodes[i]) : 0.0, (uint32_t)wrong_answers[i]);
+    }
+    printf("dlx::v5 speedup = %0.2fx, mems = %0.2fx of dlx::v3\n\n",
+           (times[1] != 0.0) ? (times[0] / times[1]) : 0.0,
+           (mems[0] != 0) ? ((double)mems[1] / mems[0]) : 0.0);
+
+    // The multi-answer modes: the puzzles, then without their first two
+    // givens (most of them have more answers then), counted by both engines.
+    // All the answers of the solutions with their top band blanked are
+    // counted against v3, each of them has a few answers only.
+    size_t count_mismatches = 0, multi_answers = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        for (size_t pass = 0; pass < 2; pass++) {
+            size_t dlx_v3_count = dlx_v3.count_solutions(board);
+            size_t dlx_v5_count = dlx_v5.count_solutions(board);
+            if (dlx_v3_count != dlx_v5_count)
+                count_mismatches++;
+            if (dlx_v5_count > 1)
+                multi_answers++;
+
+            size_t removed = 0;
+            for (size_t pos = 0; pos < SudokuTy::BoardSize && removed < 2; pos++) {
+                if (board.cells[pos] != '.') {
+                    board.cells[pos] = '.';
+                    removed++;
+                }
+            }
+        }
+    }
+
+    static const size_t kAllAnswersPuzzles = 100;
+    v3::Solver<SudokuTy> v3_solver;
+    size_t all_mismatches = 0, all_answers = 0;
+    for (size_t i = 0; i < puzzles.size() && i < kAllAnswersPuzzles; i++) {
+        Board board = puzzles[i];
+        if (v3_solver.template search<SearchMode::OneAnswer>(board) == 0)
+            continue;
+        for (size_t pos = 0; pos < SudokuTy::Cols * SudokuTy::BoxCellsY; pos++) {
+            board.cells[pos] = '.';
+        }
+        Board temp = board;
+        size_t v3_count = v3_solver.template search<SearchMode::AllAnswers>(temp);
+        temp = board;
+        size_t dlx_v5_count = dlx_v5.template search<SearchMode::AllAnswers>(temp);
+        if (v3_count != dlx_v5_count)
+            all_mismatches++;
+        all_answers += dlx_v5_count;
+    }
+
+    printf("count_solutions(): %u boards, more than one answer = %u, mismatches = %u\n",
+           (uint32_t)(puzzles.size() * 2), (uint32_t)multi_answers, (uint32_t)count_mismatches);
+    printf("AllAnswers: %u boards, answers = %u, mismatches = %u\n\n",
+           (uint32_t)((puzzles.size() < kAllAnswersPuzzles) ? puzzles.size() : kAllAnswersPuzzles),
+           (uint32_t)all_answers, (uint32_t)all_mismatches);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The regions of the jigsaw corpus of run_sudoku_variant_test().
+//
+static const char * kJigsawRegions =
+    "000111111"
+    "000001211"
+    "033422222"
+    "634455282"
+    "633445882"
+    "633445588"
+    "663744588"
+    "663777558"
+    "667777758";
+
+template <typename SudokuSolver>
+static size_t count_wrong_answers(SudokuSolver & solver,
+                                  const std::vector<typename SudokuSolver::Board> & puzzles,
+                                  size_t & nodes)
+{
+    typedef typename SudokuSolver::Board        Board;
+    typedef typename SudokuSolver::solver_type  solver_type;
+
+    size_t wrong_answers = 0;
+    nodes = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        if (!solver.solve(board) || !solver.units().verify_solution(puzzles[i], board))
+            wrong_answers++;
+        nodes += solver_type::get_total_search_counter();
+    }
+    return wrong_answers;
+}
+
+//
+// The engines on the Units: dlx::units (bitsets) and units (bitboards).
+// First on the classic puzzles of the file against dlx::v4 and v3, the cost
+// of the generic masks. Then on a generated corpus of minimal puzzles of
+// every variant. The minimal variant puzzles have fewer clues and need
+// more search than the classic ones, so the cost of a variant is the time
+// per search node against the generated classic corpus. Best of the
+// rounds, the answers are verified against the Units.
+//
+template <typename SudokuTy>
+void run_sudoku_variant_test(const char * filename, size_t max_puzzles = 8192,
+                             size_t variant_puzzles = 1000, size_t rounds = 3)
+{
+    typedef typename SudokuTy::board_type   Board;
+    typedef Units<SudokuTy>                 units_t;
+
+    static const size_t kVariants = 4;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    printf("jmSudoku: the engines on a constraint description (Units), %u classic puzzles, "
+           "%u generated puzzles per variant, best of %u rounds\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)variant_puzzles, (uint32_t)rounds);
+
+    const units_t variants[kVariants] = {
+        units_t::classic(),
+        units_t::sudoku_x(),
+        units_t::windoku(),
+        units_t::jigsaw(kJigsawRegions)
+    };
+
+    {
+        dlx::v4::Solver<SudokuTy> dlx_v4;
+        v3::Solver<SudokuTy> solver_v3;
+        dlx::units::Solver<SudokuTy> dlx_units(variants[0]);
+        units::Solver<SudokuTy> units_solver(variants[0]);
+
+        size_t wrong_answers[2], nodes[2];
+        wrong_answers[0] = count_wrong_answers(dlx_units, puzzles, nodes[0]);
+        wrong_answers[1] = count_wrong_answers(units_solver, puzzles, nodes[1]);
+
+        double dlx_v4_time = time_tuning_config(dlx_v4, puzzles, rounds);
+        double v3_time = time_tuning_config(solver_v3, puzzles, rounds);
+        double dlx_units_time = time_tuning_config(dlx_units, puzzles, rounds);
+        double units_time = time_tuning_config(units_solver, puzzles, rounds);
+
+        printf("classic file : dlx::units %0.3f us/puzzle (speed %0.2fx of dlx::v4), "
+               "units %0.3f us/puzzle (speed %0.2fx of v3), wrong answers = %u, %u\n\n",
+               dlx_units_time, (dlx_units_time != 0.0) ? (dlx_v4_time / dlx_units_time) : 0.0,
+               units_time, (units_time != 0.0) ? (v3_time / units_time) : 0.0,
+               (uint32_t)wrong_answers[0], (uint32_t)wrong_answers[1]);
+    }
+
+    static const char * names[2] = { "dlx::units", "units" };
+    double classic_node_times[2] = { 0.0, 0.0 };
+    for (size_t variant = 0; variant < kVariants; variant++) {
+        const units_t & units = variants[variant];
+        if (!units.is_compiled()) {
+            printf("%-10s : the Units are invalid\n", units.name());
+            continue;
+        }
+
+        UnitsGenerator<SudokuTy> generator(units, 20211018U + (uint32_t)variant);
+        std::vector<Board> corpus(variant_puzzles);
+        size_t total_clues = 0;
+        jtest::StopWatch sw;
+        sw.start();
+        for (size_t i = 0; i < variant_puzzles; i++) {
+            total_clues += generator.generate(corpus[i]);
+        }
+        sw.stop();
+        double generate_time = sw.getElapsedMillisec();
+
+        dlx::units::Solver<SudokuTy> dlx_units(units);
+        units::Solver<SudokuTy> units_solver(units);
+
+        size_t wrong_answers[2], nodes[2];
+        wrong_answers[0] = count_wrong_answers(dlx_units, corpus, nodes[0]);
+        wrong_answers[1] = count_wrong_answers(units_solver, corpus, nodes[1]);
+
+        double times[2], node_times[2];
+        times[0] = time_tuning_config(dlx_units, corpus, rounds);
+        times[1] = time_tuning_config(units_solver, corpus, rounds);
+
+        printf("%-10s : %0.1f clues, generated in %0.1f ms\n", units.name(),
+               (variant_puzzles != 0) ? ((double)total_clues / variant_puzzles) : 0.0, generate_time);
+        for (size_t i = 0; i < 2; i++) {
+            double nodes_per_puzzle = (variant_puzzles != 0) ? ((double)nodes[i] / variant_puzzles) : 0.0;
+            node_times[i] = (nodes_per_puzzle != 0.0) ? (times[i] * 1000.0 / nodes_per_puzzle) : 0.0;
+            if (variant == 0)
+                classic_node_times[i] = node_times[i];
+            printf("    %-10s : %0.3f us/puzzle, %0.1f nodes/puzzle, %0.1f ns/node (%0.2fx of classic), "
+                   "wrong answers = %u\n",
+                   names[i], times[i], nodes_per_puzzle, node_times[i],
+                   (classic_node_times[i] != 0.0) ? (node_times[i] / classic_node_times[i]) : 0.0,
+                   (uint32_t)wrong_answers[i]);
+        }
+    }
+    printf("\n");
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// The row/col/box views of the v3 state, derived from box_cell_nums by the
+// pext/pdep and transpose kernels, on the states of the puzzles and of the
+// puzzles with some of the empty cells filled from their solution. Then
+// the cost of deriving the views against the cost of a search node, and
+// the bytes that the redundant views take.
+//
+template <typename SudokuTy>
+void run_sudoku_layout_test(const char * filename, size_t max_puzzles = 4096,
+                            size_t fill_step = 8, size_t repeats = 2000)
+{
+    typedef typename SudokuTy::board_type           Board;
+    typedef v3::Solver<SudokuTy>                    SolverTy;
+    typedef typename SolverTy::state_type           state_type;
+    typedef BasicSolver<SudokuTy>                   basic_solver_t;
+
+    static const size_t kTimedStates = 256;
+
+    std::vector<Board> puzzles;
+    load_sudoku_puzzles<SudokuTy>(filename, puzzles);
+    if (puzzles.size() > max_puzzles)
+        puzzles.resize(max_puzzles);
+
+    SolverTy solver;
+
+    size_t states = 0, mismatches = 0;
+    std::vector<state_type> timed_states;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board answer = puzzles[i];
+        if (solver.template search<SearchMode::OneAnswer>(answer) == 0)
+            continue;
+        Board board = puzzles[i];
+        size_t filled = 0;
+        for (size_t pos = 0; pos <= SudokuTy::BoardSize; pos++) {
+            if (pos == SudokuTy::BoardSize || (board.cells[pos] == '.' && (filled++ % fill_step) == 0)) {
+                Board temp = board;
+                solver.init_board_simd(temp);
+                if (!solver.check_derived_views())
+                    mismatches++;
+                if (timed_states.size() < kTimedStates)
+                    timed_states.push_back(solver.state());
+                states++;
+            }
+            if (pos < SudokuTy::BoardSize)
+                board.cells[pos] = answer.cells[pos];
+        }
+    }
+
+    printf("jmSudoku: dfs::v3 candidate layouts, %u puzzles, %u states\n\n",
+           (uint32_t)puzzles.size(), (uint32_t)states);
+
+    alignas(32) state_type derived;
+    std::memset((void *)&derived, 0, sizeof(derived));
+    uint32_t checksum = 0;
+    size_t timed = timed_states.size() * repeats;
+    jtest::StopWatch sw;
+
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < timed_states.size(); i++) {
+            SolverTy::derive_views(timed_states[i], derived);
+            checksum += ((const uint32_t *)&derived)[(i * 97) % (sizeof(state_type) / 4)];
+        }
+    }
+    sw.stop();
+    double all_nums_ns = (timed != 0) ? (sw.getElapsedMillisec() * 1000000.0 / timed) : 0.0;
+
+    sw.start();
+    for (size_t n = 0; n < repeats; n++) {
+        for (size_t i = 0; i < timed_states.size(); i++) {
+            SolverTy::derive_num_views(timed_states[i], derived, i % SudokuTy::Numbers);
+            checksum += ((const uint32_t *)&derived)[(i * 97) % (sizeof(state_type) / 4)];
+        }
+    }
+    sw.stop();
+    double one_num_ns = (timed != 0) ? (sw.getElapsedMillisec() * 1000000.0 / timed) : 0.0;
+
+    size_t nodes = 0;
+    sw.start();
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        Board board = puzzles[i];
+        solve_puzzle(solver, board);
+        nodes += basic_solver_t::get_num_guesses() + basic_solver_t::get_num_unique_candidate();
+    }
+    sw.stop();
+    double node_ns = (nodes != 0) ? (sw.getElapsedMillisec() * 1000000.0 / nodes) : 0.0;
+
+    // The three [num] views of a fill: saved, masked, updated and restored.
+    size_t view_bytes = sizeof(PackedBitSet2D<SolverTy::Rows16, SolverTy::Cols16>);
+    size_t primary_bytes = sizeof(solver.state().box_cell_nums);
+    printf("state: 4 views = %u bytes, box_cell_nums only = %u bytes (%0.1fx smaller)\n",
+           (uint32_t)sizeof(state_type), (uint32_t)primary_bytes,
+           (double)sizeof(state_type) / primary_bytes);
+    printf("per fill, the row/col/box views move %u bytes (save + mask + update + restore)\n\n",
+           (uint32_t)(view_bytes * 3 * 4));
+    printf("derive_views()     : %8.1f ns/state (all nums)\n", all_nums_ns);
+    printf("derive_num_views() : %8.1f ns/num\n", one_num_ns);
+    printf("solve()            : %8.1f ns/node, %u nodes\n", node_ns, (uint32_t)nodes);
+    printf("mismatches = %u / %u states, checksum = %08X\n\n",
+           (uint32_t)mismatches, (uint32_t)states, checksum);
+
+    printf("------------------------------------------\n\n");
+}
+
+//
+// jmSudoku --stream [threads] < puzzles.txt > answers.txt
+//
+// The stdout only gets the answers, the stats are printed to the stderr.
+//
+template <typename SudokuSolver>
+int run_sudoku_stream(size_t threads)
+{
+    typedef StreamFilter<SudokuSolver> stream_filter_t;
+
+    StreamFilter<SudokuSolver> filter(threads);
+
+    jtest::StopWatch sw;
+    sw.start();
+    bool success = filter.run(stdin, stdout);
+    sw.stop();
+    double elapsed_time = sw.getElapsedMillisec();
+
+    const typename stream_filter_t::Stats & stats = filter.stats();
+    fprintf(stderr, "jmSudoku: stream, threads = %u, puzzles = %u", (uint32_t)threads, (uint32_t)stats.puzzles);
+    for (size_t i = 0; i < stream_filter_t::StatusLast; i++) {
+        fprintf(stderr, ", %s = %u", stream_filter_t::status_name(i), (uint32_t)stats.status[i]);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Total elapsed time: %0.3f ms, %0.1f puzzles/sec\n",
+            elapsed_time, (elapsed_time != 0.0) ? (stats.puzzles / (elapsed_time / 1000.0)) : 0.0);
+    if (!success)
+        fprintf(stderr, "jmSudoku: stream, read or write error\n");
+
+    return (success ? 0 : 1);
+}
+
+int main(int argc, char * argv[])
+{
+    const char * filename = nullptr;
+    const char * out_file = nullptr;
+    if (argc > 2) {
+        filename = argv[1];
+        out_file = argv[2];
+    }
+    else if (argc > 1) {
+        filename = argv[1];
+    }
+
+    if (filename != nullptr && (strcmp(filename, "--stream") == 0 || strcmp(filename, "-") == 0)) {
+        size_t threads;
+        if (out_file != nullptr) {
+            threads = (size_t)atoi(out_file);
+        }
+        else {
+            threads = std::thread::hardware_concurrency();
+            if (threads <= 1)
+                threads = 0;
+        }
+
+        Sudoku::initialize();
+        int exit_code = run_sudoku_stream<v3::Solver<Sudoku>>(threads);
+        Sudoku::finalize();
+        return exit_code;
+    }
+
+    jtest::CPU::warmup(1000);
+
+    Sudoku::initialize();
+
+    v4::Solver<Sudoku> solver;
+
+    if (1)
+    {
+        if (filename == nullptr) {
+            run_a_testcase(TEST_CASE_INDEX);
+        }
+    }
+
+    if (0)
+    {
+        if (filename != nullptr) {
+#ifdef NDEBUG
+            run_sudoku_test<dlx::v1::Solver<Sudoku>>(filename, "dlx::v1");
+            run_sudoku_test<dlx::v2::Solver<Sudoku>>(filename, "dlx::v2");
+#endif
+            run_sudoku_test<dlx::v3::Solver<Sudoku>>(filename, "dlx::v3");
+            run_sudoku_test<dlx::v4::Solver<Sudoku>>(filename, "dlx::v4");
+            run_sudoku_test<dlx::v5::Solver<Sudoku>>(filename, "dlx::v5");
+
+            run_sudoku_test<v1::Solver<Sudoku>>(filename, "dfs::v1");
+            run_sudoku_test<v2::Solver<Sudoku>>(filename, "dfs::v2");
+            run_sudoku_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
+            run_sudoku_test<v3b::Solver<Sudoku>>(filename, "dfs::v3b");
+            run_sudoku_test<v3e::Solver<Sudoku>>(filename, "dfs::v3e");
+            run_sudoku_test<v3::Solver<Sudoku>>(filename, "dfs::v3");
+        }
+    }
+    else
+    {
+        if (filename != nullptr) {
+            run_sudoku_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
+            run_sudoku_test<v3b::Solver<Sudoku>>(filename, "dfs::v3b");
+            run_sudoku_test<v3::Solver<Sudoku>, true>(filename, "dfs::v3");
+        }
+    }
+
+    if (kEnableCacheTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_cache_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
+        }
+    }
+
+    if (kEnableSessionTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_session_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
+        }
+    }
+
+    if (kEnableGraderTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_grader_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableBatchTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_batch_test<v3a::Solver<Sudoku>>(filename, "dfs::v3a");
+        }
+    }
+
+    if (kEnableParallelTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_parallel_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnablePortfolioTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_portfolio_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableBudgetTest)
+    {
+        if (filename != nullptr) {
+            printf("jmSudoku: SearchControl budget\n\n");
+            run_sudoku_budget_test<v1::Solver<Sudoku>>(filename, "dfs::v1");
+            run_sudoku_budget_test<v2::Solver<Sudoku>>(filename, "dfs::v2");
+            run_sudoku_budget_test<v3e::Solver<Sudoku>>(filename, "dfs::v3e");
+            run_sudoku_budget_test<v3::Solver<Sudoku>>(filename, "dfs::v3");
+            run_sudoku_budget_test<dlx::v3::Solver<Sudoku>>(filename, "dlx::v3");
+            // The deadline counts the polls of the control, not the guesses,
+            // so it must stop the searches of NoStats too (max guesses can't).
+            run_sudoku_budget_test<v3::Solver<Sudoku, v3::DefaultPolicy, NoStats>>(filename, "v3/none");
+            run_sudoku_budget_test<dlx::v3::Solver<Sudoku, NoStats>>(filename, "dlx/none");
+            printf("------------------------------------------\n\n");
+        }
+    }
+
+    if (kEnableRouterTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_router_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableCheckTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_check_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableInitBoardTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_init_board_tests<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableLazySelectTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_lazy_select_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableTuningTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_tuning_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableStatsTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_stats_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableEnumerateTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_enumerate_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableMinimalTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_minimal_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableLayoutTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_layout_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableCompactStateTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_compact_state_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableBacktrackTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_backtrack_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableDlxBitsetTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_dlx_bitset_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableDancingCellsTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_dancing_cells_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableVariantTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_variant_test<Sudoku>(filename);
+        }
+    }
+
+    if (kEnableGeneratorTest)
+    {
+        if (filename != nullptr) {
+            run_sudoku_generator_test<v3::Solver<Sudoku>>(out_file, "dfs::v3");
         }
     }
 
@@ -0,0 +1,351 @@
+
+#ifndef JM_SUDOKU_MINIMAL_H
+#define JM_SUDOKU_MINIMAL_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memcpy()
+#include <atomic>
+
+#include "Sudoku.h"
+#include "BasicSolver.h"
+#include "BitUtils.h"
+#include "PackedBitSet.h"
+#include "SudokuSolver_v3.h"
+#include "SudokuBatch.h"
+
+//
+// Minimality check of the puzzles: a puzzle with a unique solution is
+// minimal if removing any one of its clues makes the solution non-unique.
+//
+// The solution S is found once. Any other solution of the puzzle without
+// the clue at pos has another number at pos, so the clue is necessary if
+// one of the other candidates of pos has a solution (one OneAnswer search
+// for each, until the first solution), and redundant if none of them has.
+//
+// The clues are split into ranges, one task of the BatchRunner for each.
+// A task calls init_board() once, on the puzzle without the clues of its
+// range, and then puts them back by the incremental updates of the v3
+// bitboards (the same as Session::place()). The range is halved: the right
+// half is placed and the left half is checked, then the other way round,
+// so every clue is checked with all the other clues placed and a range of
+// n clues costs O(n log n) placements. The first redundant clue stops the
+// other tasks and their searches by a SearchControl.
+//
+namespace jmSudoku {
+namespace v3 {
+
+template <typename SudokuTy>
+class MinimalChecker {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef Solver<SudokuTy>                    solver_type;
+    typedef typename solver_type::Board         Board;
+    typedef typename sudoku_t::CellInfo         CellInfo;
+    typedef BatchRunner<solver_type>            runner_type;
+
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t Numbers16 = solver_type::Numbers16;
+
+    struct Stats {
+        size_t  puzzles;
+        size_t  minimal;
+        size_t  placements;         // Incremental placements of the clues
+        size_t  searches;           // Searches of the other candidates
+    };
+
+private:
+    typedef typename solver_type::State         State;
+    typedef typename solver_type::Count         Count;
+    typedef typename solver_type::RecoverState  RecoverState;
+
+    // RecoverState is declared in a packed region, so the alignment of its
+    // SIMD members must be restored for the array of placements.
+    struct alignas(32) Placement {
+        RecoverState                recover_state;
+        PackedBitSet<Numbers16>     save_num_bits;
+        uint32_t                    min_literal_size;
+        uint32_t                    min_literal_index;
+        uint8_t                     pos, num;
+    };
+
+    // The state of one task, on the stack of its worker.
+    struct alignas(32) Context {
+        solver_type *   solver;
+        Placement       placements[BoardSize + 1];
+        size_t          placement_count;
+        size_t          empties;
+        State           saved_state;
+        Count           saved_count;
+        Board           scratch;
+        const Board *   solution;
+        SearchControl * control;
+        size_t          num_placements;
+        size_t          num_searches;
+    };
+
+    runner_type     runner_;
+    SearchControl   control_;
+    Stats           stats_;
+
+    solver_type     solver_;
+
+public:
+    MinimalChecker(size_t threads = 1) : runner_(threads) {
+        this->reset_stats();
+    }
+    ~MinimalChecker() {}
+
+    size_t threads() const { return this->runner_.threads(); }
+    const Stats & stats() const { return this->stats_; }
+
+    void reset_stats() {
+        std::memset((void *)&this->stats_, 0, sizeof(this->stats_));
+    }
+
+    //
+    // Returns true if the puzzle has a unique solution and every clue of it
+    // is necessary. redundant_pos gets the first redundant clue found, or
+    // size_t(-1).
+    //
+    bool is_minimal(const Board & puzzle, size_t & redundant_pos) {
+        redundant_pos = size_t(-1);
+        this->stats_.puzzles++;
+
+        // count_solutions() rejects the inconsistent boards.
+        if (this->solver_.count_solutions(puzzle) != 1)
+            return false;
+        Board solution = this->solver_.answers()[0];
+
+        uint8_t clues[BoardSize];
+        size_t clue_count = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (puzzle.cells[pos] != '.')
+                clues[clue_count++] = (uint8_t)pos;
+        }
+
+        size_t tasks = this->runner_.threads();
+        if (tasks > clue_count)
+            tasks = clue_count;
+
+        std::atomic<size_t> redundant(size_t(-1));
+        std::atomic<size_t> placements(0);
+        std::atomic<size_t> searches(0);
+
+        if (tasks <= 1) {
+            Context ctx;
+            redundant_pos = this->check_range(ctx, this->solver_, nullptr, puzzle, solution,
+                                              clues, 0, clue_count);
+            placements += ctx.num_placements;
+            searches += ctx.num_searches;
+        }
+        else {
+            this->control_.reset();
+            this->control_.set_max_guesses(0);
+            this->runner_.run_tasks(tasks, [&](solver_type & solver, size_t index) {
+                if (this->control_.is_stopped())
+                    return;
+                size_t first = clue_count * index / tasks;
+                size_t last = clue_count * (index + 1) / tasks;
+                Context ctx;
+                size_t found = this->check_range(ctx, solver, &this->control_, puzzle, solution,
+                                                 clues, first, last);
+                placements.fetch_add(ctx.num_placements, std::memory_order_relaxed);
+                searches.fetch_add(ctx.num_searches, std::memory_order_relaxed);
+                if (found != size_t(-1)) {
+                    size_t expected = size_t(-1);
+                    redundant.compare_exchange_strong(expected, found);
+                    this->control_.stop();
+                }
+            });
+            redundant_pos = redundant.load();
+        }
+
+        this->stats_.placements += placements.load();
+        this->stats_.searches += searches.load();
+        if (redundant_pos != size_t(-1))
+            return false;
+
+        this->stats_.minimal++;
+        return true;
+    }
+
+    bool is_minimal(const Board & puzzle) {
+        size_t redundant_pos;
+        return this->is_minimal(puzzle, redundant_pos);
+    }
+
+private:
+    // Returns the pos of a redundant clue of [first, last), or size_t(-1).
+    size_t check_range(Context & ctx, solver_type & solver, SearchControl * control,
+                       const Board & puzzle, const Board & solution,
+                       const uint8_t * clues, size_t first, size_t last) {
+        ctx.solver = &solver;
+        ctx.placement_count = 0;
+        ctx.solution = &solution;
+        ctx.control = control;
+        ctx.num_placements = 0;
+        ctx.num_searches = 0;
+
+        // One init_board() for the clues outside of the range.
+        Board board = puzzle;
+        for (size_t i = first; i < last; i++) {
+            board.cells[clues[i]] = '.';
+        }
+        solver.init_board(board);
+        ctx.empties = solver.calc_empties(board);
+
+        solver.set_control(control);
+        size_t found = this->leave_one_out(ctx, puzzle, clues, first, last);
+        solver.set_control(nullptr);
+        return found;
+    }
+
+    // Every clue of [first, last) is checked with all the other clues placed.
+    size_t leave_one_out(Context & ctx, const Board & puzzle, const uint8_t * clues,
+                         size_t first, size_t last) {
+        if (ctx.control != nullptr && ctx.control->is_stopped())
+            return size_t(-1);
+        if ((last - first) == 1) {
+            size_t pos = clues[first];
+            return (this->is_redundant(ctx, pos) ? pos : size_t(-1));
+        }
+
+        size_t mid = (first + last) / 2;
+        size_t found = this->leave_one_out_half(ctx, puzzle, clues, first, mid, mid, last);
+        if (found == size_t(-1))
+            found = this->leave_one_out_half(ctx, puzzle, clues, mid, last, first, mid);
+        return found;
+    }
+
+    // Places the clues of [place_first, place_last) and checks [first, last).
+    size_t leave_one_out_half(Context & ctx, const Board & puzzle, const uint8_t * clues,
+                              size_t first, size_t last,
+                              size_t place_first, size_t place_last) {
+        size_t placed = 0;
+        for (size_t i = place_first; i < place_last; i++) {
+            size_t pos = clues[i];
+            if (this->place(ctx, pos, (size_t)(puzzle.cells[pos] - '1')))
+                placed++;
+        }
+        size_t found = size_t(-1);
+        // A clue that can't be placed is not a candidate any more, the
+        // puzzle has no solution then, but it was checked to have one.
+        if (placed == (place_last - place_first))
+            found = this->leave_one_out(ctx, puzzle, clues, first, last);
+        for (size_t i = 0; i < placed; i++) {
+            this->unplace(ctx);
+        }
+        return found;
+    }
+
+    // Without the clue, no other number at pos has a solution.
+    bool is_redundant(Context & ctx, size_t pos) {
+        solver_type & solver = *ctx.solver;
+        const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+        size_t solution_num = (size_t)(ctx.solution->cells[pos] - '1');
+
+        size_t num_bits = solver.state_.box_cell_nums[cellInfo.box][cellInfo.cell].to_ulong();
+        num_bits &= ~((size_t)1 << solution_num);
+        while (num_bits != 0) {
+            size_t num_bit = BitUtils::ls1b(num_bits);
+            size_t num = BitUtils::bsf(num_bit);
+            num_bits ^= num_bit;
+
+            bool is_placed = this->place(ctx, pos, num);
+            assert(is_placed);
+            (void)is_placed;
+            bool success = this->search(ctx);
+            this->unplace(ctx);
+            if (success)
+                return false;
+        }
+        return true;
+    }
+
+    bool search(Context & ctx) {
+        solver_type & solver = *ctx.solver;
+        if (ctx.empties == 0)
+            return true;
+        if (solver.count_.min_literal_size == 0)
+            return false;
+
+        ctx.num_searches++;
+
+        // The recursive search doesn't unwind the bitboards on success.
+        std::memcpy((void *)&ctx.saved_state, (const void *)&solver.state_, sizeof(State));
+        std::memcpy((void *)&ctx.saved_count, (const void *)&solver.count_, sizeof(Count));
+
+        bool success = solver.template solve<SearchMode::OneAnswer>(ctx.scratch, ctx.empties,
+                                                                   solver.count_.min_literal_size,
+                                                                   solver.count_.min_literal_index);
+
+        std::memcpy((void *)&solver.state_, (const void *)&ctx.saved_state, sizeof(State));
+        std::memcpy((void *)&solver.count_, (const void *)&ctx.saved_count, sizeof(Count));
+        return success;
+    }
+
+    // num: [0, Numbers), false if it's not a candidate of the cell.
+    bool place(Context & ctx, size_t pos, size_t num) {
+        solver_type & solver = *ctx.solver;
+        const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+        size_t box = cellInfo.box;
+        size_t cell = cellInfo.cell;
+        if (!solver.state_.box_cell_nums[box][cell].test(num))
+            return false;
+
+        assert(ctx.placement_count < BoardSize + 1);
+        Placement & placement = ctx.placements[ctx.placement_count++];
+        placement.pos = (uint8_t)pos;
+        placement.num = (uint8_t)num;
+        placement.min_literal_size = solver.count_.min_literal_size;
+        placement.min_literal_index = solver.count_.min_literal_index;
+
+        solver.doFillNum(pos, cellInfo.row, cellInfo.col, box, cell, num,
+                         placement.save_num_bits, placement.recover_state);
+        solver.updateNeighborCellsEffect(placement.recover_state, pos, box, num);
+
+        uint32_t min_literal_index = 0;
+        uint32_t min_literal_size = solver.count_delta_literal_size(min_literal_index,
+                                        placement.recover_state, placement.save_num_bits, box);
+        solver.count_.min_literal_size = min_literal_size;
+        solver.count_.min_literal_index = min_literal_index;
+
+        ctx.empties--;
+        ctx.num_placements++;
+        return true;
+    }
+
+    void unplace(Context & ctx) {
+        solver_type & solver = *ctx.solver;
+        assert(ctx.placement_count > 0);
+        Placement & placement = ctx.placements[--ctx.placement_count];
+        size_t pos = placement.pos;
+        size_t num = placement.num;
+        const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+        size_t box = cellInfo.box;
+
+        solver.restoreNeighborCellsEffect(placement.recover_state, box, num);
+        solver.undoFillNum(pos, cellInfo.row, cellInfo.col, box, cellInfo.cell, num,
+                           placement.save_num_bits, placement.recover_state);
+
+        solver.count_.min_literal_size = placement.min_literal_size;
+        solver.count_.min_literal_index = placement.min_literal_index;
+        ctx.empties++;
+    }
+};
+
+} // namespace v3
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_MINIMAL_H
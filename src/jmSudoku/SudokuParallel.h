@@ -0,0 +1,230 @@
+
+#ifndef JM_SUDOKU_PARALLEL_H
+#define JM_SUDOKU_PARALLEL_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+#include "Sudoku.h"
+#include "BasicSolver.h"
+#include "SudokuSolver_v3.h"
+#include "SudokuBatch.h"
+
+//
+// Parallel search of one puzzle.
+//
+// The search tree is split at a shallow depth: the cell with the fewest
+// candidates is filled with each of its candidates, level by level, until
+// there are tasks_per_thread * threads subproblems. The subproblems run on
+// the work-stealing BatchRunner, every worker searches them with its own
+// v3 solver from init_board().
+//
+// OneAnswer: the first answer stops the other solvers by a SearchControl.
+// MoreThanOneAnswer: the search stops when 2 answers are found in total.
+// AllAnswers: the numbers of the answers of the subproblems are added up,
+// the answers are enumerate()d and not stored.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+class ParallelSearch {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef v3::Solver<SudokuTy>                solver_type;
+    typedef BatchRunner<solver_type>            runner_type;
+
+    static const size_t Rows = sudoku_t::Rows;
+    static const size_t Cols = sudoku_t::Cols;
+    static const size_t Boxes = sudoku_t::Boxes;
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+
+    static const size_t kMaxSplitDepth = 8;
+
+    struct Stats {
+        size_t  split_depth;
+        size_t  subproblems;
+        size_t  searched;           // Subproblems that were searched
+        size_t  skipped;            // Subproblems skipped after the stop
+    };
+
+private:
+    runner_type     runner_;
+    size_t          tasks_per_thread_;
+    SearchControl   control_;
+    Stats           stats_;
+
+public:
+    ParallelSearch(size_t threads = 0, size_t tasks_per_thread = 16)
+        : runner_(threads), tasks_per_thread_((tasks_per_thread != 0) ? tasks_per_thread : 1) {
+        std::memset((void *)&this->stats_, 0, sizeof(this->stats_));
+    }
+    ~ParallelSearch() {}
+
+    size_t threads() const { return this->runner_.threads(); }
+    const Stats & stats() const { return this->stats_; }
+    const runner_type & runner() const { return this->runner_; }
+
+    //
+    // Returns the number of the answers (2 means more than one in the
+    // MoreThanOneAnswer mode), the board gets the first answer found.
+    //
+    template <size_t nSearchMode>
+    size_t search(Board & board) {
+        std::memset((void *)&this->stats_, 0, sizeof(this->stats_));
+        if (check_board(board) != BoardCheck::BoardValid)
+            return 0;
+
+        std::vector<Board> subproblems;
+        this->stats_.split_depth = this->split(board, this->tasks_per_thread_ * this->threads(),
+                                               subproblems);
+        this->stats_.subproblems = subproblems.size();
+
+        this->control_.reset();
+        std::atomic<size_t> total_answers(0);
+        std::atomic<size_t> searched(0);
+        std::mutex answer_mutex;
+        bool has_answer = false;
+        Board answer;
+
+        this->runner_.run_tasks(subproblems.size(), [&](solver_type & solver, size_t index) {
+            if (nSearchMode != SearchMode::AllAnswers && this->control_.is_stopped())
+                return;
+            searched.fetch_add(1, std::memory_order_relaxed);
+
+            Board temp = subproblems[index];
+            solver.set_control(&this->control_);
+            size_t answers;
+            if (nSearchMode == SearchMode::AllAnswers) {
+                // Only the first answer is kept, the others are just counted.
+                bool has_first = false;
+                auto visitor = [&temp, &has_first](const Board & answer) -> bool {
+                    if (!has_first) {
+                        temp = answer;
+                        has_first = true;
+                    }
+                    return true;
+                };
+                answers = solver.enumerate(subproblems[index], visitor);
+            }
+            else {
+                answers = solver.template search<nSearchMode>(temp);
+            }
+            solver.set_control(nullptr);
+            if (answers == 0)
+                return;
+
+            size_t total = total_answers.fetch_add(answers, std::memory_order_relaxed) + answers;
+            if (nSearchMode == SearchMode::OneAnswer ||
+                (nSearchMode == SearchMode::MoreThanOneAnswer && total > 1)) {
+                this->control_.stop();
+            }
+
+            std::lock_guard<std::mutex> lock(answer_mutex);
+            if (!has_answer) {
+                answer = (nSearchMode == SearchMode::MoreThanOneAnswer) ? solver.answers()[0] : temp;
+                has_answer = true;
+            }
+        });
+
+        this->stats_.searched = searched.load();
+        this->stats_.skipped = subproblems.size() - this->stats_.searched;
+
+        size_t total = total_answers.load();
+        if (nSearchMode == SearchMode::OneAnswer && total > 1)
+            total = 1;
+        else if (nSearchMode == SearchMode::MoreThanOneAnswer && total > 2)
+            total = 2;
+        if (has_answer)
+            board = answer;
+        return total;
+    }
+
+private:
+    // The empty cell with the fewest candidates, false if the board is filled.
+    static bool find_min_cell(const Board & board, size_t & min_pos, uint32_t & min_cands) {
+        uint32_t rows[Rows] = { 0 };
+        uint32_t cols[Cols] = { 0 };
+        uint32_t boxes[Boxes] = { 0 };
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            char val = board.cells[pos];
+            if (val != '.') {
+                uint32_t num_bit = 1U << (val - '1');
+                const typename sudoku_t::CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                rows[cellInfo.row] |= num_bit;
+                cols[cellInfo.col] |= num_bit;
+                boxes[cellInfo.box] |= num_bit;
+            }
+        }
+
+        size_t min_size = size_t(-1);
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (board.cells[pos] == '.') {
+                const typename sudoku_t::CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                uint32_t cands = ~(rows[cellInfo.row] | cols[cellInfo.col] | boxes[cellInfo.box]) &
+                                 (uint32_t)sudoku_t::kAllNumberBits;
+                size_t size = BitUtils::popcnt32(cands);
+                if (size < min_size) {
+                    min_size = size;
+                    min_pos = pos;
+                    min_cands = cands;
+                    if (size == 0)
+                        break;
+                }
+            }
+        }
+        return (min_size != size_t(-1));
+    }
+
+    // Returns the split depth.
+    size_t split(const Board & board, size_t target, std::vector<Board> & subproblems) {
+        subproblems.clear();
+        subproblems.push_back(board);
+
+        size_t depth = 0;
+        std::vector<Board> next;
+        while (subproblems.size() < target && depth < kMaxSplitDepth) {
+            next.clear();
+            bool is_expanded = false;
+            for (size_t i = 0; i < subproblems.size(); i++) {
+                const Board & problem = subproblems[i];
+                size_t min_pos;
+                uint32_t min_cands;
+                if (!find_min_cell(problem, min_pos, min_cands)) {
+                    // A filled board is a subproblem of its own.
+                    next.push_back(problem);
+                    continue;
+                }
+                while (min_cands != 0) {
+                    size_t num = BitUtils::bsf(min_cands);
+                    min_cands &= min_cands - 1;
+                    next.push_back(problem);
+                    next.back().cells[min_pos] = (char)('1' + num);
+                }
+                is_expanded = true;
+            }
+            subproblems.swap(next);
+            if (!is_expanded)
+                break;
+            depth++;
+        }
+        return depth;
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_PARALLEL_H
@@ -0,0 +1,238 @@
+
+#ifndef JM_SUDOKU_PORTFOLIO_H
+#define JM_SUDOKU_PORTFOLIO_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "Sudoku.h"
+#include "BasicSolver.h"
+#include "SudokuSolver_v3.h"
+#include "SudokuSolver_dlx_v3.h"
+
+//
+// Solver portfolio for the tail latency.
+//
+// Every puzzle is solved by the default v3 solver with a budget of guesses
+// first. Most of the puzzles finish within the budget, and cost no more than
+// the bare v3 solver. When the budget runs out, the puzzle is raced: v3
+// searches it again without a budget on the calling thread, and dlx::v3
+// searches it on a helper thread. The first answer wins, the other solver
+// is cancelled by the shared SearchControl, which both of them poll at every
+// node of their recursion.
+//
+// The helper thread lives as long as the portfolio, so a race only costs a
+// wake up and not a thread creation.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+class Portfolio {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef v3::Solver<SudokuTy>                solver_type;
+    typedef dlx::v3::Solver<SudokuTy>           racer_type;
+    typedef BasicSolver<SudokuTy>               basic_solver_t;
+    typedef dlx::v3::DancingLinks<SudokuTy>     dancing_links_t;
+
+    static const size_t kDefaultMaxGuesses = 256;
+
+    enum Winner {
+        NoWinner,
+        InBudget,           // v3 within the budget
+        RaceSolver,         // v3 won the race
+        RaceRacer,          // dlx::v3 won the race
+        WinnerLast
+    };
+
+    struct Stats {
+        size_t  puzzles;
+        size_t  in_budget;
+        size_t  races;
+        size_t  solver_wins;
+        size_t  racer_wins;
+        size_t  no_solution;
+    };
+
+private:
+    solver_type                 solver_;
+    size_t                      max_guesses_;
+    SearchControl               control_;
+    Stats                       stats_;
+
+    std::mutex                  mutex_;
+    std::condition_variable     task_cond_;
+    std::condition_variable     done_cond_;
+    bool                        has_task_;
+    bool                        is_done_;
+    bool                        has_winner_;
+    bool                        quit_;
+    Winner                      winner_;
+    Board                       race_board_;
+    Board                       answer_;
+
+    std::thread                 racer_thread_;
+
+public:
+    Portfolio(size_t max_guesses = kDefaultMaxGuesses)
+        : max_guesses_((max_guesses != 0) ? max_guesses : kDefaultMaxGuesses),
+          has_task_(false), is_done_(false), has_winner_(false), quit_(false), winner_(NoWinner) {
+        this->reset_stats();
+        // The solver has initialized the shared mask tables, start the racer.
+        this->racer_thread_ = std::thread(&Portfolio::racer_loop, this);
+    }
+
+    ~Portfolio() {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->quit_ = true;
+        }
+        this->task_cond_.notify_one();
+        this->racer_thread_.join();
+    }
+
+    size_t max_guesses() const { return this->max_guesses_; }
+    void set_max_guesses(size_t max_guesses) {
+        this->max_guesses_ = (max_guesses != 0) ? max_guesses : kDefaultMaxGuesses;
+    }
+
+    const Stats & stats() const { return this->stats_; }
+    Winner last_winner() const { return this->winner_; }
+
+    void reset_stats() {
+        std::memset((void *)&this->stats_, 0, sizeof(this->stats_));
+    }
+
+    static const char * winner_name(size_t winner) {
+        static const char * names[WinnerLast] = {
+            "none", "v3 in budget", "v3 in race", "dlx::v3 in race"
+        };
+        return (winner < WinnerLast) ? names[winner] : "unknown";
+    }
+
+    //
+    // The board gets the answer, returns false if there is no answer.
+    //
+    bool solve(Board & board) {
+        this->stats_.puzzles++;
+        this->winner_ = NoWinner;
+        if (check_board(board) != BoardCheck::BoardValid) {
+            this->stats_.no_solution++;
+            return false;
+        }
+
+        solver_type & solver = this->solver_;
+        this->control_.reset();
+        this->control_.set_max_guesses(this->max_guesses_);
+        solver.set_control(&this->control_);
+
+        Board temp = board;
+        size_t answers = solver.template search<SearchMode::OneAnswer>(temp);
+        if (answers != 0 || !this->control_.is_budget_exceeded()) {
+            // Finished within the budget.
+            solver.set_control(nullptr);
+            if (answers != 0) {
+                board = temp;
+                this->winner_ = InBudget;
+                this->stats_.in_budget++;
+                return true;
+            }
+            else {
+                this->stats_.no_solution++;
+                return false;
+            }
+        }
+
+        // Race v3 and dlx::v3 without a budget.
+        this->stats_.races++;
+        this->control_.reset();
+        this->control_.set_max_guesses(0);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->race_board_ = board;
+            this->has_task_ = true;
+            this->is_done_ = false;
+            this->has_winner_ = false;
+        }
+        this->task_cond_.notify_one();
+
+        temp = board;
+        answers = solver.template search<SearchMode::OneAnswer>(temp);
+        solver.set_control(nullptr);
+        if (answers != 0) {
+            this->finish_race(RaceSolver, temp);
+        }
+
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        this->done_cond_.wait(lock, [this]() { return this->is_done_; });
+
+        if (this->has_winner_) {
+            board = this->answer_;
+            if (this->winner_ == RaceSolver)
+                this->stats_.solver_wins++;
+            else
+                this->stats_.racer_wins++;
+            return true;
+        }
+        else {
+            this->stats_.no_solution++;
+            return false;
+        }
+    }
+
+private:
+    void finish_race(Winner winner, const Board & answer) {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (!this->has_winner_) {
+            this->has_winner_ = true;
+            this->winner_ = winner;
+            this->answer_ = answer;
+            this->control_.stop();
+        }
+    }
+
+    void racer_loop() {
+        racer_type racer;
+        for (;;) {
+            Board board;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->task_cond_.wait(lock, [this]() { return (this->has_task_ || this->quit_); });
+                if (this->quit_)
+                    break;
+                board = this->race_board_;
+                this->has_task_ = false;
+            }
+
+            racer.set_control(&this->control_);
+            bool success = racer.solve(board);
+            racer.set_control(nullptr);
+            if (success) {
+                this->finish_race(RaceRacer, board);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->is_done_ = true;
+            }
+            this->done_cond_.notify_one();
+        }
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_PORTFOLIO_H
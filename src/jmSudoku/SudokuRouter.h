@@ -0,0 +1,284 @@
+
+#ifndef JM_SUDOKU_ROUTER_H
+#define JM_SUDOKU_ROUTER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+
+#include "Sudoku.h"
+#include "BasicSolver.h"
+#include "SudokuSolver_v3.h"
+#include "SudokuSolver_v3e.h"
+#include "SudokuSolver_dlx_v3.h"
+
+//
+// Solver routing on cheap puzzle features.
+//
+// The features are read from the literal counts of v3 after init_board(),
+// the state that its search starts from: the clue count, the smallest
+// literal over the four literal kinds (cells, row/col/box nums), and the
+// literals with one candidate of every kind (the naked and the hidden
+// singles). They are mapped to a bucket, and a small table picks the solver
+// of the bucket.
+//
+// The table of a new Router sends every bucket to v3. The best solver of a
+// bucket depends on the machine, so no trained table is built in: train()
+// builds one from the times of every solver on a set of puzzles on the
+// target machine, set_table() turns it on, print_table() prints it as code.
+//
+// A table with one solver for all the buckets is followed without reading
+// the features. When the table picks v3, it searches from the state that
+// the features were read from.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+class Router {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef v3::Solver<SudokuTy>                v3_solver_t;
+    typedef v3e::Solver<SudokuTy>               v3e_solver_t;
+    typedef dlx::v3::Solver<SudokuTy>           dlx_solver_t;
+
+    static const size_t Rows = sudoku_t::Rows;
+    static const size_t Cols = sudoku_t::Cols;
+    static const size_t Boxes = sudoku_t::Boxes;
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+
+    enum SolverId {
+        SolverV3,
+        SolverV3e,
+        SolverDlxV3,
+        SolverLast
+    };
+
+    // The literal kinds of Features::singles[], in the order of v3.
+    enum LiteralKind {
+        CellNums,
+        RowNums,
+        ColNums,
+        BoxNums,
+        LiteralKindLast
+    };
+
+    struct Features {
+        uint32_t    clues;
+        uint32_t    min_size;                   // Of all the literals, 0 if the board is broken
+        uint32_t    singles[LiteralKindLast];   // [kind]: literals with one candidate
+    };
+
+    static const size_t kClueBuckets = 4;       // <= 19, 20 - 23, 24 - 27, 28 +
+    static const size_t kMinSizeBuckets = 3;    // 0 - 1, 2, 3 +
+    static const size_t kNakedBuckets = 3;      // 0, 1, 2 +
+    static const size_t kHiddenBuckets = 6;     // 0, 1 - 2, 3, 4, 5 - 6, 7 +
+    static const size_t kBuckets = kClueBuckets * kMinSizeBuckets * kNakedBuckets * kHiddenBuckets;
+
+private:
+    static_assert(v3_solver_t::policy_t::kSaveCountSize,
+                  "The features of the Router need the literal sizes of v3.");
+
+    struct Solvers {
+        v3_solver_t     v3;
+        v3e_solver_t    v3e;
+        dlx_solver_t    dlx;
+    };
+
+    Solvers     solvers_;
+    uint8_t     table_[kBuckets];
+    size_t      routed_[SolverLast];
+    bool        uniform_;               // Every bucket has the same solver
+
+public:
+    Router() : uniform_(true) {
+        std::memset(this->table_, SolverV3, sizeof(this->table_));
+        std::memset(this->routed_, 0, sizeof(this->routed_));
+    }
+    ~Router() {}
+
+    const uint8_t * table() const { return this->table_; }
+    void set_table(const uint8_t * table) {
+        std::memcpy(this->table_, table, sizeof(this->table_));
+        this->uniform_ = true;
+        for (size_t bucket = 1; bucket < kBuckets; bucket++) {
+            if (this->table_[bucket] != this->table_[0]) {
+                this->uniform_ = false;
+                break;
+            }
+        }
+    }
+
+    size_t routed(size_t solver_id) const {
+        return (solver_id < SolverLast) ? this->routed_[solver_id] : 0;
+    }
+
+    static const char * solver_name(size_t solver_id) {
+        static const char * names[SolverLast] = { "dfs::v3", "dfs::v3e", "dlx::v3" };
+        return (solver_id < SolverLast) ? names[solver_id] : "unknown";
+    }
+
+    // The board is counted by the v3 solver of the Router, false if the
+    // givens break the rules (the features of the clues only).
+    bool get_features(const Board & board, Features & features) {
+        std::memset((void *)&features, 0, sizeof(features));
+
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (board.cells[pos] != '.')
+                features.clues++;
+        }
+
+        v3_solver_t & solver = this->solvers_.v3;
+        if (!solver.count_literals(board))
+            return false;
+
+        typedef typename v3_solver_t::count_type count_t;
+        const count_t & count = solver.count();
+        uint32_t min_size = (uint32_t)count.total.min_literal_size[0];
+        for (size_t kind = 1; kind < LiteralKindLast; kind++) {
+            if ((uint32_t)count.total.min_literal_size[kind] < min_size)
+                min_size = (uint32_t)count.total.min_literal_size[kind];
+        }
+        // 255: no literal is left (a full board).
+        features.min_size = (min_size <= Numbers) ? min_size : 0;
+
+        // The padding literals and the filled ones have no candidate.
+        const size_t kSizes = sizeof(count.sizes.box_cells) / sizeof(count.sizes.box_cells[0]);
+        for (size_t i = 0; i < kSizes; i++) {
+            features.singles[CellNums] += (count.sizes.box_cells[i] == 1);
+            features.singles[RowNums]  += (count.sizes.row_nums[i] == 1);
+            features.singles[ColNums]  += (count.sizes.col_nums[i] == 1);
+            features.singles[BoxNums]  += (count.sizes.box_nums[i] == 1);
+        }
+        return true;
+    }
+
+    static size_t get_bucket(const Features & features) {
+        size_t clue_bucket;
+        if (features.clues <= 19)
+            clue_bucket = 0;
+        else if (features.clues <= 23)
+            clue_bucket = 1;
+        else if (features.clues <= 27)
+            clue_bucket = 2;
+        else
+            clue_bucket = 3;
+
+        size_t min_size_bucket;
+        if (features.min_size <= 1)
+            min_size_bucket = 0;
+        else if (features.min_size == 2)
+            min_size_bucket = 1;
+        else
+            min_size_bucket = 2;
+
+        uint32_t naked = features.singles[CellNums];
+        size_t naked_bucket = (naked < 2) ? naked : 2;
+
+        static const uint8_t hidden_buckets[8] = { 0, 1, 1, 2, 3, 4, 4, 5 };
+        uint32_t hidden = features.singles[RowNums] + features.singles[ColNums] +
+                          features.singles[BoxNums];
+        size_t hidden_bucket = hidden_buckets[(hidden < 7) ? hidden : 7];
+
+        return (((clue_bucket * kMinSizeBuckets + min_size_bucket) * kNakedBuckets + naked_bucket) *
+                kHiddenBuckets + hidden_bucket);
+    }
+
+    size_t route(const Board & board) {
+        if (this->uniform_)
+            return this->table_[0];
+        Features features;
+        this->get_features(board, features);
+        return this->table_[get_bucket(features)];
+    }
+
+    // Solves by the given solver, the board gets the answer.
+    bool solve_by(size_t solver_id, Board & board) {
+        switch (solver_id) {
+            case SolverV3e:
+                return this->solvers_.v3e.solve(board);
+            case SolverDlxV3:
+                return this->solvers_.dlx.solve(board);
+            case SolverV3:
+            default:
+                return (this->solvers_.v3.template search<SearchMode::OneAnswer>(board) != 0);
+        }
+    }
+
+    bool solve(Board & board) {
+        if (this->uniform_) {
+            size_t solver_id = this->table_[0];
+            this->routed_[solver_id]++;
+            return this->solve_by(solver_id, board);
+        }
+
+        Features features;
+        bool counted = this->get_features(board, features);
+        size_t solver_id = this->table_[get_bucket(features)];
+        this->routed_[solver_id]++;
+        if (solver_id == SolverV3 && counted) {
+            // The state of v3 is the one the features were read from.
+            return (this->solvers_.v3.search_counted(board) != 0);
+        }
+        return this->solve_by(solver_id, board);
+    }
+
+    //
+    // times[i * SolverLast + solver_id] is the time of the solver on puzzles[i],
+    // every bucket gets the solver with the least total time.
+    //
+    void train(const std::vector<Board> & puzzles, const std::vector<double> & times,
+               uint8_t * table) {
+        std::vector<double> bucket_times(kBuckets * SolverLast, 0.0);
+        std::vector<size_t> bucket_count(kBuckets, 0);
+        for (size_t i = 0; i < puzzles.size(); i++) {
+            Features features;
+            this->get_features(puzzles[i], features);
+            size_t bucket = get_bucket(features);
+            bucket_count[bucket]++;
+            for (size_t solver_id = 0; solver_id < SolverLast; solver_id++) {
+                bucket_times[bucket * SolverLast + solver_id] += times[i * SolverLast + solver_id];
+            }
+        }
+
+        for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+            size_t best_id = SolverV3;
+            if (bucket_count[bucket] != 0) {
+                for (size_t solver_id = 1; solver_id < SolverLast; solver_id++) {
+                    if (bucket_times[bucket * SolverLast + solver_id] <
+                        bucket_times[bucket * SolverLast + best_id])
+                        best_id = solver_id;
+                }
+            }
+            table[bucket] = (uint8_t)best_id;
+        }
+    }
+
+    static void print_table(const uint8_t * table) {
+        printf("// [clue bucket][min size bucket][naked bucket][hidden bucket]\n");
+        printf("static const uint8_t kRouterTable[Router<Sudoku>::kBuckets] = {\n");
+        static const size_t kRowSize = kNakedBuckets * kHiddenBuckets;
+        for (size_t row = 0; row < kClueBuckets * kMinSizeBuckets; row++) {
+            printf("    ");
+            for (size_t n = 0; n < kRowSize; n++) {
+                printf("%u,%s", (uint32_t)table[row * kRowSize + n], (n + 1 < kRowSize) ? " " : "");
+            }
+            printf("\n");
+        }
+        printf("};\n");
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_ROUTER_H
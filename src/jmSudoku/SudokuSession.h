@@ -0,0 +1,364 @@
+
+#ifndef JM_SUDOKU_SESSION_H
+#define JM_SUDOKU_SESSION_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memcpy()
+
+#include "BasicSolver.h"
+#include "Sudoku.h"
+#include "BitUtils.h"
+#include "PackedBitSet.h"
+#include "SudokuSolver_v3.h"
+
+//
+// An interactive editing session on top of the v3 bitboards.
+//
+// place() and erase() update the State and Count incrementally instead of
+// calling init_board() again. Every placement keeps its RecoverState on an
+// edit stack, erasing the last placement is a plain undo, erasing an older
+// one undoes down to it and replays the placements above it.
+//
+// is_still_solvable() caches the last solution found, a placement that agrees
+// with it (or any erase) keeps the answer without searching again.
+//
+namespace jmSudoku {
+namespace v3 {
+
+template <typename SudokuTy>
+class Session {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef Solver<SudokuTy>                    solver_type;
+    typedef typename solver_type::Board         Board;
+    typedef typename sudoku_t::CellInfo         CellInfo;
+    typedef typename sudoku_t::BoxesInfo        BoxesInfo;
+
+    static const size_t Rows = sudoku_t::Rows;
+    static const size_t Cols = sudoku_t::Cols;
+    static const size_t Numbers = sudoku_t::Numbers;
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t MinNumber = sudoku_t::MinNumber;
+    static const size_t MaxNumber = sudoku_t::MaxNumber;
+
+    static const size_t Rows16 = solver_type::Rows16;
+    static const size_t Cols16 = solver_type::Cols16;
+    static const size_t Numbers16 = solver_type::Numbers16;
+    static const size_t Boxes16 = solver_type::Boxes16;
+    static const size_t BoxSize16 = solver_type::BoxSize16;
+    static const size_t BoardSize16 = solver_type::BoardSize16;
+
+    enum PlaceResult {
+        Placed,             // Placed and applied to the bitboards
+        Conflict,           // Placed, but the number is not a candidate of the cell
+        Occupied,           // The cell is not empty
+        InvalidArgument
+    };
+
+private:
+    typedef typename solver_type::State         State;
+    typedef typename solver_type::Count         Count;
+    typedef typename solver_type::RecoverState  RecoverState;
+    typedef typename solver_type::LiteralType   LiteralType;
+
+    // RecoverState is declared in a packed region, so the alignment of its
+    // SIMD members must be restored for the array of edits.
+    struct alignas(32) Edit {
+        RecoverState                recover_state;
+        PackedBitSet<Numbers16>     save_num_bits;
+        uint32_t                    min_literal_size;
+        uint32_t                    min_literal_index;
+        uint8_t                     pos, num;
+        uint8_t                     is_applied;
+    };
+
+    solver_type     solver_;
+
+    Edit            edits_[BoardSize];
+    size_t          edit_count_;
+
+    State           saved_state_;
+    Count           saved_count_;
+
+    Board           puzzle_;
+    Board           board_;
+    Board           solution_;
+
+    size_t          empties_;
+    size_t          conflicts_;
+    bool            solution_valid_;
+
+public:
+    Session() : edit_count_(0), empties_(0), conflicts_(0), solution_valid_(false) {
+        sudoku_t::clear_board(this->puzzle_);
+        sudoku_t::clear_board(this->board_);
+    }
+    ~Session() {}
+
+    const Board & puzzle() const { return this->puzzle_; }
+    const Board & board() const { return this->board_; }
+
+    size_t edits() const { return this->edit_count_; }
+    size_t empties() const { return this->empties_; }
+    size_t conflicts() const { return this->conflicts_; }
+
+    void load(const Board & puzzle) {
+        this->puzzle_ = puzzle;
+        this->board_ = puzzle;
+        this->solver_.init_board(this->board_);
+
+        this->edit_count_ = 0;
+        this->empties_ = this->solver_.calc_empties(this->board_);
+        this->conflicts_ = 0;
+        this->solution_valid_ = false;
+    }
+
+    // num: [MinNumber, MaxNumber]
+    PlaceResult place(size_t pos, size_t num) {
+        if (pos >= BoardSize || num < MinNumber || num > MaxNumber)
+            return PlaceResult::InvalidArgument;
+        if (this->board_.cells[pos] != '.')
+            return PlaceResult::Occupied;
+
+        size_t num0 = num - MinNumber;
+        bool is_applied = this->apply_edit(pos, num0);
+        if (this->solution_valid_ && this->solution_.cells[pos] != this->board_.cells[pos]) {
+            this->solution_valid_ = false;
+        }
+        return (is_applied ? PlaceResult::Placed : PlaceResult::Conflict);
+    }
+
+    bool erase(size_t pos) {
+        if (pos >= BoardSize || this->puzzle_.cells[pos] != '.')
+            return false;
+
+        size_t index = this->edit_count_;
+        while (index > 0) {
+            index--;
+            if (this->edits_[index].pos == pos) {
+                // Undo all the edits above it, then replay them.
+                uint8_t replay_pos[BoardSize], replay_num[BoardSize];
+                size_t replay_count = 0;
+                for (size_t i = index + 1; i < this->edit_count_; i++) {
+                    replay_pos[replay_count] = this->edits_[i].pos;
+                    replay_num[replay_count] = this->edits_[i].num;
+                    replay_count++;
+                }
+                while (this->edit_count_ > index) {
+                    this->undo_edit();
+                }
+                for (size_t i = 0; i < replay_count; i++) {
+                    this->apply_edit(replay_pos[i], replay_num[i]);
+                }
+                // Removing a number never makes a solution invalid.
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool is_still_solvable() {
+        if (this->conflicts_ != 0)
+            return false;
+        if (this->solution_valid_)
+            return true;
+        if (this->empties_ == 0) {
+            this->solution_ = this->board_;
+            this->solution_valid_ = true;
+            return true;
+        }
+
+        uint32_t min_literal_size = this->solver_.count_.min_literal_size;
+        uint32_t min_literal_index = this->solver_.count_.min_literal_index;
+        if (min_literal_size == 0)
+            return false;
+
+        // The recursive search doesn't unwind the bitboards on success.
+        std::memcpy((void *)&this->saved_state_, (const void *)&this->solver_.state_, sizeof(State));
+        std::memcpy((void *)&this->saved_count_, (const void *)&this->solver_.count_, sizeof(Count));
+
+        Board board = this->board_;
+        bool success = this->solver_.solve(board, this->empties_, min_literal_size, min_literal_index);
+
+        std::memcpy((void *)&this->solver_.state_, (const void *)&this->saved_state_, sizeof(State));
+        std::memcpy((void *)&this->solver_.count_, (const void *)&this->saved_count_, sizeof(Count));
+
+        if (success) {
+            this->solution_ = board;
+            this->solution_valid_ = true;
+        }
+        return success;
+    }
+
+    // A forced move (naked or hidden single) if there is one,
+    // else the solution's number of the cell with the fewest candidates.
+    bool hint(size_t & out_pos, size_t & out_num) {
+        if (this->conflicts_ != 0 || this->empties_ == 0)
+            return false;
+
+        uint32_t min_literal_size = this->solver_.count_.min_literal_size;
+        if (min_literal_size == 0)
+            return false;
+
+        if (min_literal_size == 1) {
+            size_t num0;
+            this->decode_literal(this->solver_.count_.min_literal_index, out_pos, num0);
+            out_num = num0 + MinNumber;
+            return true;
+        }
+
+        if (!this->is_still_solvable())
+            return false;
+
+        size_t min_pos = size_t(-1);
+        size_t min_size = size_t(-1);
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (this->board_.cells[pos] == '.') {
+                const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                size_t size = this->solver_.state_.box_cell_nums[cellInfo.box][cellInfo.cell].count();
+                if (size < min_size) {
+                    min_size = size;
+                    min_pos = pos;
+                }
+            }
+        }
+        assert(min_pos != size_t(-1));
+
+        out_pos = min_pos;
+        out_num = (size_t)(this->solution_.cells[min_pos] - '1') + MinNumber;
+        return true;
+    }
+
+private:
+    bool apply_edit(size_t pos, size_t num) {
+        assert(this->edit_count_ < BoardSize);
+        Edit & edit = this->edits_[this->edit_count_++];
+        edit.pos = (uint8_t)pos;
+        edit.num = (uint8_t)num;
+
+        const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+        size_t row = cellInfo.row;
+        size_t col = cellInfo.col;
+        size_t box = cellInfo.box;
+        size_t cell = cellInfo.cell;
+
+        this->board_.cells[pos] = (char)(num + '1');
+
+        if (this->solver_.state_.box_cell_nums[box][cell].test(num)) {
+            edit.is_applied = 1;
+            edit.min_literal_size = this->solver_.count_.min_literal_size;
+            edit.min_literal_index = this->solver_.count_.min_literal_index;
+
+            this->solver_.doFillNum(pos, row, col, box, cell, num, edit.save_num_bits, edit.recover_state);
+            this->solver_.updateNeighborCellsEffect(edit.recover_state, pos, box, num);
+
+            uint32_t min_literal_index = 0;
+            uint32_t min_literal_size = this->solver_.count_delta_literal_size(min_literal_index,
+                                            edit.recover_state, edit.save_num_bits, box);
+            this->solver_.count_.min_literal_size = min_literal_size;
+            this->solver_.count_.min_literal_index = min_literal_index;
+
+            this->empties_--;
+            return true;
+        }
+        else {
+            edit.is_applied = 0;
+            this->conflicts_++;
+            return false;
+        }
+    }
+
+    void undo_edit() {
+        assert(this->edit_count_ > 0);
+        Edit & edit = this->edits_[--this->edit_count_];
+        size_t pos = edit.pos;
+        size_t num = edit.num;
+
+        if (edit.is_applied) {
+            const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+            size_t box = cellInfo.box;
+
+            this->solver_.restoreNeighborCellsEffect(edit.recover_state, box, num);
+            this->solver_.undoFillNum(pos, cellInfo.row, cellInfo.col, box, cellInfo.cell, num,
+                                      edit.save_num_bits, edit.recover_state);
+
+            this->solver_.count_.min_literal_size = edit.min_literal_size;
+            this->solver_.count_.min_literal_index = edit.min_literal_index;
+            this->empties_++;
+        }
+        else {
+            this->conflicts_--;
+        }
+
+        this->board_.cells[pos] = '.';
+    }
+
+    void decode_literal(uint32_t literal_id, size_t & out_pos, size_t & out_num) {
+        const State & state = this->solver_.state_;
+        uint32_t literal_type = literal_id / (uint32_t)BoardSize16;
+        switch (literal_type) {
+            case LiteralType::CellNums:
+            {
+                size_t box_pos = (size_t)literal_id - solver_type::CellLiteralFirst;
+                const BoxesInfo & boxesInfo = sudoku_t::boxes_info16[box_pos];
+                out_pos = boxesInfo.pos;
+                out_num = BitUtils::bsf(state.box_cell_nums[boxesInfo.box][boxesInfo.cell].to_ulong());
+                break;
+            }
+
+            case LiteralType::RowNums:
+            {
+                size_t literal = (size_t)literal_id - solver_type::RowLiteralFirst;
+                size_t num = literal / Rows16;
+                size_t row = literal % Rows16;
+                size_t col = BitUtils::bsf(state.row_num_cols[num][row].to_ulong());
+                out_pos = row * Cols + col;
+                out_num = num;
+                break;
+            }
+
+            case LiteralType::ColNums:
+            {
+                size_t literal = (size_t)literal_id - solver_type::ColLiteralFirst;
+                size_t num = literal / Cols16;
+                size_t col = literal % Cols16;
+                size_t row = BitUtils::bsf(state.col_num_rows[num][col].to_ulong());
+                out_pos = row * Cols + col;
+                out_num = num;
+                break;
+            }
+
+            case LiteralType::BoxNums:
+            {
+                size_t literal = (size_t)literal_id - solver_type::BoxLiteralFirst;
+                size_t num = literal / Boxes16;
+                size_t box = literal % Boxes16;
+                size_t cell = BitUtils::bsf(state.box_num_cells[num][box].to_ulong());
+                out_pos = sudoku_t::boxes_info16[box * BoxSize16 + cell].pos;
+                out_num = num;
+                break;
+            }
+
+            default:
+                assert(false);
+                out_pos = 0;
+                out_num = 0;
+                break;
+        }
+    }
+};
+
+} // namespace v3
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SESSION_H
@@ -0,0 +1,205 @@
+
+#ifndef JM_SUDOKU_SINK_H
+#define JM_SUDOKU_SINK_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif // _WIN32
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memcpy()
+
+#include "Sudoku.h"
+
+//
+// The sinks of the enumeration of all the answers.
+//
+// AnswerSink is a visitor of v3::Solver::enumerate(), it writes every answer
+// as a line of the board (BoardSize chars and a '\n') into a buffer of the
+// caller, and stops the search when the buffer is full. Nothing is allocated
+// per answer, the buffer is usually the view of a MappedFile, so the answers
+// go to the page cache of the output file directly.
+//
+namespace jmSudoku {
+
+template <typename SudokuTy>
+class AnswerSink {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t kLineSize = BoardSize + 1;
+
+private:
+    char *      data_;
+    size_t      capacity_;
+    size_t      size_;
+    size_t      answers_;
+    bool        is_full_;
+
+public:
+    AnswerSink(char * data, size_t capacity)
+        : data_(data), capacity_(capacity), size_(0), answers_(0), is_full_(false) {}
+    ~AnswerSink() {}
+
+    const char * data() const { return this->data_; }
+    size_t capacity() const { return this->capacity_; }
+
+    // The bytes written.
+    size_t size() const { return this->size_; }
+    size_t answers() const { return this->answers_; }
+
+    // There was an answer that didn't fit any more, the search was stopped.
+    bool is_full() const { return this->is_full_; }
+
+    void reset() {
+        this->size_ = 0;
+        this->answers_ = 0;
+        this->is_full_ = false;
+    }
+
+    bool operator () (const Board & answer) {
+        if ((this->capacity_ - this->size_) < kLineSize) {
+            this->is_full_ = true;
+            return false;
+        }
+        char * line = this->data_ + this->size_;
+        std::memcpy((void *)line, (const void *)&answer.cells[0], BoardSize);
+        line[BoardSize] = '\n';
+        this->size_ += kLineSize;
+        this->answers_++;
+        return true;
+    }
+};
+
+//
+// A new file mapped for writing, of a fixed capacity. close() truncates the
+// file to the bytes that were written.
+//
+class MappedFile {
+private:
+    char *      data_;
+    size_t      capacity_;
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+    HANDLE      file_;
+    HANDLE      mapping_;
+#else
+    int         fd_;
+#endif
+
+public:
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+    MappedFile() : data_(nullptr), capacity_(0), file_(INVALID_HANDLE_VALUE), mapping_(NULL) {}
+#else
+    MappedFile() : data_(nullptr), capacity_(0), fd_(-1) {}
+#endif
+    ~MappedFile() {
+        this->close(this->capacity_);
+    }
+
+    char * data() const { return this->data_; }
+    size_t capacity() const { return this->capacity_; }
+    bool is_open() const { return (this->data_ != nullptr); }
+
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+    bool create(const char * filename, size_t capacity) {
+        this->close(this->capacity_);
+        if (capacity == 0)
+            return false;
+
+        this->file_ = ::CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                                    CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (this->file_ == INVALID_HANDLE_VALUE)
+            return false;
+        this->mapping_ = ::CreateFileMappingA(this->file_, NULL, PAGE_READWRITE,
+                                              (DWORD)((uint64_t)capacity >> 32),
+                                              (DWORD)((uint64_t)capacity & 0xFFFFFFFFULL), NULL);
+        if (this->mapping_ != NULL) {
+            this->data_ = (char *)::MapViewOfFile(this->mapping_, FILE_MAP_WRITE, 0, 0, capacity);
+        }
+        if (this->data_ == nullptr) {
+            if (this->mapping_ != NULL) {
+                ::CloseHandle(this->mapping_);
+                this->mapping_ = NULL;
+            }
+            ::CloseHandle(this->file_);
+            this->file_ = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        this->capacity_ = capacity;
+        return true;
+    }
+
+    void close(size_t size) {
+        if (this->data_ != nullptr) {
+            ::UnmapViewOfFile(this->data_);
+            ::CloseHandle(this->mapping_);
+            LARGE_INTEGER file_size;
+            file_size.QuadPart = (LONGLONG)((size < this->capacity_) ? size : this->capacity_);
+            ::SetFilePointerEx(this->file_, file_size, NULL, FILE_BEGIN);
+            ::SetEndOfFile(this->file_);
+            ::CloseHandle(this->file_);
+            this->data_ = nullptr;
+            this->capacity_ = 0;
+            this->mapping_ = NULL;
+            this->file_ = INVALID_HANDLE_VALUE;
+        }
+    }
+#else
+    bool create(const char * filename, size_t capacity) {
+        this->close(this->capacity_);
+        if (capacity == 0)
+            return false;
+
+        this->fd_ = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (this->fd_ < 0)
+            return false;
+        if (::ftruncate(this->fd_, (off_t)capacity) == 0) {
+            void * data = ::mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0);
+            if (data != MAP_FAILED)
+                this->data_ = (char *)data;
+        }
+        if (this->data_ == nullptr) {
+            ::close(this->fd_);
+            this->fd_ = -1;
+            return false;
+        }
+        this->capacity_ = capacity;
+        return true;
+    }
+
+    void close(size_t size) {
+        if (this->data_ != nullptr) {
+            ::munmap(this->data_, this->capacity_);
+            int result = ::ftruncate(this->fd_, (off_t)((size < this->capacity_) ? size : this->capacity_));
+            (void)result;
+            ::close(this->fd_);
+            this->data_ = nullptr;
+            this->capacity_ = 0;
+            this->fd_ = -1;
+        }
+    }
+#endif // _WIN32
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SINK_H
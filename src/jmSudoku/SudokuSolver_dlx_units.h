@@ -0,0 +1,371 @@
+
+#ifndef JM_SUDOKU_SOLVER_DLX_UNITS_H
+#define JM_SUDOKU_SOLVER_DLX_UNITS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <memory.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <emmintrin.h>      // For SSE 2
+#else
+#include <x86intrin.h>      // For SSE 2
+#endif // _MSC_VER
+
+#include "BasicSolver.h"
+#include "Sudoku.h"
+#include "SudokuUnits.h"
+#include "BitUtils.h"
+#include "BitSet.h"
+
+/************************************************
+
+#define SEARCH_MODE_ONE_ANSWER              0
+#define SEARCH_MODE_MORE_THAN_ONE_ANSWER    1
+#define SEARCH_MODE_ALL_ANSWERS             2
+
+************************************************/
+
+#define DLX_UNITS_SEARCH_MODE   SEARCH_MODE_ONE_ANSWER
+
+//
+// dlx::v4 on a constraint description: the columns of the exact cover
+// matrix are the cells and the [unit][num] of the Units, so the same engine
+// solves the classic sudoku, Sudoku-X, Windoku and the jigsaw sudoku. The
+// masks are compiled from the Units by the constructor, once per solver,
+// a row has as many columns as its cell has units, plus one.
+//
+namespace jmSudoku {
+namespace dlx {
+namespace units {
+
+static const size_t kSearchMode = DLX_UNITS_SEARCH_MODE;
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
+class Solver : public BasicSolver<SudokuTy> {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef BasicSolver<SudokuTy>               basic_solver_t;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef Units<SudokuTy>                     units_t;
+
+    static const size_t Numbers = SudokuTy::Numbers;
+    static const size_t BoardSize = SudokuTy::BoardSize;
+
+    // The rows of the matrix are the candidates [pos][num], the columns are
+    // [cell] and [unit][num].
+    static const size_t MatrixRows = SudokuTy::TotalSize;
+    static const size_t MaxMatrixCols = BoardSize + units_t::MaxUnits * Numbers;
+    static const size_t MaxMatrixCols16 = AlignedTo<MaxMatrixCols, 16>::value;
+    static const size_t MaxColsPerRow = units_t::MaxUnitsPerCell + 1;
+
+    static const uint8_t kCoveredCol = 0xFF;
+
+    typedef WordBitSet<MatrixRows> row_bitset_t;
+
+private:
+    //
+    // Everything that a level changes, the level keeps a copy and copies it
+    // back after every candidate. The columns over matrix_cols_ stay covered.
+    //
+    struct State {
+        alignas(16) uint8_t col_sizes[MaxMatrixCols16];     // kCoveredCol: covered
+        row_bitset_t        rows;                           // The active rows
+        size_t              cols_left;
+    };
+
+    alignas(16) State   state_;
+    Board               board_;
+    SearchPoller        poller_;
+
+    const units_t &     units_;
+    size_t              matrix_cols_;
+    size_t              matrix_cols16_;
+
+    uint16_t            answer_[BoardSize];
+
+    // The masks of the Units.
+    uint8_t             cell_col_count_[BoardSize];             // [pos] -> cols of its rows
+    uint16_t            row_cols_[MatrixRows][MaxColsPerRow];   // [row] -> cols
+    row_bitset_t        col_rows_mask_[MaxMatrixCols];          // [col] -> rows
+
+public:
+    Solver(const units_t & units) : units_(units) {
+        assert(units.is_compiled());
+        this->init_mask();
+    }
+    ~Solver() {}
+
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
+    const units_t & units() const { return this->units_; }
+
+private:
+    void init_mask() {
+        this->matrix_cols_ = BoardSize + this->units_.unit_count() * Numbers;
+        this->matrix_cols16_ = (this->matrix_cols_ + 15) / 16 * 16;
+
+        for (size_t col = 0; col < this->matrix_cols_; col++) {
+            this->col_rows_mask_[col].reset();
+        }
+
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            size_t unit_count = this->units_.cell_unit_count(pos);
+            const uint8_t * cell_units = this->units_.cell_units(pos);
+            this->cell_col_count_[pos] = (uint8_t)(unit_count + 1);
+            for (size_t num = 0; num < Numbers; num++) {
+                size_t matrix_row = pos * Numbers + num;
+                uint16_t * cols = &this->row_cols_[matrix_row][0];
+                cols[0] = (uint16_t)pos;
+                for (size_t i = 0; i < unit_count; i++) {
+                    cols[i + 1] = (uint16_t)(BoardSize + cell_units[i] * Numbers + num);
+                }
+                for (size_t i = 0; i <= unit_count; i++) {
+                    this->col_rows_mask_[cols[i]].set(matrix_row);
+                }
+            }
+        }
+    }
+
+    void init_state() {
+        std::memset((void *)&this->state_.col_sizes[0], (int)Numbers, this->matrix_cols_);
+        std::memset((void *)&this->state_.col_sizes[this->matrix_cols_], kCoveredCol,
+                    MaxMatrixCols16 - this->matrix_cols_);
+        this->state_.rows.fill();
+        this->state_.cols_left = this->matrix_cols_;
+    }
+
+    //
+    // Takes the matrix row into the answer: its columns are covered, and all
+    // the active rows of these columns (itself too) are removed.
+    //
+    inline void cover(size_t matrix_row) {
+        assert(this->state_.rows.test(matrix_row));
+        const uint16_t * cols = &this->row_cols_[matrix_row][0];
+        size_t col_count = this->cell_col_count_[matrix_row / Numbers];
+
+        row_bitset_t removed;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            size_t bits = this->col_rows_mask_[cols[0]].words[i];
+            for (size_t k = 1; k < col_count; k++) {
+                bits |= this->col_rows_mask_[cols[k]].words[i];
+            }
+            removed.words[i] = bits & this->state_.rows.words[i];
+        }
+        this->state_.rows.and_not(removed);
+
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            size_t bits = removed.words[i];
+            while (bits != 0) {
+                size_t bit = BitUtils::ls1b(bits);
+                size_t removed_row = i * row_bitset_t::kWordBits + BitUtils::bsf(bit);
+                bits ^= bit;
+
+                const uint16_t * removed_cols = &this->row_cols_[removed_row][0];
+                size_t removed_col_count = this->cell_col_count_[removed_row / Numbers];
+                for (size_t k = 0; k < removed_col_count; k++) {
+                    this->state_.col_sizes[removed_cols[k]]--;
+                }
+            }
+        }
+
+        for (size_t k = 0; k < col_count; k++) {
+            this->state_.col_sizes[cols[k]] = kCoveredCol;
+        }
+        this->state_.cols_left -= col_count;
+    }
+
+    //
+    // The uncovered column with the fewest active rows, the first one of them.
+    //
+    inline size_t get_min_column(size_t & out_min_size) const {
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i * sizes = (const __m128i *)&this->state_.col_sizes[0];
+        size_t blocks = this->matrix_cols16_ / 16;
+        __m128i min_sizes = _mm_load_si128(sizes);
+        for (size_t i = 1; i < blocks; i++) {
+            min_sizes = _mm_min_epu8(min_sizes, _mm_load_si128(sizes + i));
+        }
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 8));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 4));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 2));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 1));
+        size_t min_size = (size_t)(_mm_cvtsi128_si32(min_sizes) & 0xFF);
+
+        __m128i min_mask = _mm_set1_epi8((char)min_size);
+        for (size_t i = 0; i < blocks; i++) {
+            int equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(sizes + i), min_mask));
+            if (equal_mask != 0) {
+                out_min_size = min_size;
+                return (i * 16 + BitUtils::bsf32((uint32_t)equal_mask));
+            }
+        }
+        assert(false);
+        out_min_size = min_size;
+        return 0;
+#else
+        size_t min_size = kCoveredCol;
+        size_t min_col = 0;
+        for (size_t col = 0; col < this->matrix_cols_; col++) {
+            size_t col_size = this->state_.col_sizes[col];
+            if (col_size < min_size) {
+                min_size = col_size;
+                min_col = col;
+                if (col_size == 0)
+                    break;
+            }
+        }
+        out_min_size = min_size;
+        return min_col;
+#endif
+    }
+
+    void get_answer(Board & board, size_t depth) const {
+        for (size_t i = 0; i < depth; i++) {
+            size_t matrix_row = this->answer_[i];
+            board.cells[matrix_row / Numbers] = (char)(matrix_row % Numbers + '1');
+        }
+    }
+
+    template <size_t nSearchMode>
+    bool search(size_t depth) {
+        if (this->state_.cols_left == 0) {
+            if (nSearchMode > SearchMode::OneAnswer) {
+                Board answer = this->board_;
+                this->get_answer(answer, depth);
+                this->answers_.push_back(answer);
+                if (nSearchMode == SearchMode::MoreThanOneAnswer) {
+                    if (this->answers_.size() > 1)
+                        return true;
+                }
+                return false;
+            }
+            else {
+                return true;
+            }
+        }
+
+        size_t min_size;
+        size_t min_col = this->get_min_column(min_size);
+        assert(min_size != kCoveredCol);
+        if (min_size == 0) {
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths, depth);
+            return false;
+        }
+
+        if (min_size == 1) {
+            count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths, depth);
+        }
+        else {
+            count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths, depth);
+            // Only the guesses poll the control, the singles don't branch.
+            if (this->poller_.should_stop_at_guess())
+                return false;
+        }
+
+        row_bitset_t candidates;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            candidates.words[i] = this->col_rows_mask_[min_col].words[i] & this->state_.rows.words[i];
+        }
+
+        alignas(16) State saved_state = this->state_;
+        size_t candidates_left = min_size;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            size_t bits = candidates.words[i];
+            while (bits != 0) {
+                size_t bit = BitUtils::ls1b(bits);
+                size_t matrix_row = i * row_bitset_t::kWordBits + BitUtils::bsf(bit);
+                bits ^= bit;
+
+                this->cover(matrix_row);
+                this->answer_[depth] = (uint16_t)matrix_row;
+
+                if (this->template search<nSearchMode>(depth + 1)) {
+                    return true;
+                }
+
+                // The last candidate leaves the state to the caller.
+                candidates_left--;
+                if (candidates_left != 0)
+                    this->state_ = saved_state;
+            }
+        }
+
+        return false;
+    }
+
+public:
+    //
+    // The board is checked against the Units, not by check_input(): a jigsaw
+    // puzzle may have a number twice in a box.
+    //
+    template <size_t nSearchMode = kSearchMode>
+    bool solve(Board & board) {
+        if (nSearchMode > SearchMode::OneAnswer) {
+            this->answers_.clear();
+        }
+
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
+
+        basic_solver_t::last_check = (size_t)this->units_.check_board(board);
+        if (basic_solver_t::last_check != BoardCheck::BoardValid)
+            return false;
+
+        this->init_state();
+        size_t empties = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            unsigned char val = board.cells[pos];
+            if (val != '.') {
+                size_t num = val - '1';
+                this->cover(pos * Numbers + num);
+            }
+            else {
+                empties++;
+            }
+        }
+        this->empties_ = empties;
+        this->board_ = board;
+
+        bool success = this->template search<nSearchMode>(0);
+        if (success && nSearchMode == SearchMode::OneAnswer)
+            this->get_answer(board, empties);
+        return success;
+    }
+
+    // The number of the answers, 2 means more than one.
+    size_t count_solutions(const Board & board) {
+        Board puzzle = board;
+        this->template solve<SearchMode::MoreThanOneAnswer>(puzzle);
+        return this->answers_.size();
+    }
+
+    void display_result(Board & board, double elapsed_time,
+                        bool print_answer = true,
+                        bool print_all_answers = true) {
+        basic_solver_t::template display_result<kSearchMode>(board, elapsed_time, print_answer, print_all_answers);
+    }
+};
+
+} // namespace units
+} // namespace dlx
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SOLVER_DLX_UNITS_H
@@ -129,7 +129,7 @@ private:
     }
 };
 
-template <typename SudokuTy = Sudoku>
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
 class DancingLinks {
 public:
     static const size_t Rows = SudokuTy::Rows;
@@ -142,10 +142,12 @@ public:
     static const size_t TotalLiterals = SudokuTy::TotalLiterals;
 
     typedef typename SudokuTy::board_type   Board;
+    typedef BasicSolver<SudokuTy>           basic_solver_t;
 
-    static size_t num_guesses;
-    static size_t num_unique_candidate;
-    static size_t num_failed_return;
+    // Per thread, so the solvers can run on several threads.
+    static thread_local size_t num_guesses;
+    static thread_local size_t num_unique_candidate;
+    static thread_local size_t num_failed_return;
 
 private:    
 #if 0
@@ -171,6 +173,8 @@ private:
 
     std::vector<std::vector<int>> answers_;
 
+    SearchPoller    poller_;
+
 public:
     DancingLinks(size_t nodes)
         : list_(nodes), last_idx_(0) {
@@ -178,6 +182,9 @@ public:
 
     ~DancingLinks() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
     bool is_empty() const { return (list_.next[0] == 0); }
 
     int cols() const { return (int)TotalLiterals; }
@@ -310,6 +317,7 @@ public:
 #if (DLX_V1_SEARCH_MODE >= SEARCH_MODE_ONE_ANSWER)
         this->answers_.clear();
 #endif
+        this->poller_.reset();
         num_guesses = 0;
         num_unique_candidate = 0;
         num_failed_return = 0;
@@ -452,10 +460,17 @@ public:
         int min_col;
         int index = get_min_column(min_col);
         if (index > 0) {
-            if (min_col == 1)
-                num_unique_candidate++;
-            else
-                num_guesses++;
+            if (min_col == 1) {
+                count_stats<StatsTy>(num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->answer_.size());
+            }
+            else {
+                count_stats<StatsTy>(num_guesses, basic_solver_t::guess_depths,
+                                     this->answer_.size());
+                // Only the guesses poll the control, the singles don't branch.
+                if (this->poller_.should_stop_at_guess())
+                    return false;
+            }
             this->remove(index);
             for (int row = list_.down[index]; row != index; row = list_.down[row]) {
                 this->answer_.push_back(list_.row[row]);
@@ -481,7 +496,8 @@ public:
             this->restore(index);
         }
         else {
-            num_failed_return++;
+            count_stats<StatsTy>(num_failed_return, basic_solver_t::failed_depths,
+                                 this->answer_.size());
         }
 
         return false;
@@ -491,13 +507,16 @@ public:
         return this->search();
     }
 
-    void display_answer(Board & board) {
+    void get_answer(Board & board) {
         for (auto idx : this->answer_) {
             if (idx > 0) {
                 board.cells[this->rows_[idx] * Rows + this->cols_[idx]] = (char)this->numbers_[idx] + '1';
             }
         }
+    }
 
+    void display_answer(Board & board) {
+        this->get_answer(board);
         Sudoku::display_board(board);
     }
 
@@ -519,36 +538,44 @@ public:
     }
 };
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_guesses = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_guesses = 0;
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_unique_candidate = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_unique_candidate = 0;
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_failed_return = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_failed_return = 0;
 
-template <typename SudokuTy = Sudoku>
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                        sudoku_t;
     typedef BasicSolver<SudokuTy>           basic_solver_t;
-    typedef DancingLinks<SudokuTy>          solver_type;
+    typedef DancingLinks<SudokuTy, StatsTy> solver_type;
+    typedef StatsTy                         stats_t;
     typedef typename SudokuTy::board_type   Board;
 
 private:
-    DancingLinks<SudokuTy> solver_;
+    DancingLinks<SudokuTy, StatsTy> solver_;
 
 public:
     Solver() : solver_(SudokuTy::TotalSize * 4 + 1) {
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->solver_.control(); }
+    void set_control(SearchControl * control) { this->solver_.set_control(control); }
+
 public:
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         solver_.init(board);
         solver_.build(board);
         bool success = solver_.solve();
+        if (success && kSearchMode == SearchMode::OneAnswer)
+            solver_.get_answer(board);
         return success;
     }
 
@@ -72,7 +72,7 @@ public:
     size_t capacity() const { return this_type::kCapacity; }
 };
 
-template <typename SudokuTy = Sudoku>
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
 class DancingLinks {
 public:
     static const size_t Rows = SudokuTy::Rows;
@@ -85,10 +85,15 @@ public:
     static const size_t TotalLiterals = SudokuTy::TotalLiterals;
 
     typedef typename SudokuTy::board_type   Board;
+    typedef BasicSolver<SudokuTy>           basic_solver_t;
+
+    // Per thread, so the solvers can run on several threads.
+    static thread_local size_t num_guesses;
+    static thread_local size_t num_unique_candidate;
+    static thread_local size_t num_failed_return;
 
-    static size_t num_guesses;
-    static size_t num_unique_candidate;
-    static size_t num_failed_return;
+    // The mems of remove() and restore(), DetailedStats only.
+    static thread_local size_t num_mems;
 
 private:
 #pragma pack(push, 1)
@@ -123,6 +128,8 @@ private:
 
     std::vector<std::vector<int>> answers_;
 
+    SearchPoller    poller_;
+
 public:
     DancingLinks(size_t nodes)
         : list_(nodes), max_col_(0), last_idx_(0), empties_(0) {
@@ -130,6 +137,9 @@ public:
 
     ~DancingLinks() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
     bool is_empty() const { return (list_.next[0] == 0); }
 
     int cols() const { return (int)TotalLiterals; }
@@ -137,6 +147,7 @@ public:
     static size_t get_num_guesses() { return DancingLinks::num_guesses; }
     static size_t get_num_unique_candidate() { return DancingLinks::num_unique_candidate; }
     static size_t get_num_failed_return() { return DancingLinks::num_failed_return; }
+    static size_t get_num_mems() { return DancingLinks::num_mems; }
 
     static size_t get_total_search_counter() {
         return (DancingLinks::num_guesses + DancingLinks::num_unique_candidate + DancingLinks::num_failed_return);
@@ -350,7 +361,7 @@ private:
             if (min_col_size < min_col) {
                 min_col = min_col_size;
 
-                uint32_t min_col_offset = min_col_size32 >> 17U;
+                uint32_t min_col_offset = min_col_size32 >> 16U;
                 min_col_index = index_base + min_col_offset;
 
                 if (min_col == 0) {
@@ -854,12 +865,12 @@ public:
 
         this->answer_.clear();
         this->answer_.reserve(81);
-        if (kSearchMode > SEARCH_MODE_ONE_ANSWER) {
-            this->answers_.clear();
-        }
+        this->answers_.clear();
+        this->poller_.reset();
         num_guesses = 0;
         num_unique_candidate = 0;
         num_failed_return = 0;
+        num_mems = 0;
     }
 
     void build(Board & board) {
@@ -954,13 +965,17 @@ public:
         list_.prev[next] = prev;
 
         this->set_col_disable(index);
+        count_mems<StatsTy>(num_mems, 5);
 
         for (int row = list_.down[index]; row != index; row = list_.down[row]) {
+            count_mems<StatsTy>(num_mems, 1);
             for (int col = list_.next[row]; col != row; col = list_.next[col]) {
                 int up = list_.up[col];
                 int down = list_.down[col];
                 list_.down[up] = down;
                 list_.up[down] = up;
+                // next, up, down, 2 links, col and the size (read and write).
+                count_mems<StatsTy>(num_mems, 8);
 
                 uint16_t col_index = list_.col[col];
                 assert(this->get_col_size(col_index) > 0);
@@ -978,13 +993,16 @@ public:
         list_.next[prev] = index;
 
         this->set_col_enable(index);
+        count_mems<StatsTy>(num_mems, 5);
 
         for (int row = list_.up[index]; row != index; row = list_.up[row]) {
+            count_mems<StatsTy>(num_mems, 1);
             for (int col = list_.prev[row]; col != row; col = list_.prev[col]) {
                 int down = list_.down[col];
                 int up = list_.up[col];
                 list_.up[down] = col;
                 list_.down[up] = col;
+                count_mems<StatsTy>(num_mems, 8);
 
                 uint16_t col_index = list_.col[col];
                 this->inc_col_size(col_index);
@@ -993,20 +1011,23 @@ public:
         }
     }
 
+    template <size_t nSearchMode = kSearchMode>
     bool search(size_t empties) {
         if (this->is_empty()) {
-            if (kSearchMode > SearchMode::OneAnswer) {
+            if (nSearchMode > SearchMode::OneAnswer) {
                 this->answers_.push_back(this->answer_);
-                if (kSearchMode == SearchMode::MoreThanOneAnswer) {
+                if (nSearchMode == SearchMode::MoreThanOneAnswer) {
                     if (this->answers_.size() > 1)
                         return true;
                 }
+                // No column is left to pick, go on with the next branch.
+                return false;
             }
             else {
                 return true;
             }
         }
-      
+
         int min_col;
         int index;
 #if defined(__SSE2__) || defined(__SSE4_1__)
@@ -1019,10 +1040,17 @@ public:
 #endif
         assert(index > 0);
         if (min_col != 0) {
-            if (min_col == 1)
-                num_unique_candidate++;
-            else
-                num_guesses++;
+            if (min_col == 1) {
+                count_stats<StatsTy>(num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->answer_.size());
+            }
+            else {
+                count_stats<StatsTy>(num_guesses, basic_solver_t::guess_depths,
+                                     this->answer_.size());
+                // Only the guesses poll the control, the singles don't branch.
+                if (this->poller_.should_stop_at_guess())
+                    return false;
+            }
             this->remove(index);
             for (int row = list_.down[index]; row != index; row = list_.down[row]) {
                 this->answer_.push_back(list_.row[row]);
@@ -1030,11 +1058,11 @@ public:
                     this->remove(list_.col[col]);
                 }
 
-                if (this->search(empties - 1)) {
-                    if (kSearchMode == SearchMode::OneAnswer) {
+                if (this->template search<nSearchMode>(empties - 1)) {
+                    if (nSearchMode == SearchMode::OneAnswer) {
                         return true;
                     }
-                    else if (kSearchMode == SearchMode::MoreThanOneAnswer) {
+                    else if (nSearchMode == SearchMode::MoreThanOneAnswer) {
                         if (this->answers_.size() > 1)
                             return true;
                     }
@@ -1048,23 +1076,32 @@ public:
             this->restore(index);
         }
         else {
-            num_failed_return++;
+            count_stats<StatsTy>(num_failed_return, basic_solver_t::failed_depths,
+                                 this->answer_.size());
         }
 
         return false;
     }
 
+    template <size_t nSearchMode = kSearchMode>
     bool solve() {
-        return this->search(this->empties_);
+        return this->template search<nSearchMode>(this->empties_);
     }
 
-    void display_answer(Board & board) {
+    size_t answer_count() const {
+        return this->answers_.size();
+    }
+
+    void get_answer(Board & board) {
         for (auto idx : this->answer_) {
             if (idx > 0) {
                 board.cells[this->rows_[idx] * Rows + this->cols_[idx]] = (char)this->numbers_[idx] + '1';
             }
         }
+    }
 
+    void display_answer(Board & board) {
+        this->get_answer(board);
         SudokuTy::display_board(board);
     }
 
@@ -1086,39 +1123,61 @@ public:
     }
 };
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_guesses = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_guesses = 0;
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_unique_candidate = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_unique_candidate = 0;
 
-template <typename SudokuTy>
-size_t DancingLinks<SudokuTy>::num_failed_return = 0;
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_failed_return = 0;
 
-template <typename SudokuTy = Sudoku>
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingLinks<SudokuTy, StatsTy>::num_mems = 0;
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                        sudoku_t;
     typedef BasicSolver<SudokuTy>           basic_solver_t;
-    typedef DancingLinks<SudokuTy>          solver_type;
+    typedef DancingLinks<SudokuTy, StatsTy> solver_type;
+    typedef StatsTy                         stats_t;
     typedef typename SudokuTy::board_type   Board;
 
 private:
-    DancingLinks<SudokuTy> solver_;
+    DancingLinks<SudokuTy, StatsTy> solver_;
 
 public:
     Solver() : solver_(Sudoku::TotalSize * 4 + 1) {
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->solver_.control(); }
+    void set_control(SearchControl * control) { this->solver_.set_control(control); }
+
 public:
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         solver_.init(board);
         solver_.build(board);
         bool success = solver_.solve();
+        if (success && kSearchMode == SearchMode::OneAnswer)
+            solver_.get_answer(board);
         return success;
     }
 
+    // 0, 1 or 2 (more than one) solutions.
+    size_t count_solutions(const Board & board) {
+        Board temp = board;
+        if (!this->check_input(temp))
+            return 0;
+        solver_.init(temp);
+        solver_.build(temp);
+        solver_.template solve<SearchMode::MoreThanOneAnswer>();
+        return solver_.answer_count();
+    }
+
     void display_result(Board & board, double elapsed_time,
                         bool print_answer = true,
                         bool print_all_answers = true) {
@@ -0,0 +1,360 @@
+
+#ifndef JM_SUDOKU_SOLVER_DLX_V4_H
+#define JM_SUDOKU_SOLVER_DLX_V4_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <memory.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <emmintrin.h>      // For SSE 2
+#else
+#include <x86intrin.h>      // For SSE 2
+#endif // _MSC_VER
+
+#include "BasicSolver.h"
+#include "Sudoku.h"
+#include "BitUtils.h"
+#include "BitSet.h"
+
+/************************************************
+
+#define SEARCH_MODE_ONE_ANSWER              0
+#define SEARCH_MODE_MORE_THAN_ONE_ANSWER    1
+#define SEARCH_MODE_ALL_ANSWERS             2
+
+************************************************/
+
+#define DLX_V4_SEARCH_MODE      SEARCH_MODE_ONE_ANSWER
+
+//
+// Algorithm X on bitsets, there are no linked lists: the active rows of the
+// exact cover matrix are a bitset, a column knows its rows as a row bitset
+// and a row knows its 4 columns. Covering a row is an OR of the row bitsets
+// of its columns and an ANDNOT from the active rows, and the level takes
+// back its candidate by copying its small State back.
+//
+namespace jmSudoku {
+namespace dlx {
+namespace v4 {
+
+static const size_t kSearchMode = DLX_V4_SEARCH_MODE;
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
+class Solver : public BasicSolver<SudokuTy> {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef BasicSolver<SudokuTy>               basic_solver_t;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
+    typedef typename SudokuTy::board_type       Board;
+
+    static const size_t BoxCellsX = SudokuTy::BoxCellsX;      // 3
+    static const size_t BoxCellsY = SudokuTy::BoxCellsY;      // 3
+    static const size_t BoxCountX = SudokuTy::BoxCountX;      // 3
+
+    static const size_t Rows = SudokuTy::Rows;
+    static const size_t Cols = SudokuTy::Cols;
+    static const size_t Boxes = SudokuTy::Boxes;
+    static const size_t Numbers = SudokuTy::Numbers;
+
+    static const size_t BoardSize = SudokuTy::BoardSize;
+
+    // The rows of the matrix are the candidates [pos][num], the columns are
+    // the constraints [cell, row-num, col-num, box-num].
+    static const size_t MatrixRows = SudokuTy::TotalSize;
+    static const size_t MatrixCols = SudokuTy::TotalLiterals;
+    static const size_t MatrixCols16 = AlignedTo<MatrixCols, 16>::value;
+    static const size_t ColsPerRow = 4;
+
+    static const uint8_t kCoveredCol = 0xFF;
+
+    typedef WordBitSet<MatrixRows> row_bitset_t;
+
+private:
+    //
+    // Everything that a level changes, about 450 bytes, the level keeps a
+    // copy and copies it back after every candidate.
+    //
+    struct State {
+        alignas(16) uint8_t col_sizes[MatrixCols16];    // kCoveredCol: covered
+        row_bitset_t        rows;                       // The active rows
+        size_t              cols_left;
+    };
+
+    alignas(16) State   state_;
+    Board               board_;
+    SearchPoller        poller_;
+
+    uint16_t            answer_[BoardSize];
+
+    static bool mask_is_inited;
+    static row_bitset_t col_rows_mask[MatrixCols];          // [col] -> rows
+    static uint16_t     row_cols[MatrixRows][ColsPerRow];   // [row] -> cols
+
+public:
+    Solver() {
+        if (!mask_is_inited) {
+            init_mask();
+            mask_is_inited = true;
+        }
+    }
+    ~Solver() {}
+
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
+private:
+    static void init_mask() {
+        for (size_t col = 0; col < MatrixCols; col++) {
+            col_rows_mask[col].reset();
+        }
+
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            size_t row = pos / Cols;
+            size_t col = pos % Cols;
+            size_t box = (row / BoxCellsY) * BoxCountX + (col / BoxCellsX);
+            for (size_t num = 0; num < Numbers; num++) {
+                size_t matrix_row = pos * Numbers + num;
+                row_cols[matrix_row][0] = (uint16_t)(pos);
+                row_cols[matrix_row][1] = (uint16_t)(BoardSize * 1 + row * Numbers + num);
+                row_cols[matrix_row][2] = (uint16_t)(BoardSize * 2 + col * Numbers + num);
+                row_cols[matrix_row][3] = (uint16_t)(BoardSize * 3 + box * Numbers + num);
+                for (size_t i = 0; i < ColsPerRow; i++) {
+                    col_rows_mask[row_cols[matrix_row][i]].set(matrix_row);
+                }
+            }
+        }
+    }
+
+    void init_state() {
+        std::memset((void *)&this->state_.col_sizes[0], (int)Numbers, MatrixCols);
+        std::memset((void *)&this->state_.col_sizes[MatrixCols], kCoveredCol, MatrixCols16 - MatrixCols);
+        this->state_.rows.fill();
+        this->state_.cols_left = MatrixCols;
+    }
+
+    //
+    // Takes the matrix row into the answer: its columns are covered, and all
+    // the active rows of these columns (itself too) are removed.
+    //
+    inline void cover(size_t matrix_row) {
+        assert(this->state_.rows.test(matrix_row));
+        const uint16_t * cols = &row_cols[matrix_row][0];
+
+        row_bitset_t removed;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            removed.words[i] = (col_rows_mask[cols[0]].words[i] | col_rows_mask[cols[1]].words[i] |
+                                col_rows_mask[cols[2]].words[i] | col_rows_mask[cols[3]].words[i]) &
+                               this->state_.rows.words[i];
+        }
+        this->state_.rows.and_not(removed);
+
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            size_t bits = removed.words[i];
+            while (bits != 0) {
+                size_t bit = BitUtils::ls1b(bits);
+                size_t removed_row = i * row_bitset_t::kWordBits + BitUtils::bsf(bit);
+                bits ^= bit;
+
+                const uint16_t * removed_cols = &row_cols[removed_row][0];
+                this->state_.col_sizes[removed_cols[0]]--;
+                this->state_.col_sizes[removed_cols[1]]--;
+                this->state_.col_sizes[removed_cols[2]]--;
+                this->state_.col_sizes[removed_cols[3]]--;
+            }
+        }
+
+        for (size_t i = 0; i < ColsPerRow; i++) {
+            this->state_.col_sizes[cols[i]] = kCoveredCol;
+        }
+        this->state_.cols_left -= ColsPerRow;
+    }
+
+    //
+    // The uncovered column with the fewest active rows, the first one of them.
+    //
+    inline size_t get_min_column(size_t & out_min_size) const {
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128i * sizes = (const __m128i *)&this->state_.col_sizes[0];
+        __m128i min_sizes = _mm_load_si128(sizes);
+        for (size_t i = 1; i < MatrixCols16 / 16; i++) {
+            min_sizes = _mm_min_epu8(min_sizes, _mm_load_si128(sizes + i));
+        }
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 8));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 4));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 2));
+        min_sizes = _mm_min_epu8(min_sizes, _mm_srli_si128(min_sizes, 1));
+        size_t min_size = (size_t)(_mm_cvtsi128_si32(min_sizes) & 0xFF);
+
+        __m128i min_mask = _mm_set1_epi8((char)min_size);
+        for (size_t i = 0; i < MatrixCols16 / 16; i++) {
+            int equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(sizes + i), min_mask));
+            if (equal_mask != 0) {
+                out_min_size = min_size;
+                return (i * 16 + BitUtils::bsf32((uint32_t)equal_mask));
+            }
+        }
+        assert(false);
+        out_min_size = min_size;
+        return 0;
+#else
+        size_t min_size = kCoveredCol;
+        size_t min_col = 0;
+        for (size_t col = 0; col < MatrixCols; col++) {
+            size_t col_size = this->state_.col_sizes[col];
+            if (col_size < min_size) {
+                min_size = col_size;
+                min_col = col;
+                if (col_size == 0)
+                    break;
+            }
+        }
+        out_min_size = min_size;
+        return min_col;
+#endif
+    }
+
+    void get_answer(Board & board, size_t depth) const {
+        for (size_t i = 0; i < depth; i++) {
+            size_t matrix_row = this->answer_[i];
+            board.cells[matrix_row / Numbers] = (char)(matrix_row % Numbers + '1');
+        }
+    }
+
+    template <size_t nSearchMode>
+    bool search(size_t depth) {
+        if (this->state_.cols_left == 0) {
+            if (nSearchMode > SearchMode::OneAnswer) {
+                Board answer = this->board_;
+                this->get_answer(answer, depth);
+                this->answers_.push_back(answer);
+                if (nSearchMode == SearchMode::MoreThanOneAnswer) {
+                    if (this->answers_.size() > 1)
+                        return true;
+                }
+                return false;
+            }
+            else {
+                return true;
+            }
+        }
+
+        size_t min_size;
+        size_t min_col = this->get_min_column(min_size);
+        assert(min_size != kCoveredCol);
+        if (min_size == 0) {
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths, depth);
+            return false;
+        }
+
+        if (min_size == 1) {
+            count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths, depth);
+        }
+        else {
+            count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths, depth);
+            // Only the guesses poll the control, the singles don't branch.
+            if (this->poller_.should_stop_at_guess())
+                return false;
+        }
+
+        row_bitset_t candidates;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            candidates.words[i] = col_rows_mask[min_col].words[i] & this->state_.rows.words[i];
+        }
+
+        alignas(16) State saved_state = this->state_;
+        size_t candidates_left = min_size;
+        for (size_t i = 0; i < row_bitset_t::kWords; i++) {
+            size_t bits = candidates.words[i];
+            while (bits != 0) {
+                size_t bit = BitUtils::ls1b(bits);
+                size_t matrix_row = i * row_bitset_t::kWordBits + BitUtils::bsf(bit);
+                bits ^= bit;
+
+                this->cover(matrix_row);
+                this->answer_[depth] = (uint16_t)matrix_row;
+
+                if (this->template search<nSearchMode>(depth + 1)) {
+                    return true;
+                }
+
+                // The last candidate leaves the state to the caller.
+                candidates_left--;
+                if (candidates_left != 0)
+                    this->state_ = saved_state;
+            }
+        }
+
+        return false;
+    }
+
+public:
+    template <size_t nSearchMode = kSearchMode>
+    bool solve(Board & board) {
+        if (nSearchMode > SearchMode::OneAnswer) {
+            this->answers_.clear();
+        }
+        if (!this->check_input(board))
+            return false;
+
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
+
+        this->init_state();
+        size_t empties = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            unsigned char val = board.cells[pos];
+            if (val != '.') {
+                size_t num = val - '1';
+                this->cover(pos * Numbers + num);
+            }
+            else {
+                empties++;
+            }
+        }
+        this->empties_ = empties;
+        this->board_ = board;
+
+        bool success = this->template search<nSearchMode>(0);
+        if (success && nSearchMode == SearchMode::OneAnswer)
+            this->get_answer(board, empties);
+        return success;
+    }
+
+    void display_result(Board & board, double elapsed_time,
+                        bool print_answer = true,
+                        bool print_all_answers = true) {
+        basic_solver_t::template display_result<kSearchMode>(board, elapsed_time, print_answer, print_all_answers);
+    }
+};
+
+template <typename SudokuTy, typename StatsTy>
+bool Solver<SudokuTy, StatsTy>::mask_is_inited = false;
+
+template <typename SudokuTy, typename StatsTy>
+typename Solver<SudokuTy, StatsTy>::row_bitset_t
+Solver<SudokuTy, StatsTy>::col_rows_mask[Solver<SudokuTy, StatsTy>::MatrixCols];
+
+template <typename SudokuTy, typename StatsTy>
+uint16_t Solver<SudokuTy, StatsTy>::row_cols[Solver<SudokuTy, StatsTy>::MatrixRows][Solver<SudokuTy, StatsTy>::ColsPerRow];
+
+} // namespace v4
+} // namespace dlx
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SOLVER_DLX_V4_H
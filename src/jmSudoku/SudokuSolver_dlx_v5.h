@@ -0,0 +1,517 @@
+
+#ifndef JM_SUDOKU_SOLVER_DLX_V5_H
+#define JM_SUDOKU_SOLVER_DLX_V5_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <memory.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+
+#include "BasicSolver.h"
+#include "Sudoku.h"
+
+/************************************************
+
+#define SEARCH_MODE_ONE_ANSWER              0
+#define SEARCH_MODE_MORE_THAN_ONE_ANSWER    1
+#define SEARCH_MODE_ALL_ANSWERS             2
+
+************************************************/
+
+#define DLX_V5_SEARCH_MODE      SEARCH_MODE_ONE_ANSWER
+
+//
+// Dancing cells: Algorithm X on sparse sets (Knuth, TAOCP 7.2.2.1), there are
+// no up/down chains. Every item (column) keeps its options (rows) in a fixed
+// slot of Numbers entries, the first size[item] of them are active. An option
+// leaves a set by a swap with the last active one, and comes back only by
+// incrementing the size again, in the reverse order of the removals. The
+// active items are a sparse set too.
+//
+namespace jmSudoku {
+namespace dlx {
+namespace v5 {
+
+static const size_t kSearchMode = DLX_V5_SEARCH_MODE;
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
+class DancingCells {
+public:
+    static const size_t Rows = SudokuTy::Rows;
+    static const size_t Cols = SudokuTy::Cols;
+    static const size_t Boxes = SudokuTy::Boxes;
+    static const size_t Numbers = SudokuTy::Numbers;
+
+    static const size_t BoxCellsX = SudokuTy::BoxCellsX;
+    static const size_t BoxCellsY = SudokuTy::BoxCellsY;
+    static const size_t BoxCountX = SudokuTy::BoxCountX;
+
+    static const size_t BoardSize = SudokuTy::BoardSize;
+    static const size_t TotalSize = SudokuTy::TotalSize;            // The options
+    static const size_t TotalLiterals = SudokuTy::TotalLiterals;    // The items
+
+    // The items of an option: [cell, row-num, col-num, box-num], the k-th item
+    // of every option has the same kind, so k is also its index in the option.
+    static const size_t ItemsPerOption = 4;
+
+    // Every item is met by Numbers options at most.
+    static const size_t SetCapacity = Numbers;
+
+    typedef typename SudokuTy::board_type   Board;
+    typedef BasicSolver<SudokuTy>           basic_solver_t;
+
+    // Per thread, so the solvers can run on several threads.
+    static thread_local size_t num_guesses;
+    static thread_local size_t num_unique_candidate;
+    static thread_local size_t num_failed_return;
+
+    // The mems of cover() and uncover(), DetailedStats only.
+    static thread_local size_t num_mems;
+
+private:
+    uint16_t    set_[TotalLiterals * SetCapacity];      // [item][slot] -> option
+    uint8_t     size_[TotalLiterals];                   // [item]
+    uint8_t     slot_[TotalSize][ItemsPerOption];       // [option][k] -> slot in set_[item]
+
+    uint16_t    items_[TotalLiterals];                  // The active items first
+    uint16_t    item_index_[TotalLiterals];             // [item] -> index in items_[]
+    size_t      active_items_;
+
+    size_t      empties_;
+    std::vector<int>                answer_;
+    std::vector<std::vector<int>>   answers_;
+
+    SearchPoller    poller_;
+
+    static bool     mask_is_inited;
+    static uint16_t option_items[TotalSize][ItemsPerOption];    // [option][k] -> item
+
+public:
+    DancingCells() : active_items_(0), empties_(0) {
+        if (!mask_is_inited) {
+            init_mask();
+            mask_is_inited = true;
+        }
+    }
+
+    ~DancingCells() {}
+
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
+    bool is_empty() const { return (this->active_items_ == 0); }
+
+    int cols() const { return (int)TotalLiterals; }
+
+    static size_t get_num_guesses() { return DancingCells::num_guesses; }
+    static size_t get_num_unique_candidate() { return DancingCells::num_unique_candidate; }
+    static size_t get_num_failed_return() { return DancingCells::num_failed_return; }
+    static size_t get_num_mems() { return DancingCells::num_mems; }
+
+    static size_t get_total_search_counter() {
+        return (DancingCells::num_guesses + DancingCells::num_unique_candidate + DancingCells::num_failed_return);
+    }
+
+    static double get_guess_percent() {
+        return calc_percent(DancingCells::num_guesses, DancingCells::get_total_search_counter());
+    }
+
+    static double get_failed_return_percent() {
+        return calc_percent(DancingCells::num_failed_return, DancingCells::get_total_search_counter());
+    }
+
+    static double get_unique_candidate_percent() {
+        return calc_percent(DancingCells::num_unique_candidate, DancingCells::get_total_search_counter());
+    }
+
+private:
+    static void init_mask() {
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            size_t row = pos / Cols;
+            size_t col = pos % Cols;
+            size_t box = (row / BoxCellsY) * BoxCountX + (col / BoxCellsX);
+            for (size_t num = 0; num < Numbers; num++) {
+                size_t option = pos * Numbers + num;
+                option_items[option][0] = (uint16_t)(pos);
+                option_items[option][1] = (uint16_t)(BoardSize * 1 + row * Numbers + num);
+                option_items[option][2] = (uint16_t)(BoardSize * 2 + col * Numbers + num);
+                option_items[option][3] = (uint16_t)(BoardSize * 3 + box * Numbers + num);
+            }
+        }
+    }
+
+    // Swaps the item out of the active items.
+    inline void deactivate_item(size_t item) {
+        size_t index = this->item_index_[item];
+        size_t last = --this->active_items_;
+        size_t last_item = this->items_[last];
+        this->items_[index] = (uint16_t)last_item;
+        this->item_index_[last_item] = (uint16_t)index;
+        this->items_[last] = (uint16_t)item;
+        this->item_index_[item] = (uint16_t)last;
+        count_mems<StatsTy>(num_mems, 6);
+    }
+
+    //
+    // Takes the item out of the active items, and every option that meets it
+    // out of the sets of its other items. The set of the item itself is kept,
+    // it is walked again in the same order by uncover().
+    //
+    void cover(size_t item) {
+        this->deactivate_item(item);
+
+        const uint16_t * item_set = &this->set_[item * SetCapacity];
+        size_t item_size = this->size_[item];
+        count_mems<StatsTy>(num_mems, 1);
+        for (size_t i = 0; i < item_size; i++) {
+            size_t option = item_set[i];
+            const uint16_t * items = &option_items[option][0];
+            count_mems<StatsTy>(num_mems, 1);
+            for (size_t k = 0; k < ItemsPerOption; k++) {
+                size_t other = items[k];
+                if (other == item)
+                    continue;
+                uint16_t * other_set = &this->set_[other * SetCapacity];
+                size_t slot = this->slot_[option][k];
+                size_t last = --this->size_[other];
+                size_t last_option = other_set[last];
+                other_set[slot] = (uint16_t)last_option;
+                other_set[last] = (uint16_t)option;
+                this->slot_[last_option][k] = (uint8_t)slot;
+                this->slot_[option][k] = (uint8_t)last;
+                // The item, the slot, the size (read and write), the last
+                // option and the 2 set entries and the 2 slots.
+                count_mems<StatsTy>(num_mems, 9);
+            }
+        }
+    }
+
+    //
+    // The exact reverse of cover(): the removed options are still behind the
+    // active ones, so the sizes are only incremented again.
+    //
+    void uncover(size_t item) {
+        const uint16_t * item_set = &this->set_[item * SetCapacity];
+        size_t item_size = this->size_[item];
+        count_mems<StatsTy>(num_mems, 1);
+        for (size_t i = item_size; i > 0; i--) {
+            size_t option = item_set[i - 1];
+            const uint16_t * items = &option_items[option][0];
+            count_mems<StatsTy>(num_mems, 1);
+            for (size_t k = ItemsPerOption; k > 0; k--) {
+                size_t other = items[k - 1];
+                if (other == item)
+                    continue;
+                this->size_[other]++;
+                // The item and the size (read and write).
+                count_mems<StatsTy>(num_mems, 3);
+            }
+        }
+
+        // The item is still behind the active items.
+        assert(this->items_[this->active_items_] == item);
+        this->active_items_++;
+        count_mems<StatsTy>(num_mems, 1);
+    }
+
+    int get_min_item(size_t & out_min_size) const {
+        size_t min_size = size_t(-1);
+        size_t min_item = 0;
+        for (size_t i = 0; i < this->active_items_; i++) {
+            size_t item = this->items_[i];
+            size_t item_size = this->size_[item];
+            if (item_size < min_size) {
+                min_size = item_size;
+                min_item = item;
+                if (item_size <= 1)
+                    break;
+            }
+        }
+        out_min_size = min_size;
+        return (int)min_item;
+    }
+
+public:
+    void init(Board & board) {
+        this->answer_.clear();
+        this->answer_.reserve(BoardSize);
+        this->answers_.clear();
+        this->poller_.reset();
+        num_guesses = 0;
+        num_unique_candidate = 0;
+        num_failed_return = 0;
+        num_mems = 0;
+    }
+
+    //
+    // Only the options of the empty cells that the givens allow and the items
+    // that the givens don't meet are built.
+    //
+    void build(Board & board) {
+        bool item_met[TotalLiterals];
+        std::memset((void *)&item_met[0], 0, sizeof(item_met));
+        std::memset((void *)&this->size_[0], 0, sizeof(this->size_));
+
+        size_t empties = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            unsigned char val = board.cells[pos];
+            if (val != '.') {
+                size_t num = val - '1';
+                const uint16_t * items = &option_items[pos * Numbers + num][0];
+                for (size_t k = 0; k < ItemsPerOption; k++) {
+                    item_met[items[k]] = true;
+                }
+            }
+            else {
+                empties++;
+            }
+        }
+        this->empties_ = empties;
+
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (board.cells[pos] != '.')
+                continue;
+            for (size_t num = 0; num < Numbers; num++) {
+                size_t option = pos * Numbers + num;
+                const uint16_t * items = &option_items[option][0];
+                if (item_met[items[1]] || item_met[items[2]] || item_met[items[3]])
+                    continue;
+                for (size_t k = 0; k < ItemsPerOption; k++) {
+                    size_t item = items[k];
+                    size_t slot = this->size_[item]++;
+                    this->set_[item * SetCapacity + slot] = (uint16_t)option;
+                    this->slot_[option][k] = (uint8_t)slot;
+                }
+            }
+        }
+
+        size_t active_items = 0;
+        size_t inactive_index = TotalLiterals;
+        for (size_t item = 0; item < TotalLiterals; item++) {
+            size_t index = (!item_met[item]) ? (active_items++) : (--inactive_index);
+            this->items_[index] = (uint16_t)item;
+            this->item_index_[item] = (uint16_t)index;
+        }
+        this->active_items_ = active_items;
+    }
+
+    template <size_t nSearchMode = kSearchMode>
+    bool search(size_t empties) {
+        if (this->is_empty()) {
+            if (nSearchMode > SearchMode::OneAnswer) {
+                this->answers_.push_back(this->answer_);
+                if (nSearchMode == SearchMode::MoreThanOneAnswer) {
+                    if (this->answers_.size() > 1)
+                        return true;
+                }
+                // No item is left to pick, go on with the next branch.
+                return false;
+            }
+            else {
+                return true;
+            }
+        }
+
+        size_t min_size;
+        int item = this->get_min_item(min_size);
+        if (min_size != 0) {
+            if (min_size == 1) {
+                count_stats<StatsTy>(num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->answer_.size());
+            }
+            else {
+                count_stats<StatsTy>(num_guesses, basic_solver_t::guess_depths,
+                                     this->answer_.size());
+                // Only the guesses poll the control, the singles don't branch.
+                if (this->poller_.should_stop_at_guess())
+                    return false;
+            }
+            this->cover(item);
+            const uint16_t * item_set = &this->set_[item * SetCapacity];
+            for (size_t i = 0; i < min_size; i++) {
+                size_t option = item_set[i];
+                const uint16_t * items = &option_items[option][0];
+                this->answer_.push_back((int)option);
+                for (size_t k = 0; k < ItemsPerOption; k++) {
+                    if (items[k] != (uint16_t)item)
+                        this->cover(items[k]);
+                }
+
+                if (this->template search<nSearchMode>(empties - 1)) {
+                    if (nSearchMode == SearchMode::OneAnswer) {
+                        return true;
+                    }
+                    else if (nSearchMode == SearchMode::MoreThanOneAnswer) {
+                        if (this->answers_.size() > 1)
+                            return true;
+                    }
+                }
+
+                for (size_t k = ItemsPerOption; k > 0; k--) {
+                    if (items[k - 1] != (uint16_t)item)
+                        this->uncover(items[k - 1]);
+                }
+                this->answer_.pop_back();
+            }
+            this->uncover(item);
+        }
+        else {
+            count_stats<StatsTy>(num_failed_return, basic_solver_t::failed_depths,
+                                 this->answer_.size());
+        }
+
+        return false;
+    }
+
+    template <size_t nSearchMode = kSearchMode>
+    bool solve() {
+        return this->template search<nSearchMode>(this->empties_);
+    }
+
+    size_t answer_count() const {
+        return this->answers_.size();
+    }
+
+    void get_answer(Board & board) {
+        for (auto option : this->answer_) {
+            board.cells[option / Numbers] = (char)(option % Numbers + '1');
+        }
+    }
+
+    void display_answer(Board & board) {
+        this->get_answer(board);
+        SudokuTy::display_board(board);
+    }
+
+    void display_answers(Board & board) {
+        printf("Total answers: %d\n\n", (int)this->answers_.size());
+        int i = 0;
+        for (auto answer : this->answers_) {
+            SudokuTy::clear_board(board);
+            for (auto option : answer) {
+                board.cells[option / Numbers] = (char)(option % Numbers + '1');
+            }
+            SudokuTy::display_board(board, false, i);
+            i++;
+            if (i > 100)
+                break;
+        }
+    }
+};
+
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingCells<SudokuTy, StatsTy>::num_guesses = 0;
+
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingCells<SudokuTy, StatsTy>::num_unique_candidate = 0;
+
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingCells<SudokuTy, StatsTy>::num_failed_return = 0;
+
+template <typename SudokuTy, typename StatsTy>
+thread_local size_t DancingCells<SudokuTy, StatsTy>::num_mems = 0;
+
+template <typename SudokuTy, typename StatsTy>
+bool DancingCells<SudokuTy, StatsTy>::mask_is_inited = false;
+
+template <typename SudokuTy, typename StatsTy>
+uint16_t DancingCells<SudokuTy, StatsTy>::option_items[DancingCells<SudokuTy, StatsTy>::TotalSize]
+                                                      [DancingCells<SudokuTy, StatsTy>::ItemsPerOption];
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
+class Solver : public BasicSolver<SudokuTy> {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef BasicSolver<SudokuTy>               basic_solver_t;
+    typedef DancingCells<SudokuTy, StatsTy>     solver_type;
+    typedef StatsTy                             stats_t;
+    typedef typename SudokuTy::board_type       Board;
+
+private:
+    DancingCells<SudokuTy, StatsTy> solver_;
+
+public:
+    Solver() {}
+    ~Solver() {}
+
+    SearchControl * control() const { return this->solver_.control(); }
+    void set_control(SearchControl * control) { this->solver_.set_control(control); }
+
+public:
+    bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
+        solver_.init(board);
+        solver_.build(board);
+        bool success = solver_.solve();
+        if (success && kSearchMode == SearchMode::OneAnswer)
+            solver_.get_answer(board);
+        return success;
+    }
+
+    //
+    // Complete search in the given search mode, returns the number of answers:
+    // OneAnswer: 0 or 1, the answer is written to the board.
+    // MoreThanOneAnswer: 0, 1 or 2 (2 means more than one).
+    // AllAnswers: the number of all answers.
+    //
+    template <size_t nSearchMode>
+    size_t search(Board & board) {
+        if (!this->check_input(board))
+            return 0;
+        solver_.init(board);
+        solver_.build(board);
+        bool success = solver_.template solve<nSearchMode>();
+        if (nSearchMode == SearchMode::OneAnswer) {
+            if (success)
+                solver_.get_answer(board);
+            return (success ? 1 : 0);
+        }
+        else {
+            return solver_.answer_count();
+        }
+    }
+
+    // 0, 1 or 2 (more than one) solutions.
+    size_t count_solutions(const Board & board) {
+        Board temp = board;
+        return this->template search<SearchMode::MoreThanOneAnswer>(temp);
+    }
+
+    void display_result(Board & board, double elapsed_time,
+                        bool print_answer = true,
+                        bool print_all_answers = true) {
+        if (print_answer) {
+            if (kSearchMode > SearchMode::OneAnswer)
+                solver_.display_answers(board);
+            else
+                solver_.display_answer(board);
+        }
+        printf("elapsed time: %0.3f ms, recur_counter: %" PRIuPTR "\n\n"
+                "num_guesses: %" PRIuPTR ", num_failed_return: %" PRIuPTR ", num_unique_candidate: %" PRIuPTR "\n"
+                "guess %% = %0.1f %%, failed_return %% = %0.1f %%, unique_candidate %% = %0.1f %%\n\n",
+                elapsed_time, solver_type::get_total_search_counter(),
+                solver_type::get_num_guesses(),
+                solver_type::get_num_failed_return(),
+                solver_type::get_num_unique_candidate(),
+                solver_type::get_guess_percent(),
+                solver_type::get_failed_return_percent(),
+                solver_type::get_unique_candidate_percent());
+    }
+};
+
+} // namespace v5
+} // namespace dlx
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SOLVER_DLX_V5_H
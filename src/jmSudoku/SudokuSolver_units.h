@@ -0,0 +1,384 @@
+
+#ifndef JM_SUDOKU_SOLVER_UNITS_H
+#define JM_SUDOKU_SOLVER_UNITS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <memory.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>      // For std::memset()
+#include <vector>
+
+#include "BasicSolver.h"
+#include "Sudoku.h"
+#include "SudokuUnits.h"
+#include "BitUtils.h"
+#include "BitSet.h"
+
+/************************************************
+
+#define SEARCH_MODE_ONE_ANSWER              0
+#define SEARCH_MODE_MORE_THAN_ONE_ANSWER    1
+#define SEARCH_MODE_ALL_ANSWERS             2
+
+************************************************/
+
+#define UNITS_SEARCH_MODE       SEARCH_MODE_ONE_ANSWER
+
+//
+// The v3 search on a constraint description: the candidates are one board
+// of cells per number, a filled number takes the peers of its cell (from
+// the Units) out of its board. Like v3, every node looks for the literal
+// with the fewest candidates, a cell [pos] or a unit [unit][num]:
+//
+//   - the cells by a bit sliced count of the number boards: the empty cells
+//     with no candidate, one (a naked single), two, or more,
+//   - the [unit][num] by a popcount of the board of num in the unit mask,
+//     for the numbers that the unit is still missing (a hidden single).
+//
+// The singles are filled in place, the level branches on a literal of 2 or
+// more candidates and copies its small State back after every candidate.
+//
+namespace jmSudoku {
+namespace units {
+
+static const size_t kSearchMode = UNITS_SEARCH_MODE;
+
+template <typename SudokuTy = Sudoku, typename StatsTy = BasicStats>
+class Solver : public BasicSolver<SudokuTy> {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef BasicSolver<SudokuTy>               basic_solver_t;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
+    typedef typename SudokuTy::board_type       Board;
+    typedef Units<SudokuTy>                     units_t;
+    typedef typename units_t::cell_mask_t       cell_mask_t;
+
+    static const size_t Numbers = SudokuTy::Numbers;
+    static const size_t BoardSize = SudokuTy::BoardSize;
+    static const size_t MaxUnits = units_t::MaxUnits;
+    static const size_t kWords = cell_mask_t::kWords;
+
+    static const uint32_t kAllNumbers = (uint32_t)((size_t(1) << Numbers) - 1);
+
+private:
+    // Everything that a level changes, the level keeps a copy of it.
+    struct State {
+        cell_mask_t nums[Numbers];          // [num] -> the candidate cells
+        cell_mask_t empties;                // The empty cells
+        uint32_t    unit_nums[MaxUnits];    // [unit] -> the filled numbers
+        size_t      empty_count;
+    };
+
+    // The literal of a branch, a cell or a [unit][num].
+    enum LiteralKind {
+        NoLiteral,
+        CellLiteral,
+        UnitLiteral
+    };
+
+    State               state_;
+    Board               board_;
+    SearchPoller        poller_;
+    const units_t &     units_;
+
+public:
+    Solver(const units_t & units) : units_(units) {
+        assert(units.is_compiled());
+    }
+    ~Solver() {}
+
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
+    const units_t & units() const { return this->units_; }
+
+private:
+    void init_state() {
+        for (size_t num = 0; num < Numbers; num++) {
+            this->state_.nums[num].fill();
+        }
+        this->state_.empties.fill();
+        std::memset((void *)&this->state_.unit_nums[0], 0, sizeof(this->state_.unit_nums));
+        this->state_.empty_count = BoardSize;
+    }
+
+    // Fills num into the cell, it must be a candidate of the cell.
+    inline void fill_num(size_t pos, size_t num) {
+        assert(this->state_.nums[num].test(pos));
+        for (size_t n = 0; n < Numbers; n++) {
+            this->state_.nums[n].reset(pos);
+        }
+        this->state_.nums[num].and_not(this->units_.peers(pos));
+        this->state_.empties.reset(pos);
+
+        const uint8_t * cell_units = this->units_.cell_units(pos);
+        size_t unit_count = this->units_.cell_unit_count(pos);
+        uint32_t num_bit = 1U << num;
+        for (size_t i = 0; i < unit_count; i++) {
+            this->state_.unit_nums[cell_units[i]] |= num_bit;
+        }
+        this->state_.empty_count--;
+        this->board_.cells[pos] = (char)('1' + num);
+    }
+
+    //
+    // Fills the singles until there is none, then finds the literal of the
+    // branch. Returns false if a literal has no candidate.
+    //
+    bool fill_singles_and_find_literal(size_t depth, LiteralKind & kind,
+                                       size_t & literal, size_t & literal_num) {
+        for (;;) {
+            if (this->state_.empty_count == 0) {
+                kind = LiteralKind::NoLiteral;
+                return true;
+            }
+
+            // The empty cells with >= 1, >= 2 and >= 3 candidates.
+            cell_mask_t ones, twos, threes;
+            for (size_t w = 0; w < kWords; w++) {
+                size_t one = 0, two = 0, three = 0;
+                for (size_t num = 0; num < Numbers; num++) {
+                    size_t bits = this->state_.nums[num].words[w];
+                    three |= two & bits;
+                    two |= one & bits;
+                    one |= bits;
+                }
+                ones.words[w] = one;
+                twos.words[w] = two;
+                threes.words[w] = three;
+            }
+
+            size_t single_pos = BoardSize;
+            size_t pair_pos = BoardSize;
+            for (size_t w = 0; w < kWords; w++) {
+                if ((this->state_.empties.words[w] & ~ones.words[w]) != 0) {
+                    count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths, depth);
+                    return false;
+                }
+                size_t singles = ones.words[w] & ~twos.words[w];
+                if (singles != 0 && single_pos == BoardSize)
+                    single_pos = w * cell_mask_t::kWordBits + BitUtils::bsf(singles);
+                size_t pairs = twos.words[w] & ~threes.words[w];
+                if (pairs != 0 && pair_pos == BoardSize)
+                    pair_pos = w * cell_mask_t::kWordBits + BitUtils::bsf(pairs);
+            }
+
+            if (single_pos != BoardSize) {
+                size_t num = 0;
+                while (!this->state_.nums[num].test(single_pos)) {
+                    num++;
+                }
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths, depth);
+                this->fill_num(single_pos, num);
+                continue;
+            }
+
+            // The numbers that the units are still missing.
+            size_t min_size = Numbers + 1;
+            size_t min_unit = 0, min_num = 0;
+            bool has_single = false;
+            for (size_t unit = 0; unit < this->units_.unit_count(); unit++) {
+                uint32_t missing = kAllNumbers & ~this->state_.unit_nums[unit];
+                const cell_mask_t & unit_mask = this->units_.unit_mask(unit);
+                while (missing != 0) {
+                    size_t num = BitUtils::bsf32(missing);
+                    missing &= missing - 1;
+                    size_t size = 0;
+                    for (size_t w = 0; w < kWords; w++) {
+                        size += BitUtils::popcnt(this->state_.nums[num].words[w] & unit_mask.words[w]);
+                    }
+                    if (size < min_size) {
+                        min_size = size;
+                        min_unit = unit;
+                        min_num = num;
+                        if (size <= 1)
+                            break;
+                    }
+                }
+                if (min_size == 0) {
+                    count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths, depth);
+                    return false;
+                }
+                if (min_size == 1) {
+                    has_single = true;
+                    break;
+                }
+            }
+
+            if (has_single) {
+                const cell_mask_t & unit_mask = this->units_.unit_mask(min_unit);
+                size_t pos = BoardSize;
+                for (size_t w = 0; w < kWords; w++) {
+                    size_t bits = this->state_.nums[min_num].words[w] & unit_mask.words[w];
+                    if (bits != 0) {
+                        pos = w * cell_mask_t::kWordBits + BitUtils::bsf(bits);
+                        break;
+                    }
+                }
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths, depth);
+                this->fill_num(pos, min_num);
+                continue;
+            }
+
+            // A cell of two candidates first, it is the cheapest to walk.
+            if (pair_pos != BoardSize) {
+                kind = LiteralKind::CellLiteral;
+                literal = pair_pos;
+            }
+            else {
+                // Every empty cell has 3 or more candidates, rare.
+                size_t min_cell_size = Numbers + 1;
+                size_t min_pos = BoardSize;
+                for (size_t pos = 0; pos < BoardSize; pos++) {
+                    if (this->state_.empties.test(pos)) {
+                        size_t size = 0;
+                        for (size_t num = 0; num < Numbers; num++) {
+                            size += this->state_.nums[num].test(pos) ? 1 : 0;
+                        }
+                        if (size < min_cell_size) {
+                            min_cell_size = size;
+                            min_pos = pos;
+                        }
+                    }
+                }
+                if (min_cell_size <= min_size) {
+                    kind = LiteralKind::CellLiteral;
+                    literal = min_pos;
+                }
+                else {
+                    kind = LiteralKind::UnitLiteral;
+                    literal = min_unit;
+                    literal_num = min_num;
+                }
+            }
+            return true;
+        }
+    }
+
+    template <size_t nSearchMode>
+    bool search(size_t depth) {
+        LiteralKind kind;
+        size_t literal = 0, literal_num = 0;
+        if (!this->fill_singles_and_find_literal(depth, kind, literal, literal_num))
+            return false;
+
+        if (kind == LiteralKind::NoLiteral) {
+            if (nSearchMode > SearchMode::OneAnswer) {
+                this->answers_.push_back(this->board_);
+                if (nSearchMode == SearchMode::MoreThanOneAnswer) {
+                    if (this->answers_.size() > 1)
+                        return true;
+                }
+                return false;
+            }
+            else {
+                return true;
+            }
+        }
+
+        count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths, depth);
+        // Only the guesses poll the control, the singles don't branch.
+        if (this->poller_.should_stop_at_guess())
+            return false;
+
+        State saved_state = this->state_;
+        if (kind == LiteralKind::CellLiteral) {
+            size_t pos = literal;
+            for (size_t num = 0; num < Numbers; num++) {
+                if (saved_state.nums[num].test(pos)) {
+                    this->fill_num(pos, num);
+                    if (this->template search<nSearchMode>(depth + 1))
+                        return true;
+                    this->state_ = saved_state;
+                }
+            }
+        }
+        else {
+            const cell_mask_t & unit_mask = this->units_.unit_mask(literal);
+            for (size_t w = 0; w < kWords; w++) {
+                size_t bits = saved_state.nums[literal_num].words[w] & unit_mask.words[w];
+                while (bits != 0) {
+                    size_t bit = BitUtils::ls1b(bits);
+                    size_t pos = w * cell_mask_t::kWordBits + BitUtils::bsf(bit);
+                    bits ^= bit;
+
+                    this->fill_num(pos, literal_num);
+                    if (this->template search<nSearchMode>(depth + 1))
+                        return true;
+                    this->state_ = saved_state;
+                }
+            }
+        }
+
+        return false;
+    }
+
+public:
+    //
+    // The board is checked against the Units, not by check_input(): a jigsaw
+    // puzzle may have a number twice in a box.
+    //
+    template <size_t nSearchMode = kSearchMode>
+    bool solve(Board & board) {
+        if (nSearchMode > SearchMode::OneAnswer) {
+            this->answers_.clear();
+        }
+
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
+
+        basic_solver_t::last_check = (size_t)this->units_.check_board(board);
+        if (basic_solver_t::last_check != BoardCheck::BoardValid)
+            return false;
+
+        this->init_state();
+        this->board_ = board;
+        size_t empties = 0;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            unsigned char val = board.cells[pos];
+            if (val != '.') {
+                this->fill_num(pos, val - '1');
+            }
+            else {
+                empties++;
+            }
+        }
+        this->empties_ = empties;
+
+        bool success = this->template search<nSearchMode>(0);
+        if (success && nSearchMode == SearchMode::OneAnswer)
+            board = this->board_;
+        return success;
+    }
+
+    // The number of the answers, 2 means more than one.
+    size_t count_solutions(const Board & board) {
+        Board puzzle = board;
+        this->template solve<SearchMode::MoreThanOneAnswer>(puzzle);
+        return this->answers_.size();
+    }
+
+    void display_result(Board & board, double elapsed_time,
+                        bool print_answer = true,
+                        bool print_all_answers = true) {
+        basic_solver_t::template display_result<kSearchMode>(board, elapsed_time, print_answer, print_all_answers);
+    }
+};
+
+} // namespace units
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_SOLVER_UNITS_H
@@ -17,6 +17,7 @@
 #include <cstring>      // For std::memset(), std::memcpy()
 #include <vector>
 #include <bitset>
+#include <type_traits>
 #include <array>        // For std::array<T, Size>
 
 #if defined(_MSC_VER)
@@ -57,12 +58,25 @@ namespace v1 {
 
 static const size_t kSearchMode = V1_SEARCH_MODE;
 
-template <typename SudokuTy>
+//
+// The switches of the solver, the defaults come from the macros above:
+//   kUseStdBitset:     std::bitset based bitboards instead of SmallBitSet.
+//
+template <bool UseStdBitset>
+struct SolverPolicy {
+    static const bool kUseStdBitset = UseStdBitset;
+};
+
+typedef SolverPolicy<(V1_USE_STD_BITSET != 0)> DefaultPolicy;
+
+template <typename SudokuTy, typename PolicyTy = DefaultPolicy, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, PolicyTy, StatsTy> solver_type;
+    typedef StatsTy                             stats_t;
+    typedef PolicyTy                            policy_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -173,23 +187,22 @@ private:
 
 #pragma pack(pop)
 
-#if V1_USE_STD_BITSET
-    typedef std::bitset<Numbers>    bitset_type;
-
-    alignas(16) SmallBitMatrix2<BoardSize, Numbers>         cell_nums_;     // [row * Cols + col][num]
+    template <size_t Rows_, size_t Cols_>
+    struct BitSet2D {
+        typedef typename std::conditional<PolicyTy::kUseStdBitset,
+                                          SmallBitMatrix2<Rows_, Cols_>,
+                                          SmallBitSet2D<Rows_, Cols_>>::type type;
+    };
 
-    alignas(16) SmallBitMatrix2<Numbers * Rows,  Cols>      row_nums_;      // [num * Rows + row][col]
-    alignas(16) SmallBitMatrix2<Numbers * Cols,  Rows>      col_nums_;      // [num * Cols + col][row]
-    alignas(16) SmallBitMatrix2<Numbers * Boxes, BoxSize>   box_nums_;      // [num * Boxes + box][cell]
-#else
-    typedef SmallBitSet<Numbers>    bitset_type;
+    typedef typename std::conditional<PolicyTy::kUseStdBitset,
+                                      std::bitset<Numbers>,
+                                      SmallBitSet<Numbers>>::type bitset_type;
 
-    alignas(16) SmallBitSet2D<BoardSize, Numbers>           cell_nums_;     // [row * Cols + col][num]
+    alignas(16) typename BitSet2D<BoardSize, Numbers>::type          cell_nums_;     // [row * Cols + col][num]
 
-    alignas(16) SmallBitSet2D<Numbers * Rows,  Cols>        row_nums_;      // [num * Rows + row][col]
-    alignas(16) SmallBitSet2D<Numbers * Cols,  Rows>        col_nums_;      // [num * Cols + col][row]
-    alignas(16) SmallBitSet2D<Numbers * Boxes, BoxSize>     box_nums_;      // [num * Boxes + box][cell]
-#endif
+    alignas(16) typename BitSet2D<Numbers * Rows,  Cols>::type       row_nums_;      // [num * Rows + row][col]
+    alignas(16) typename BitSet2D<Numbers * Cols,  Rows>::type       col_nums_;      // [num * Cols + col][row]
+    alignas(16) typename BitSet2D<Numbers * Boxes, BoxSize>::type    box_nums_;      // [num * Boxes + box][cell]
 
 #if defined(__SSE4_1__)
     alignas(16) literal_info_t literal_info_[TotalLiterals];
@@ -200,11 +213,16 @@ private:
 
     std::vector<EffectList>     effect_list_;
 
+    SearchPoller                poller_;
+
 public:
     Solver() {
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
 private:
     void init_board(Board & board) {
         init_literal_info();
@@ -215,6 +233,11 @@ private:
         this->col_nums_.set();
         this->box_nums_.set();
 
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
         if (kSearchMode > SEARCH_MODE_ONE_ANSWER) {
             this->answers_.clear();
         }
@@ -1426,10 +1449,17 @@ public:
         int min_literal_id = get_min_literal(min_literal_cnt);
         assert(min_literal_id < TotalLiterals);
         if (min_literal_cnt > 0) {
-            if (min_literal_cnt == 1)
-                basic_solver_t::num_unique_candidate++;
-            else
-                basic_solver_t::num_guesses++;
+            if (min_literal_cnt == 1) {
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
+            }
+            else {
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
+                // Only the guesses poll the control, the singles don't branch.
+                if (this->poller_.should_stop_at_guess())
+                    return false;
+            }
 
             bitset_type save_bits;
             size_t pos, row, col, box, cell, num;
@@ -1653,13 +1683,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_);
         return success;
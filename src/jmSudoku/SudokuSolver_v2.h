@@ -57,12 +57,13 @@ namespace v2 {
 
 static const size_t kSearchMode = V2_SEARCH_MODE;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -197,11 +198,16 @@ private:
     alignas(16) uint8_t literal_enable_[TotalLiterals];
 #endif
 
+    SearchPoller    poller_;
+
 public:
     Solver() {
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
 private:
     void init_board(Board & board) {
         init_literal_info();
@@ -213,6 +219,11 @@ private:
         this->col_nums_.set();
         this->box_nums_.set();
 
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
         if (kSearchMode > SEARCH_MODE_ONE_ANSWER) {
             this->answers_.clear();
         }
@@ -1434,10 +1445,17 @@ public:
         int min_literal_id = get_min_literal(min_literal_cnt);
         assert(min_literal_id < TotalLiterals);
         if (min_literal_cnt > 0) {
-            if (min_literal_cnt == 1)
-                basic_solver_t::num_unique_candidate++;
-            else
-                basic_solver_t::num_guesses++;
+            if (min_literal_cnt == 1) {
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
+            }
+            else {
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
+                // Only the guesses poll the control, the singles don't branch.
+                if (this->poller_.should_stop_at_guess())
+                    return false;
+            }
 
             bitset_type save_bits;
             BitMask save_effect_cells;
@@ -1670,13 +1688,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_);
         return success;
@@ -18,6 +18,7 @@
 #include <vector>
 #include <bitset>
 #include <array>        // For std::array<T, Size>
+#include <type_traits>  // For std::conditional<>
 
 #if defined(_MSC_VER)
 #include <emmintrin.h>      // For SSE 2
@@ -57,6 +58,17 @@
 #define V3_ENABLE_OLD_ALGORITHM     0
 #define V3_USE_SMID_COPY_BOARD      1
 
+#define V3_USE_SIMD_INIT_BOARD      1
+
+#define V3_LAZY_LITERAL_SELECT      1
+
+#define V3_COMPACT_RECOVER_STATE    0
+
+#define V3_BACKTRACK_UNDO_LOG       0
+#define V3_BACKTRACK_SNAPSHOT       1
+
+#define V3_BACKTRACK_MODE           V3_BACKTRACK_UNDO_LOG
+
 #define V3_RECOVER_STATE_DISABL_CHANGED     1
 
 namespace jmSudoku {
@@ -64,6 +76,19 @@ namespace v3 {
 
 static const size_t kSearchMode = V3_SEARCH_MODE;
 
+//
+// How a level of the search takes back its candidate:
+//   UndoLog:  the level saves the parts of the state that the candidate
+//             changes into its RecoverState and restores only them,
+//   Snapshot: the level copies the whole bitboard state and the counts once,
+//             and copies them back after every candidate.
+//
+enum BacktrackMode {
+    UndoLog = V3_BACKTRACK_UNDO_LOG,
+    Snapshot = V3_BACKTRACK_SNAPSHOT,
+    BacktrackModeLast
+};
+
 #if 0
 static const NeighborBoxes<3, 3> neighbor_boxes[9] = {
     // Box # 0
@@ -87,12 +112,51 @@ static const NeighborBoxes<3, 3> neighbor_boxes[9] = {
 };
 #endif
 
+//
+// The switches of the solver, the defaults come from the macros above, so
+// that the combinations can be built and compared in one binary:
+//   kSaveCountSize:    keep the size of every literal in count_.sizes,
+//   kSimdCopyBoard:    save and restore the bitboards with 16x16 vectors,
+//   kRecoverAllBoxes:  restore all the neighbor boxes, not only the changed
+//                      ones (the scalar copy needs it),
+//   kSimdInitBoard:    build the 9x9 state in bulk in init_board(),
+//   kLazySelect:       the default of set_lazy_select(),
+//   kCompactState:     the compact RecoverState of every level of the search,
+//   kBacktrack:        the BacktrackMode of the search.
+//
+template <bool SaveCountSize, bool SimdCopyBoard, bool RecoverAllBoxes,
+          bool SimdInitBoard, bool LazySelect, bool CompactState, size_t Backtrack>
+struct SolverPolicy {
+    static const bool kSaveCountSize = SaveCountSize;
+    static const bool kSimdCopyBoard = SimdCopyBoard;
+    static const bool kRecoverAllBoxes = RecoverAllBoxes;
+    static const bool kSimdInitBoard = SimdInitBoard;
+    static const bool kLazySelect = LazySelect;
+    static const bool kCompactState = CompactState;
+    static const size_t kBacktrack = Backtrack;
+};
+
+typedef SolverPolicy<(V3_SAVE_COUNT_SIZE != 0), (V3_USE_SMID_COPY_BOARD != 0),
+                     (V3_RECOVER_STATE_DISABL_CHANGED != 0), (V3_USE_SIMD_INIT_BOARD != 0),
+                     (V3_LAZY_LITERAL_SELECT != 0), (V3_COMPACT_RECOVER_STATE != 0),
+                     V3_BACKTRACK_MODE>
+                     DefaultPolicy;
+
+template <typename SudokuTy>
+class Session;
+
 template <typename SudokuTy>
-class Solver : public BasicSolver<SudokuTy> {
+class MinimalChecker;
+
+// Aligned as a whole: the alignas(32) of its packed members doesn't hold.
+template <typename SudokuTy, typename PolicyTy = DefaultPolicy, typename StatsTy = BasicStats>
+class alignas(32) Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, PolicyTy, StatsTy> solver_type;
+    typedef StatsTy                             stats_t;
+    typedef PolicyTy                            policy_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -102,6 +166,9 @@ public:
     typedef typename sudoku_t::BitMask          BitMask;
     typedef typename sudoku_t::BitMaskTable     BitMaskTable;
 
+    static_assert(PolicyTy::kSimdCopyBoard || PolicyTy::kRecoverAllBoxes,
+                  "The scalar copy of the board doesn't keep the changed boxes.");
+
     static const size_t kAlignment = sudoku_t::kAlignment;
     static const size_t BoxCellsX = sudoku_t::BoxCellsX;      // 3
     static const size_t BoxCellsY = sudoku_t::BoxCellsY;      // 3
@@ -180,6 +247,9 @@ public:
     static const uint32_t kLiteralCntThreshold2 = 0;
 
 private:
+    friend class Session<SudokuTy>;
+    friend class MinimalChecker<SudokuTy>;
+
 #if (V3_LITERAL_ORDER_MODE == 0)
     enum LiteralType {
         CellNums,
@@ -225,12 +295,74 @@ private:
         alignas(32) PackedBitSet3D<Numbers, Boxes16, BoxSize16>   box_num_cells;    // [num][box][cell]
     };
 
-    struct RecoverState {
-        static const size_t kBoxesTotal = neighbor_boxes_t::kBoxesCount;
-        alignas(32) PackedBitSet2D<BoxSize16, Numbers16>          boxes[kBoxesTotal];   // [cell][num]
-        alignas(32) PackedBitSet2D<Rows16, Cols16>                row_cols;             // [row][col]
-        alignas(32) PackedBitSet2D<Cols16, Rows16>                col_rows;             // [col][row]
-        alignas(32) PackedBitSet2D<Boxes16, BoxSize16>            box_cells;            // [box][cell]
+    struct Count {
+        struct Sizes {
+            alignas(32) uint16_t box_cells[Boxes16 * BoxSize16];
+            alignas(32) uint16_t row_nums[Numbers16 * Rows16];
+            alignas(32) uint16_t col_nums[Numbers16 * Cols16];
+            alignas(32) uint16_t box_nums[Numbers16 * Boxes16];
+        } sizes;
+
+        // A flag word per literal, it's OR-ed to the popcounts as it is.
+        struct PaddedEnabled {
+            alignas(32) uint16_t box_cells[Boxes16 * BoxSize16];
+            alignas(32) uint16_t row_nums[Numbers16 * Rows16];
+            alignas(32) uint16_t col_nums[Numbers16 * Cols16];
+            alignas(32) uint16_t box_nums[Numbers16 * Boxes16];
+
+            static void enable(uint16_t * flags, size_t literal) {
+                flags[literal] = kEnableLiteral16;
+            }
+
+            static void disable(uint16_t * flags, size_t literal) {
+                flags[literal] = kDisableLiteral16;
+            }
+
+            static bool is_enabled(const uint16_t * flags, size_t literal) {
+                return (flags[literal] == kEnableLiteral16);
+            }
+
+            static void load_mask(BitVec16x16 & mask, const uint16_t * flags, size_t group) {
+                mask.loadAligned(&flags[group * 16]);
+            }
+        };
+
+        //
+        // The compact enabled flags (kCompactState), 1/16 of the padded ones:
+        // a bit per literal, set if it's disabled, the mask is widened from
+        // the bits of the group when it's OR-ed to the popcounts.
+        //
+        struct CompactEnabled {
+            alignas(32) uint16_t box_cells[Boxes16];
+            alignas(32) uint16_t row_nums[Numbers16];
+            alignas(32) uint16_t col_nums[Numbers16];
+            alignas(32) uint16_t box_nums[Numbers16];
+
+            static void enable(uint16_t * flags, size_t literal) {
+                flags[literal / 16] &= (uint16_t)~(1U << (literal % 16));
+            }
+
+            static void disable(uint16_t * flags, size_t literal) {
+                flags[literal / 16] |= (uint16_t)(1U << (literal % 16));
+            }
+
+            static bool is_enabled(const uint16_t * flags, size_t literal) {
+                return (((flags[literal / 16] >> (literal % 16)) & 1U) == 0);
+            }
+
+            static void load_mask(BitVec16x16 & mask, const uint16_t * flags, size_t group) {
+                mask.fill_bits16(flags[group]);
+            }
+        };
+
+        // The literals of a group are 16 flags, a 16x16 vector or a word.
+        static_assert(((BoxSize16 == 16) && (Rows16 == 16) && (Cols16 == 16) && (Boxes16 == 16)),
+                      "The enabled flags need 16 literals per group.");
+
+        typedef typename std::conditional<PolicyTy::kCompactState,
+                                          CompactEnabled,
+                                          PaddedEnabled>::type Enabled;
+        Enabled enabled;
 
         struct Changed {
             alignas(32) uint16_t box_cells[Boxes16];
@@ -252,22 +384,29 @@ private:
             alignas(32) uint16_t col_nums[Numbers16];
             alignas(32) uint16_t box_nums[Numbers16];
         } indexs;
+
+        struct Total {
+            // In fact, the valid literal is from 0 to 3 only.
+            alignas(32) uint16_t min_literal_size[16];
+            alignas(32) uint16_t min_literal_index[16];
+        } total;
+
+        uint32_t min_literal_size;
+        uint32_t min_literal_index;
+
+        // The nums of which the row/col/box counts are stale (lazy selection),
+        // kept after the aligned arrays, the Count is packed.
+        uint32_t changed_nums;
     };
 
-    struct Count {
-        struct Sizes {
-            alignas(32) uint16_t box_cells[Boxes16 * BoxSize16];
-            alignas(32) uint16_t row_nums[Numbers16 * Rows16];
-            alignas(32) uint16_t col_nums[Numbers16 * Cols16];
-            alignas(32) uint16_t box_nums[Numbers16 * Boxes16];
-        } sizes;
+    typedef typename Count::Enabled enabled_t;
 
-        struct Enabled {
-            alignas(32) uint16_t box_cells[Boxes16 * BoxSize16];
-            alignas(32) uint16_t row_nums[Numbers16 * Rows16];
-            alignas(32) uint16_t col_nums[Numbers16 * Cols16];
-            alignas(32) uint16_t box_nums[Numbers16 * Boxes16];
-        } enabled;
+    struct PaddedRecoverState {
+        static const size_t kBoxesTotal = neighbor_boxes_t::kBoxesCount;
+        alignas(32) PackedBitSet2D<BoxSize16, Numbers16>          boxes[kBoxesTotal];   // [cell][num]
+        alignas(32) PackedBitSet2D<Rows16, Cols16>                row_cols;             // [row][col]
+        alignas(32) PackedBitSet2D<Cols16, Rows16>                col_rows;             // [col][row]
+        alignas(32) PackedBitSet2D<Boxes16, BoxSize16>            box_cells;            // [box][cell]
 
         struct Changed {
             alignas(32) uint16_t box_cells[Boxes16];
@@ -290,16 +429,143 @@ private:
             alignas(32) uint16_t box_nums[Numbers16];
         } indexs;
 
-        struct Total {
-            // In fact, the valid literal is from 0 to 3 only.
-            alignas(32) uint16_t min_literal_size[16];
-            alignas(32) uint16_t min_literal_index[16];
-        } total;
+        uint32_t changed_nums;
 
-        uint32_t min_literal_size;
-        uint32_t min_literal_index;
+        void save_num_counts(size_t num, const Count & count) {
+            this->counts.row_nums[num] = count.counts.row_nums[num];
+            this->counts.col_nums[num] = count.counts.col_nums[num];
+            this->counts.box_nums[num] = count.counts.box_nums[num];
+
+            this->indexs.row_nums[num] = count.indexs.row_nums[num];
+            this->indexs.col_nums[num] = count.indexs.col_nums[num];
+            this->indexs.box_nums[num] = count.indexs.box_nums[num];
+        }
+
+        void restore_num_counts(size_t num, Count & count) const {
+            count.counts.row_nums[num] = this->counts.row_nums[num];
+            count.counts.col_nums[num] = this->counts.col_nums[num];
+            count.counts.box_nums[num] = this->counts.box_nums[num];
+
+            count.indexs.row_nums[num] = this->indexs.row_nums[num];
+            count.indexs.col_nums[num] = this->indexs.col_nums[num];
+            count.indexs.box_nums[num] = this->indexs.box_nums[num];
+        }
+
+        // i: the slot of the box in neighbor_boxes[], box_idx: the box.
+        void save_box_counts(size_t /* i */, size_t box_idx, const Count & count) {
+            this->counts.box_cells[box_idx] = count.counts.box_cells[box_idx];
+            this->indexs.box_cells[box_idx] = count.indexs.box_cells[box_idx];
+        }
+
+        void restore_box_counts(size_t /* i */, size_t box_idx, Count & count) const {
+            count.counts.box_cells[box_idx] = this->counts.box_cells[box_idx];
+            count.indexs.box_cells[box_idx] = this->indexs.box_cells[box_idx];
+        }
+
+        bool is_box_changed(size_t /* i */, size_t box_idx) const {
+            return (this->changed.box_cells[box_idx] != 0);
+        }
+
+        void set_box_changed(size_t /* i */, size_t box_idx, bool changed) {
+            this->changed.box_cells[box_idx] = changed;
+        }
+    };
+
+    //
+    // The compact RecoverState (kCompactState), about 60% of the padded one:
+    // the bitboards keep their 16x16 vectors, but the counts and the indexs
+    // have no padding num, the neighbor boxes are kept by their slot in
+    // neighbor_boxes[box], and the changed flags of the boxes are bits.
+    //
+    struct CompactRecoverState {
+        static const size_t kBoxesTotal = neighbor_boxes_t::kBoxesCount;
+        alignas(32) PackedBitSet2D<BoxSize16, Numbers16>          boxes[kBoxesTotal];   // [cell][num]
+        alignas(32) PackedBitSet2D<Rows16, Cols16>                row_cols;             // [row][col]
+        alignas(32) PackedBitSet2D<Cols16, Rows16>                col_rows;             // [col][row]
+        alignas(32) PackedBitSet2D<Boxes16, BoxSize16>            box_cells;            // [box][cell]
+
+        struct Counts {
+            uint16_t box_cells[kBoxesTotal];
+            uint16_t row_nums[Numbers];
+            uint16_t col_nums[Numbers];
+            uint16_t box_nums[Numbers];
+        } counts;
+
+        struct Indexs {
+            uint16_t box_cells[kBoxesTotal];
+            uint16_t row_nums[Numbers];
+            uint16_t col_nums[Numbers];
+            uint16_t box_nums[Numbers];
+        } indexs;
+
+        uint32_t changed_nums;
+        uint32_t changed_boxes;
+
+        void save_num_counts(size_t num, const Count & count) {
+            this->counts.row_nums[num] = count.counts.row_nums[num];
+            this->counts.col_nums[num] = count.counts.col_nums[num];
+            this->counts.box_nums[num] = count.counts.box_nums[num];
+
+            this->indexs.row_nums[num] = count.indexs.row_nums[num];
+            this->indexs.col_nums[num] = count.indexs.col_nums[num];
+            this->indexs.box_nums[num] = count.indexs.box_nums[num];
+        }
+
+        void restore_num_counts(size_t num, Count & count) const {
+            count.counts.row_nums[num] = this->counts.row_nums[num];
+            count.counts.col_nums[num] = this->counts.col_nums[num];
+            count.counts.box_nums[num] = this->counts.box_nums[num];
+
+            count.indexs.row_nums[num] = this->indexs.row_nums[num];
+            count.indexs.col_nums[num] = this->indexs.col_nums[num];
+            count.indexs.box_nums[num] = this->indexs.box_nums[num];
+        }
+
+        void save_box_counts(size_t i, size_t box_idx, const Count & count) {
+            this->counts.box_cells[i] = count.counts.box_cells[box_idx];
+            this->indexs.box_cells[i] = count.indexs.box_cells[box_idx];
+        }
+
+        void restore_box_counts(size_t i, size_t box_idx, Count & count) const {
+            count.counts.box_cells[box_idx] = this->counts.box_cells[i];
+            count.indexs.box_cells[box_idx] = this->indexs.box_cells[i];
+        }
+
+        bool is_box_changed(size_t i, size_t /* box_idx */) const {
+            return (((this->changed_boxes >> i) & 1U) != 0);
+        }
+
+        void set_box_changed(size_t i, size_t /* box_idx */, bool changed) {
+            this->changed_boxes = (this->changed_boxes & ~(1U << i)) | ((uint32_t)changed << i);
+        }
+    };
+
+    typedef typename std::conditional<PolicyTy::kCompactState,
+                                      CompactRecoverState,
+                                      PaddedRecoverState>::type RecoverState;
+
+    //
+    // The snapshot of a level (kBacktrack = Snapshot): the whole State, and the
+    // enabled flags, the counts and the indexs of the Count. The sizes are only
+    // a cache of the popcounts, the RecoverState doesn't keep them either.
+    //
+    struct SnapshotState {
+        State                   state;
+        enabled_t               enabled;
+        typename Count::Counts  counts;
+        typename Count::Indexs  indexs;
+        uint32_t                changed_nums;
+
+        // The count of every neighbor box is taken again after a fill.
+        bool is_box_changed(size_t /* i */, size_t /* box_idx */) const {
+            return true;
+        }
     };
 
+    typedef typename std::conditional<PolicyTy::kBacktrack == Snapshot,
+                                      SnapshotState,
+                                      RecoverState>::type BacktrackState;
+
 #pragma pack(pop)
 
 #if V3_ENABLE_OLD_ALGORITHM
@@ -316,6 +582,10 @@ private:
     State   state_;
     Count   count_;
 
+    // Behind the packed members, so that their offsets don't change.
+    SearchPoller    poller_;
+    bool            lazy_select_;
+
 #if V3_ENABLE_OLD_ALGORITHM
 #if defined(__SSE4_1__)
     alignas(16) literal_info_t literal_info_[TotalLiterals];
@@ -337,7 +607,7 @@ private:
     static PackedBitSet3D<BoardSize, Boxes16, BoxSize16>  box_num_neighbors_mask;
 
 public:
-    Solver() {
+    Solver() : lazy_select_(PolicyTy::kLazySelect) {
         if (!mask_is_inited) {
             init_mask();
             mask_is_inited = true;
@@ -345,6 +615,20 @@ public:
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
+    // The guesses of the last search, counted whatever the StatsTy is.
+    size_t guesses() const { return this->poller_.guesses(); }
+
+    //
+    // Lazy literal selection: when a cell is left with one candidate (or none),
+    // it's picked without counting the row/col/box literals, the counts of the
+    // changed nums are marked in count_.changed_nums and updated later.
+    //
+    bool lazy_select() const { return this->lazy_select_; }
+    void set_lazy_select(bool lazy_select) { this->lazy_select_ = lazy_select; }
+
 private:
     static size_t make_neighbor_cells_masklist(size_t fill_pos,
                                                size_t row, size_t col) {
@@ -532,6 +816,148 @@ private:
     }
 
     void init_board(Board & board) {
+        if (PolicyTy::kSimdInitBoard && BoardSize == 81)
+            this->init_board_simd(board);
+        else
+            this->init_board_scalar(board);
+    }
+
+public:
+    //
+    // Builds the same state as init_board_scalar(), in bulk (9x9 only):
+    //   - the one-hot masks of the givens come from two pshufb,
+    //   - the candidates of an empty cell are the numbers that its row,
+    //     column and box don't have,
+    //   - the [num] bitboards are the AND of the neighbor masks of the givens
+    //     of the num (the masks of updateNeighborCellsEffect()), without the
+    //     filled cells.
+    //
+    void init_board_simd(Board & board) {
+        init_literal_info();
+
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
+        if (kSearchMode > SEARCH_MODE_ONE_ANSWER) {
+            this->answers_.clear();
+        }
+
+        alignas(16) uint16_t masks[BoardSize + 7];
+        uint64_t givens[2];
+        {
+            const __m128i one_char  = _mm_set1_epi8('1');
+            const __m128i dot_char  = _mm_set1_epi8('.');
+            const __m128i max_index = _mm_set1_epi8(15);
+            const __m128i lo_table  = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i hi_table  = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0);
+
+            // 81 cells: 5 vectors and the last one overlapped at 65.
+            uint64_t empty_bits[6];
+            for (size_t i = 0; i < 6; i++) {
+                size_t offset = (i < 5) ? (i * 16) : (BoardSize - 16);
+                __m128i cells = _mm_loadu_si128((const __m128i *)(board.cells + offset));
+                empty_bits[i] = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(cells, dot_char));
+                __m128i index = _mm_min_epu8(_mm_sub_epi8(cells, one_char), max_index);
+                __m128i lo = _mm_shuffle_epi8(lo_table, index);
+                __m128i hi = _mm_shuffle_epi8(hi_table, index);
+                _mm_storeu_si128((__m128i *)(masks + offset), _mm_unpacklo_epi8(lo, hi));
+                _mm_storeu_si128((__m128i *)(masks + offset + 8), _mm_unpackhi_epi8(lo, hi));
+            }
+            uint64_t empties_lo = empty_bits[0] | (empty_bits[1] << 16) | (empty_bits[2] << 32) | (empty_bits[3] << 48);
+            uint64_t empties_hi = empty_bits[4] | ((empty_bits[5] >> 15) << 16);
+            givens[0] = ~empties_lo;
+            givens[1] = ~empties_hi & 0x1FFFFull;
+        }
+        this->empties_ = BoardSize - BitUtils::popcnt64(givens[0]) - BitUtils::popcnt64(givens[1]);
+
+        uint32_t rows[Rows16] = { 0 };
+        uint32_t cols[Cols16] = { 0 };
+        uint32_t boxes[Boxes16] = { 0 };
+        alignas(32) uint16_t row_givens[Rows16] = { 0 };
+        alignas(32) uint16_t col_givens[Cols16] = { 0 };
+        alignas(32) uint16_t box_givens[Boxes16] = { 0 };
+        uint8_t num_givens[Numbers][BoardSize];
+        size_t num_counts[Numbers] = { 0 };
+
+        for (size_t n = 0; n < 2; n++) {
+            uint64_t bits = givens[n];
+            while (bits != 0) {
+                size_t pos = n * 64 + BitUtils::bsf64(bits);
+                bits &= bits - 1;
+                const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                size_t row = cellInfo.row;
+                size_t col = cellInfo.col;
+                size_t box = cellInfo.box;
+                size_t cell = cellInfo.cell;
+                uint32_t num_bit = masks[pos];
+                size_t num = BitUtils::bsf32(num_bit);
+
+                rows[row] |= num_bit;
+                cols[col] |= num_bit;
+                boxes[box] |= num_bit;
+                row_givens[row] |= uint16_t(1U << col);
+                col_givens[col] |= uint16_t(1U << row);
+                box_givens[box] |= uint16_t(1U << cell);
+                num_givens[num][num_counts[num]++] = (uint8_t)pos;
+
+                disable_cell_literal(box * BoxSize16 + cell);
+                disable_row_literal(num * Rows16 + row);
+                disable_col_literal(num * Cols16 + col);
+                disable_box_literal(num * Boxes16 + box);
+            }
+        }
+
+        // The padding cells keep all the numbers.
+        this->state_.box_cell_nums.fill(kAllNumberBits);
+        uint16_t * box_cells = (uint16_t *)&this->state_.box_cell_nums;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+            uint32_t cands = ~(rows[cellInfo.row] | cols[cellInfo.col] | boxes[cellInfo.box]) &
+                             (uint32_t)kAllNumberBits;
+            box_cells[cellInfo.box * BoxSize16 + cellInfo.cell] = (masks[pos] == 0) ? (uint16_t)cands : 0;
+        }
+
+        // The empty cells, the padding rows, cols and boxes keep all the bits.
+        BitVec16x16 row_empties, col_empties, box_empties;
+        BitVec16x16 all_bits;
+        row_empties.loadAligned(row_givens);
+        all_bits.fill_u16((uint16_t)kAllColBits);
+        row_empties._and_not(all_bits);
+        col_empties.loadAligned(col_givens);
+        all_bits.fill_u16((uint16_t)kAllRowBits);
+        col_empties._and_not(all_bits);
+        box_empties.loadAligned(box_givens);
+        all_bits.fill_u16((uint16_t)kAllBoxCellBits);
+        box_empties._and_not(all_bits);
+
+        for (size_t num = 0; num < Numbers; num++) {
+            BitVec16x16 row_bits = row_empties;
+            BitVec16x16 col_bits = col_empties;
+            BitVec16x16 box_bits = box_empties;
+            for (size_t i = 0; i < num_counts[num]; i++) {
+                size_t pos = num_givens[num][i];
+                BitVec16x16 mask;
+                mask.loadAligned(&row_neighbors_mask[pos]);
+                row_bits &= mask;
+                mask.loadAligned(&col_neighbors_mask[pos]);
+                col_bits &= mask;
+                mask.loadAligned(&box_num_neighbors_mask[pos]);
+                box_bits &= mask;
+            }
+            row_bits.saveAligned(&this->state_.row_num_cols[num]);
+            col_bits.saveAligned(&this->state_.col_num_rows[num]);
+            box_bits.saveAligned(&this->state_.box_num_cells[num]);
+        }
+
+        uint32_t min_literal_index;
+        uint32_t min_literal_size = this->count_all_literal_size(min_literal_index);
+        this->count_.min_literal_size = min_literal_size;
+        this->count_.min_literal_index = min_literal_index;
+    }
+
+    void init_board_scalar(Board & board) {
 #if V3_ENABLE_OLD_ALGORITHM
         old_init_literal_info();
 #endif
@@ -551,6 +977,8 @@ private:
         this->state_.col_num_rows.fill(kAllRowBits);
         this->state_.box_num_cells.fill(kAllBoxCellBits);
 
+        this->poller_.reset();
+
         basic_solver_t::num_guesses = 0;
         basic_solver_t::num_unique_candidate = 0;
         basic_solver_t::num_failed_return = 0;
@@ -598,6 +1026,140 @@ private:
 #endif
     }
 
+    // Builds the state by both paths, true if they are bit-identical.
+    bool check_init_board(Board & board) {
+        this->init_board_scalar(board);
+        State state = this->state_;
+        Count count = this->count_;
+        size_t empties = this->empties_;
+
+        this->init_board_simd(board);
+        return ((std::memcmp((const void *)&state, (const void *)&this->state_, sizeof(State)) == 0) &&
+                (std::memcmp((const void *)&count, (const void *)&this->count_, sizeof(Count)) == 0) &&
+                (empties == this->empties_));
+    }
+
+    typedef State           state_type;
+    typedef Count           count_type;
+    typedef RecoverState    recover_state_type;
+    typedef BacktrackState  backtrack_state_type;
+
+    const state_type & state() const { return this->state_; }
+    const count_type & count() const { return this->count_; }
+
+    //
+    // Builds the state and the literal counts that the search starts from,
+    // with every literal kind counted (the lazy selection is off), the sizes
+    // of the literals are in count().sizes if the policy saves them.
+    // False if the givens break the rules.
+    //
+    bool count_literals(const Board & board) {
+        Board temp = board;
+        if (!this->check_input(temp))
+            return false;
+        bool lazy_select = this->lazy_select_;
+        this->lazy_select_ = false;
+        this->init_board(temp);
+        this->lazy_select_ = lazy_select;
+        return true;
+    }
+
+    //
+    // The row/col/box views of the State, derived from box_cell_nums alone.
+    // The search keeps the four views in sync by the masks of every fill,
+    // these rebuild the other three on demand with the BitUtils kernels:
+    //   - box_num_cells[num][box]: bit num of the 16 cells of the box,
+    //     bit_column16() for one num, transpose16x16() for all of them,
+    //   - row_num_cols[num]: the cells of the boxes of a band are pdep()ed
+    //     to the 3 rows of the band, as one 64-bit word,
+    //   - col_num_rows[num]: transpose16x16() of row_num_cols[num].
+    // The padding rows, cols and boxes keep all the bits, as init_board().
+    //
+    static void derive_num_views(const State & src, State & dest, size_t num) {
+        static_assert((BoxCellsY * 16) <= 64, "The rows of a band must fit in 64 bits.");
+        const uint16_t * box_cell_nums = (const uint16_t *)&src.box_cell_nums;
+        uint16_t box_cells[Boxes16];
+        for (size_t box = 0; box < Boxes; box++) {
+            box_cells[box] = (uint16_t)(BitUtils::bit_column16(&box_cell_nums[box * BoxSize16], num) &
+                                        kAllBoxCellBits);
+        }
+        build_num_views(box_cells, dest, num);
+    }
+
+    static void derive_views(const State & src, State & dest) {
+        const uint16_t * box_cell_nums = (const uint16_t *)&src.box_cell_nums;
+        uint16_t num_box_cells[Numbers16][Boxes16];
+        for (size_t box = 0; box < Boxes; box++) {
+            uint16_t num_cells[Numbers16];
+            BitUtils::transpose16x16(&box_cell_nums[box * BoxSize16], num_cells);
+            for (size_t num = 0; num < Numbers; num++) {
+                num_box_cells[num][box] = (uint16_t)(num_cells[num] & kAllBoxCellBits);
+            }
+        }
+        if (&dest != &src) {
+            dest.box_cell_nums = src.box_cell_nums;
+        }
+        for (size_t num = 0; num < Numbers; num++) {
+            build_num_views(num_box_cells[num], dest, num);
+        }
+    }
+
+    // The derived views, by both paths, are bit-identical to the state.
+    bool check_derived_views() const {
+        alignas(32) State state;
+        derive_views(this->state_, state);
+        if (std::memcmp((const void *)&state, (const void *)&this->state_, sizeof(State)) != 0)
+            return false;
+
+        std::memset((void *)&state, 0, sizeof(State));
+        state.box_cell_nums = this->state_.box_cell_nums;
+        for (size_t num = 0; num < Numbers; num++) {
+            derive_num_views(this->state_, state, num);
+        }
+        return (std::memcmp((const void *)&state, (const void *)&this->state_, sizeof(State)) == 0);
+    }
+
+private:
+    static void build_num_views(const uint16_t * box_cells, State & dest, size_t num) {
+        uint16_t * box_num_cells = (uint16_t *)&dest.box_num_cells[num];
+        uint16_t * row_cols = (uint16_t *)&dest.row_num_cols[num];
+        uint16_t * col_rows = (uint16_t *)&dest.col_num_rows[num];
+
+        for (size_t box = 0; box < Boxes; box++) {
+            box_num_cells[box] = box_cells[box];
+        }
+        for (size_t box = Boxes; box < Boxes16; box++) {
+            box_num_cells[box] = (uint16_t)kAllBoxCellBits;
+        }
+
+        for (size_t band = 0; band < BoxCountY; band++) {
+            uint64_t rows = 0;
+            for (size_t box_x = 0; box_x < BoxCountX; box_x++) {
+                uint64_t box_mask = 0;
+                for (size_t y = 0; y < BoxCellsY; y++) {
+                    box_mask |= (uint64_t)(((1U << BoxCellsX) - 1) << (box_x * BoxCellsX)) << (y * 16);
+                }
+                rows |= BitUtils::pdep64(box_cells[band * BoxCountX + box_x], box_mask);
+            }
+            for (size_t y = 0; y < BoxCellsY; y++) {
+                row_cols[band * BoxCellsY + y] = (uint16_t)(rows >> (y * 16));
+            }
+        }
+        for (size_t row = Rows; row < Rows16; row++) {
+            row_cols[row] = 0;
+        }
+
+        BitUtils::transpose16x16(row_cols, col_rows);
+
+        for (size_t row = Rows; row < Rows16; row++) {
+            row_cols[row] = (uint16_t)kAllColBits;
+        }
+        for (size_t col = Cols; col < Cols16; col++) {
+            col_rows[col] = (uint16_t)kAllRowBits;
+        }
+    }
+
+
 #if V3_ENABLE_OLD_ALGORITHM
     static const size_t kLiteralStep = sizeof(size_t) / sizeof(literal_info_t);
 
@@ -1843,21 +2405,8 @@ private:
     }
 
     void init_literal_enable() {
-        for (size_t i = 0; i < Boxes16 * BoxSize16; i++) {
-            this->count_.enabled.box_cells[i] = kEnableLiteral16;
-        }
-
-        for (size_t i = 0; i < Numbers16 * Rows16; i++) {
-            this->count_.enabled.row_nums[i] = kEnableLiteral16;
-        }
-
-        for (size_t i = 0; i < Numbers16 * Cols16; i++) {
-            this->count_.enabled.col_nums[i] = kEnableLiteral16;
-        }
-
-        for (size_t i = 0; i < Numbers16 * Boxes16; i++) {
-            this->count_.enabled.box_nums[i] = kEnableLiteral16;
-        }
+        // kEnableLiteral16 and the clear bits of the compact flags are zeros.
+        std::memset((void *)&this->count_.enabled, 0, sizeof(this->count_.enabled));
     }
 
     void init_literal_count() {
@@ -1876,6 +2425,8 @@ private:
         for (size_t i = 0; i < Numbers16; i++) {
             this->count_.counts.box_nums[i] = 255;
         }
+
+        this->count_.changed_nums = 0;
     }
 
     void init_literal_index() {
@@ -1905,36 +2456,36 @@ private:
 
     // enable_xxxx_literal()
     inline void enable_cell_literal(size_t cell_literal) {
-        this->count_.enabled.box_cells[cell_literal] = kEnableLiteral16;
+        enabled_t::enable(this->count_.enabled.box_cells, cell_literal);
     }
 
     inline void enable_row_literal(size_t row_literal) {
-        this->count_.enabled.row_nums[row_literal] = kEnableLiteral16;
+        enabled_t::enable(this->count_.enabled.row_nums, row_literal);
     }
 
     inline void enable_col_literal(size_t col_literal) {
-        this->count_.enabled.col_nums[col_literal] = kEnableLiteral16;
+        enabled_t::enable(this->count_.enabled.col_nums, col_literal);
     }
 
     inline void enable_box_literal(size_t box_literal) {
-        this->count_.enabled.box_nums[box_literal] = kEnableLiteral16;
+        enabled_t::enable(this->count_.enabled.box_nums, box_literal);
     }
 
     // disable_xxxx_literal()
     inline void disable_cell_literal(size_t cell_literal) {
-        this->count_.enabled.box_cells[cell_literal] = kDisableLiteral16;
+        enabled_t::disable(this->count_.enabled.box_cells, cell_literal);
     }
 
     inline void disable_row_literal(size_t row_literal) {
-        this->count_.enabled.row_nums[row_literal] = kDisableLiteral16;
+        enabled_t::disable(this->count_.enabled.row_nums, row_literal);
     }
 
     inline void disable_col_literal(size_t col_literal) {
-        this->count_.enabled.col_nums[col_literal] = kDisableLiteral16;
+        enabled_t::disable(this->count_.enabled.col_nums, col_literal);
     }
 
     inline void disable_box_literal(size_t box_literal) {
-        this->count_.enabled.box_nums[box_literal] = kDisableLiteral16;
+        enabled_t::disable(this->count_.enabled.box_nums, box_literal);
     }
 
     inline void doFillNum(size_t pos, size_t row, size_t col,
@@ -2024,13 +2575,8 @@ private:
         disable_col_literal(col_idx);
         disable_box_literal(box_idx);
 
-        recover_state.counts.row_nums[num] = this->count_.counts.row_nums[num];
-        recover_state.counts.col_nums[num] = this->count_.counts.col_nums[num];
-        recover_state.counts.box_nums[num] = this->count_.counts.box_nums[num];
-
-        recover_state.indexs.row_nums[num] = this->count_.indexs.row_nums[num];
-        recover_state.indexs.col_nums[num] = this->count_.indexs.col_nums[num];
-        recover_state.indexs.box_nums[num] = this->count_.indexs.box_nums[num];
+        recover_state.changed_nums = this->count_.changed_nums;
+        recover_state.save_num_counts(num, this->count_);
 
         size_t num_bits = cell_num_bits.to_ulong();
         // Exclude the current number, because it will be process later.
@@ -2048,13 +2594,7 @@ private:
             this->state_.col_num_rows[_num][col].reset(row);
             this->state_.box_num_cells[_num][box].reset(cell);
 
-            recover_state.counts.row_nums[_num] = this->count_.counts.row_nums[_num];
-            recover_state.counts.col_nums[_num] = this->count_.counts.col_nums[_num];
-            recover_state.counts.box_nums[_num] = this->count_.counts.box_nums[_num];
-
-            recover_state.indexs.row_nums[_num] = this->count_.indexs.row_nums[_num];
-            recover_state.indexs.col_nums[_num] = this->count_.indexs.col_nums[_num];
-            recover_state.indexs.box_nums[_num] = this->count_.indexs.box_nums[_num];
+            recover_state.save_num_counts(_num, this->count_);
         }
     }
 
@@ -2084,13 +2624,8 @@ private:
         enable_col_literal(col_idx);
         enable_box_literal(box_idx);
 
-        this->count_.counts.row_nums[num] = recover_state.counts.row_nums[num];
-        this->count_.counts.col_nums[num] = recover_state.counts.col_nums[num];
-        this->count_.counts.box_nums[num] = recover_state.counts.box_nums[num];
-
-        this->count_.indexs.row_nums[num] = recover_state.indexs.row_nums[num];
-        this->count_.indexs.col_nums[num] = recover_state.indexs.col_nums[num];
-        this->count_.indexs.box_nums[num] = recover_state.indexs.box_nums[num];
+        this->count_.changed_nums = recover_state.changed_nums;
+        recover_state.restore_num_counts(num, this->count_);
 
         size_t num_bits = save_num_bits.to_ulong();
         // Exclude the current number, because it has been processed.
@@ -2108,20 +2643,13 @@ private:
             this->state_.col_num_rows[_num][col].set(row);
             this->state_.box_num_cells[_num][box].set(cell);
 
-            this->count_.counts.row_nums[_num] = recover_state.counts.row_nums[_num];
-            this->count_.counts.col_nums[_num] = recover_state.counts.col_nums[_num];
-            this->count_.counts.box_nums[_num] = recover_state.counts.box_nums[_num];
-
-            this->count_.indexs.row_nums[_num] = recover_state.indexs.row_nums[_num];
-            this->count_.indexs.col_nums[_num] = recover_state.indexs.col_nums[_num];
-            this->count_.indexs.box_nums[_num] = recover_state.indexs.box_nums[_num];
+            recover_state.restore_num_counts(_num, this->count_);
         }
     }
 
-#if V3_USE_SMID_COPY_BOARD
 
-    inline void updateNeighborCellsEffect(RecoverState & recover_state,
-                                          size_t fill_pos, size_t box, size_t num) {
+    inline void updateNeighborCellsEffect_simd(RecoverState & recover_state,
+                                               size_t fill_pos, size_t box, size_t num) {
         static const bool hasChanged = true;
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
@@ -2131,60 +2659,60 @@ private:
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
 
-#if V3_RECOVER_STATE_DISABL_CHANGED
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
-            
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            box_cell_nums &= box_cell_neighbor_mask;
-            box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
-
-            recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-            recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
-#elif 1
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
+            if (PolicyTy::kRecoverAllBoxes) {
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
             
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            box_cell_nums &= box_cell_neighbor_mask;
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                box_cell_nums &= box_cell_neighbor_mask;
+                box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
 
-            box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
-
-            bool boxHasChanged = (box_idx == box) ||
-                                 !BitVec16x16::isMemEqual(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
-            recover_state.changed.box_cells[box_idx] = boxHasChanged;
-            if (boxHasChanged) {
-                recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-                recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
+                recover_state.save_box_counts(i, box_idx, this->count_);
             }
+            else {
+#if 1
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
+            
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                box_cell_nums &= box_cell_neighbor_mask;
+
+                box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+
+                bool boxHasChanged = (box_idx == box) ||
+                                     !BitVec16x16::isMemEqual(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
+                recover_state.set_box_changed(i, box_idx, boxHasChanged);
+                if (boxHasChanged) {
+                    recover_state.save_box_counts(i, box_idx, this->count_);
+                }
 #else
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums, new_box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            new_box_cell_nums = box_cell_nums;
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums, new_box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                new_box_cell_nums = box_cell_nums;
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
             
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            new_box_cell_nums &= box_cell_neighbor_mask;
-
-            bool boxHasChanged = (box_idx == box) || (new_box_cell_nums != box_cell_nums);
-            recover_state.changed.box_cells[box_idx] = boxHasChanged;
-            if (boxHasChanged) {
-                new_box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
-                recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-                recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
-            }
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                new_box_cell_nums &= box_cell_neighbor_mask;
+
+                bool boxHasChanged = (box_idx == box) || (new_box_cell_nums != box_cell_nums);
+                recover_state.set_box_changed(i, box_idx, boxHasChanged);
+                if (boxHasChanged) {
+                    new_box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+                    recover_state.save_box_counts(i, box_idx, this->count_);
+                }
 #endif
+            }
         }
         //recover_state.boxes[boxesCount] = this->state_.box_cell_nums[box];
         //this->state_.box_cell_nums[box] &= neighbors_mask[box];        
@@ -2238,20 +2766,19 @@ private:
         }
     }
 
-    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
-                                           size_t box, size_t num) {
+    inline void restoreNeighborCellsEffect_simd(const RecoverState & recover_state,
+                                                size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
-            if (V3_RECOVER_STATE_DISABL_CHANGED || recover_state.changed.box_cells[box_idx]) {
+            if (PolicyTy::kRecoverAllBoxes || recover_state.is_box_changed(i, box_idx)) {
                 // this->state_.box_cell_nums[box_idx] = recover_state.boxes[i];
 
                 BitVec16x16::copyAligned(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
 
-                this->count_.counts.box_cells[box_idx] = recover_state.counts.box_cells[box_idx];
-                this->count_.indexs.box_cells[box_idx] = recover_state.indexs.box_cells[box_idx];
+                recover_state.restore_box_counts(i, box_idx, this->count_);
             }
         }
         //this->state_.box_cell_nums[box] = recover_state.boxes[boxesCount];
@@ -2275,10 +2802,9 @@ private:
         //}
     }
 
-#else
 
-    inline void updateNeighborCellsEffect(RecoverState & recover_state,
-                                          size_t fill_pos, size_t box, size_t num) {
+    inline void updateNeighborCellsEffect_scalar(RecoverState & recover_state,
+                                                 size_t fill_pos, size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
@@ -2289,8 +2815,7 @@ private:
             recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
             this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
 
-            recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-            recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
+            recover_state.save_box_counts(i, box_idx, this->count_);
         }
         //recover_state.boxes[boxesCount] = this->state_.box_cell_nums[box];
         //this->state_.box_cell_nums[box] &= neighbors_mask[box];        
@@ -2308,8 +2833,8 @@ private:
         this->state_.box_num_cells[num] &= box_num_neighbors_mask[fill_pos];
     }
 
-    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
-                                           size_t box, size_t num) {
+    inline void restoreNeighborCellsEffect_scalar(const RecoverState & recover_state,
+                                                  size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
@@ -2317,8 +2842,7 @@ private:
             size_t box_idx = neighborBoxes.boxes[i];
             this->state_.box_cell_nums[box_idx] = recover_state.boxes[i];
 
-            this->count_.counts.box_cells[box_idx] = recover_state.counts.box_cells[box_idx];
-            this->count_.indexs.box_cells[box_idx] = recover_state.indexs.box_cells[box_idx];
+            recover_state.restore_box_counts(i, box_idx, this->count_);
         }
         //this->state_.box_cell_nums[box] = recover_state.boxes[boxesCount];
 
@@ -2332,7 +2856,111 @@ private:
         this->state_.box_num_cells[num] = recover_state.box_cells;
     }
 
-#endif // V3_USE_SMID_COPY_BOARD
+    inline void updateNeighborCellsEffect(RecoverState & recover_state,
+                                          size_t fill_pos, size_t box, size_t num) {
+        if (PolicyTy::kSimdCopyBoard)
+            this->updateNeighborCellsEffect_simd(recover_state, fill_pos, box, num);
+        else
+            this->updateNeighborCellsEffect_scalar(recover_state, fill_pos, box, num);
+    }
+
+    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
+                                           size_t box, size_t num) {
+        if (PolicyTy::kSimdCopyBoard)
+            this->restoreNeighborCellsEffect_simd(recover_state, box, num);
+        else
+            this->restoreNeighborCellsEffect_scalar(recover_state, box, num);
+    }
+
+    //
+    // The snapshot backtracking (kBacktrack = Snapshot): the fill doesn't save
+    // anything, the level takes its snapshot before the first candidate and
+    // undoFillNum() copies it back after every candidate.
+    //
+    inline void saveBacktrackState(RecoverState & /* recover_state */) {
+        // The undo-log saves the changes in doFillNum() and updateNeighborCellsEffect().
+    }
+
+    template <typename T>
+    static inline void copySnapshotPart(const T & src, T & dest) {
+        static_assert(((sizeof(T) % sizeof(BitVec16x16)) == 0),
+                      "The parts of the snapshot must be whole 16x16 vectors.");
+        const char * src_mem = (const char *)&src;
+        char * dest_mem = (char *)&dest;
+        for (size_t i = 0; i < sizeof(T); i += sizeof(BitVec16x16)) {
+            BitVec16x16::copyAligned(src_mem + i, dest_mem + i);
+        }
+    }
+
+    inline void saveBacktrackState(SnapshotState & snapshot) {
+        copySnapshotPart(this->state_, snapshot.state);
+        copySnapshotPart(this->count_.enabled, snapshot.enabled);
+        copySnapshotPart(this->count_.counts, snapshot.counts);
+        copySnapshotPart(this->count_.indexs, snapshot.indexs);
+        snapshot.changed_nums = this->count_.changed_nums;
+    }
+
+    inline void doFillNum(size_t pos, size_t row, size_t col,
+                          size_t box, size_t cell, size_t num,
+                          PackedBitSet<Numbers16> & save_num_bits,
+                          SnapshotState & /* snapshot */) {
+        save_num_bits = this->state_.box_cell_nums[box][cell];
+        this->doFillNum(pos, row, col, box, cell, num);
+    }
+
+    inline void updateNeighborCellsEffect(SnapshotState & /* snapshot */,
+                                          size_t fill_pos, size_t box, size_t num) {
+        if (PolicyTy::kSimdCopyBoard) {
+            static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
+            const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
+            const PackedBitSet3D<Boxes, BoxSize16, Numbers16> & neighbors_mask
+                = box_cell_neighbors_mask[fill_pos][num];
+            for (size_t i = 0; i < boxesCount; i++) {
+                size_t box_idx = neighborBoxes.boxes[i];
+                BitVec16x16 box_cell_nums, box_cell_neighbor_mask;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                box_cell_nums &= box_cell_neighbor_mask;
+                box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+            }
+
+            BitVec16x16 num_bits, neighbors_masks;
+            num_bits.loadAligned(&this->state_.row_num_cols[num]);
+            neighbors_masks.loadAligned(&row_neighbors_mask[fill_pos]);
+            num_bits &= neighbors_masks;
+            num_bits.saveAligned(&this->state_.row_num_cols[num]);
+
+            num_bits.loadAligned(&this->state_.col_num_rows[num]);
+            neighbors_masks.loadAligned(&col_neighbors_mask[fill_pos]);
+            num_bits &= neighbors_masks;
+            num_bits.saveAligned(&this->state_.col_num_rows[num]);
+
+            num_bits.loadAligned(&this->state_.box_num_cells[num]);
+            neighbors_masks.loadAligned(&box_num_neighbors_mask[fill_pos]);
+            num_bits &= neighbors_masks;
+            num_bits.saveAligned(&this->state_.box_num_cells[num]);
+        }
+        else {
+            this->updateNeighborCellsEffect(fill_pos, box, num);
+        }
+    }
+
+    inline void restoreNeighborCellsEffect(const SnapshotState & /* snapshot */,
+                                           size_t /* box */, size_t /* num */) {
+        // The whole snapshot is copied back in undoFillNum().
+    }
+
+    inline void undoFillNum(size_t /* pos */, size_t /* row */, size_t /* col */,
+                            size_t /* box */, size_t /* cell */, size_t /* num */,
+                            PackedBitSet<Numbers16> & /* save_num_bits */,
+                            const SnapshotState & snapshot) {
+        copySnapshotPart(snapshot.state, this->state_);
+        copySnapshotPart(snapshot.enabled, this->count_.enabled);
+        copySnapshotPart(snapshot.counts, this->count_.counts);
+        copySnapshotPart(snapshot.indexs, this->count_.indexs);
+        this->count_.changed_nums = snapshot.changed_nums;
+    }
+
 
     inline uint32_t count_all_literal_size(uint32_t & out_min_literal_index) {
         BitVec16x16 bitboard;
@@ -2346,11 +2974,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_cells[box * BoxSize16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_cells[box * BoxSize16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.box_cells[box * BoxSize16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.box_cells, box);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2368,6 +2996,14 @@ private:
         this->count_.total.min_literal_size[0] = (uint16_t)min_cell_size;
         this->count_.total.min_literal_index[0] = (uint16_t)min_cell_index;
 
+        if (this->lazy_select_ && min_cell_size <= 1) {
+            // The cell literal wins the ties, the other literals can wait.
+            this->count_.changed_nums = (uint32_t)kAllNumberBits;
+            out_min_literal_index = min_cell_index;
+            return min_cell_size;
+        }
+        this->count_.changed_nums = 0;
+
         // Row literal
         uint32_t min_row_size = 255;
         uint32_t min_row_index = uint32_t(-1);
@@ -2377,11 +3013,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.row_nums[num * Rows16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.row_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2408,11 +3044,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.col_nums[num * Cols16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.col_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2439,11 +3075,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.box_nums[num * Boxes16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.box_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2473,8 +3109,9 @@ private:
         return min_literal_size;
     }
 
+    template <typename BacktrackStateTy>
     inline uint32_t count_delta_literal_size(uint32_t & out_min_literal_index,
-                                             const RecoverState & recover_state,
+                                             const BacktrackStateTy & recover_state,
                                              const PackedBitSet<Numbers16> & cell_num_bits,
                                              size_t box) {
         BitVec16x16 bitboard;
@@ -2489,17 +3126,17 @@ private:
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
-            if (V3_RECOVER_STATE_DISABL_CHANGED || recover_state.changed.box_cells[box_idx]) {
+            if (PolicyTy::kRecoverAllBoxes || recover_state.is_box_changed(i, box_idx)) {
                 const PackedBitSet2D<BoxSize16, Numbers16> * bitset;
                 bitset = &this->state_.box_cell_nums[box_idx];
                 bitboard.loadAligned(bitset);
 
                 BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3_SAVE_COUNT_SIZE
-                popcnt16.saveAligned(&this->count_.sizes.box_cells[box_idx * BoxSize16]);
-#endif
+                if (PolicyTy::kSaveCountSize) {
+                    popcnt16.saveAligned(&this->count_.sizes.box_cells[box_idx * BoxSize16]);
+                }
                 BitVec16x16 enable_mask;
-                enable_mask.loadAligned(&this->count_.enabled.box_cells[box_idx * BoxSize16]);
+                enabled_t::load_mask(enable_mask, this->count_.enabled.box_cells, box_idx);
                 popcnt16 |= enable_mask;
 
                 int min_index = -1;
@@ -2534,11 +3171,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_cells[box_id * BoxSize16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_cells[box_id * BoxSize16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.box_cells[box_id * BoxSize16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.box_cells, box_id);
             popcnt16 |= enable_mask;
 
             uint32_t min_index = popcnt16.whichIsEqual16(min_cell_size);
@@ -2555,11 +3192,21 @@ private:
         this->count_.total.min_literal_size[0] = (uint16_t)min_cell_size;
         this->count_.total.min_literal_index[0] = (uint16_t)min_cell_index;
 
+        size_t changed_nums = cell_num_bits.to_ulong();
+        if (this->lazy_select_ && min_cell_size <= 1) {
+            // The cell literal wins the ties, the other literals can wait.
+            this->count_.changed_nums |= (uint32_t)changed_nums;
+            out_min_literal_index = min_cell_index;
+            return min_cell_size;
+        }
+        changed_nums |= this->count_.changed_nums;
+        this->count_.changed_nums = 0;
+
         // Row literal
         uint32_t min_row_size = 255;
         uint32_t min_row_index = uint32_t(uint16_t(-1));
 
-        size_t num_bits = cell_num_bits.to_ulong();
+        size_t num_bits = changed_nums;
         while (num_bits != 0) {
             size_t num_bit = BitUtils::ls1b(num_bits);
             size_t num = BitUtils::bsf(num_bit);
@@ -2570,11 +3217,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.row_nums[num * Rows16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.row_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2601,11 +3248,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num_index * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num_index * Rows16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.row_nums[num_index * Rows16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.row_nums, num_index);
             popcnt16 |= enable_mask;
 
             uint32_t min_index = popcnt16.whichIsEqual16(min_row_size);
@@ -2626,7 +3273,7 @@ private:
         uint32_t min_col_size = 255;
         uint32_t min_col_index = uint32_t(uint16_t(-1));
 
-        num_bits = cell_num_bits.to_ulong();
+        num_bits = changed_nums;
         while (num_bits != 0) {
             size_t num_bit = BitUtils::ls1b(num_bits);
             size_t num = BitUtils::bsf(num_bit);
@@ -2637,11 +3284,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.col_nums[num * Cols16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.col_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2667,11 +3314,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num_index * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num_index * Cols16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.col_nums[num_index * Cols16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.col_nums, num_index);
             popcnt16 |= enable_mask;
 
             uint32_t min_index = popcnt16.whichIsEqual16(min_col_size);
@@ -2692,7 +3339,7 @@ private:
         uint32_t min_box_size = 255;
         uint32_t min_box_index = uint32_t(uint16_t(-1));
 
-        num_bits = cell_num_bits.to_ulong();
+        num_bits = changed_nums;
         while (num_bits != 0) {
             size_t num_bit = BitUtils::ls1b(num_bits);
             size_t num = BitUtils::bsf(num_bit);
@@ -2703,11 +3350,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.box_nums[num * Boxes16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.box_nums, num);
             popcnt16 |= enable_mask;
 
             int min_index = -1;
@@ -2733,11 +3380,11 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num_index * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num_index * Boxes16]);
+            }
             BitVec16x16 enable_mask;
-            enable_mask.loadAligned(&this->count_.enabled.box_nums[num_index * Boxes16]);
+            enabled_t::load_mask(enable_mask, this->count_.enabled.box_nums, num_index);
             popcnt16 |= enable_mask;
 
             uint32_t min_index = popcnt16.whichIsEqual16(min_box_size);
@@ -2803,7 +3450,7 @@ private:
             for (size_t cell = 0; cell < BoxSize; cell++) {
                 uint8_t enable = old_get_cell_literal_enable(box * BoxSize16 + cell);
                 if (enable != kDisableLiteral8) {
-                    assert(this->count_.enabled.box_cells[box * BoxSize16 + cell] == kEnableLiteral16);
+                    assert(enabled_t::is_enabled(this->count_.enabled.box_cells, box * BoxSize16 + cell));
                     uint16_t size1 = old_get_cell_literal_cnt(box * BoxSize16 + cell);
                     uint16_t size2 = count_size[cell];
                     if (size1 != size2) {
@@ -2811,7 +3458,7 @@ private:
                     }
                 }
                 else {
-                    assert(this->count_.enabled.box_cells[box * BoxSize16 + cell] == kDisableLiteral16);
+                    assert(!enabled_t::is_enabled(this->count_.enabled.box_cells, box * BoxSize16 + cell));
                     uint16_t size2 = count_size[cell];
                     if (size2 != 0) {
                         wrong_cnt++;
@@ -2826,7 +3473,7 @@ private:
             for (size_t row = 0; row < Rows; row++) {
                 uint8_t enable = old_get_row_literal_enable(num, row);
                 if (enable != kDisableLiteral8) {
-                    assert(this->count_.enabled.row_nums[num * Rows16 + row] == kEnableLiteral16);
+                    assert(enabled_t::is_enabled(this->count_.enabled.row_nums, num * Rows16 + row));
                     uint16_t size1 = old_get_row_literal_cnt(num, row);
                     uint16_t size2 = count_size[row];
                     if (size1 != size2) {
@@ -2834,7 +3481,7 @@ private:
                     }
                 }
                 else {
-                    assert(this->count_.enabled.row_nums[num * Rows16 + row] == kDisableLiteral16);
+                    assert(!enabled_t::is_enabled(this->count_.enabled.row_nums, num * Rows16 + row));
                     uint16_t size2 = count_size[row];
                     if (size2 != 0) {
                         wrong_cnt++;
@@ -2849,7 +3496,7 @@ private:
             for (size_t col = 0; col < Cols; col++) {
                 uint8_t enable = old_get_col_literal_enable(num, col);
                 if (enable != kDisableLiteral8) {
-                    assert(this->count_.enabled.col_nums[num * Cols16 + col] == kEnableLiteral16);
+                    assert(enabled_t::is_enabled(this->count_.enabled.col_nums, num * Cols16 + col));
                     uint16_t size1 = old_get_col_literal_cnt(num, col);
                     uint16_t size2 = count_size[col];
                     if (size1 != size2) {
@@ -2857,7 +3504,7 @@ private:
                     }
                 }
                 else {
-                    assert(this->count_.enabled.col_nums[num * Cols16 + col] == kDisableLiteral16);
+                    assert(!enabled_t::is_enabled(this->count_.enabled.col_nums, num * Cols16 + col));
                     uint16_t size2 = count_size[col];
                     if (size2 != 0) {
                         wrong_cnt++;
@@ -2872,7 +3519,7 @@ private:
             for (size_t box = 0; box < Boxes; box++) {
                 uint8_t enable = old_get_box_literal_enable(num, box);
                 if (enable != kDisableLiteral8) {
-                    assert(this->count_.enabled.box_nums[num * Boxes16 + box] == kEnableLiteral16);
+                    assert(enabled_t::is_enabled(this->count_.enabled.box_nums, num * Boxes16 + box));
                     uint16_t size1 = old_get_box_literal_cnt(num, box);
                     uint16_t size2 = count_size[box];
                     if (size1 != size2) {
@@ -2880,7 +3527,7 @@ private:
                     }
                 }
                 else {
-                    assert(this->count_.enabled.box_nums[num * Boxes16 + box] == kDisableLiteral16);
+                    assert(!enabled_t::is_enabled(this->count_.enabled.box_nums, num * Boxes16 + box));
                     uint16_t size2 = count_size[box];
                     if (size2 != 0) {
                         wrong_cnt++;
@@ -2898,14 +3545,14 @@ public:
         bool success = true;
         uint32_t min_literal_id = min_literal_index;
         {
-            basic_solver_t::num_unique_candidate++;
+            count_stats<StatsTy>(basic_solver_t::num_unique_candidate);
 
 #if V3_ENABLE_OLD_ALGORITHM
             PackedBitSet<Numbers16> save_bits;
             PackedBitSet<BoardSize16> save_effect_cells;
 #endif
             PackedBitSet<Numbers16> save_num_bits;
-            RecoverState recover_state;
+            alignas(32) BacktrackState recover_state;
             size_t pos, row, col, box, cell, num;
             uint32_t next_min_literal_size = 255, next_min_literal_index = (uint32_t)-1;
 
@@ -3068,14 +3715,26 @@ public:
         return success;
     }
 
+    template <size_t nSearchMode = kSearchMode>
     bool solve(Board & board, size_t empties, uint32_t min_literal_size, uint32_t min_literal_index) {
+        AnswerCollector<nSearchMode, Board> collector(this->answers_);
+        return this->template solve<nSearchMode>(board, empties, min_literal_size, min_literal_index, collector);
+    }
+
+    //
+    // Every answer is given to the visitor as soon as it is found, the search
+    // stops when the visitor returns false (and then returns true).
+    //
+    template <size_t nSearchMode, typename VisitorTy>
+    bool solve(Board & board, size_t empties, uint32_t min_literal_size, uint32_t min_literal_index,
+               VisitorTy & visitor) {
+        if (this->poller_.should_stop())
+            return false;
+
         if (empties == 0) {
-            if (kSearchMode > SearchMode::OneAnswer) {
-                this->answers_.push_back(board);
-                if (kSearchMode == SearchMode::MoreThanOneAnswer) {
-                    if (this->answers_.size() > 1)
-                        return true;
-                }
+            if (nSearchMode > SearchMode::OneAnswer) {
+                if (!visitor(static_cast<const Board &>(board)))
+                    return true;
             }
             else {
                 return true;
@@ -3085,16 +3744,20 @@ public:
         uint32_t min_literal_id = min_literal_index;
         if (min_literal_size > 0) {
             if (min_literal_size == 1)
-                basic_solver_t::num_unique_candidate++;
-            else
-                basic_solver_t::num_guesses++;
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
+            else {
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
+                this->poller_.count_guess();
+            }
 
 #if V3_ENABLE_OLD_ALGORITHM
             PackedBitSet<Numbers16> save_bits;
             PackedBitSet<BoardSize16> save_effect_cells;
 #endif
             PackedBitSet<Numbers16> save_num_bits;
-            RecoverState recover_state;
+            alignas(32) BacktrackState recover_state;
             size_t pos, row, col, box, cell, num;
             uint32_t next_min_literal_size, next_min_literal_index;
 
@@ -3127,6 +3790,7 @@ public:
 #if V3_ENABLE_OLD_ALGORITHM
                     assert(this->state_.box_cell_nums[box][cell].count() == old_get_literal_cnt(min_literal_id));
 #endif
+                    this->saveBacktrackState(recover_state);
                     while (num_bits != 0) {
                         size_t num_bit = BitUtils::ls1b(num_bits);
                         num = BitUtils::bsf(num_bit);
@@ -3162,14 +3826,9 @@ public:
                         assert(next_min_literal_index < TotalLiterals);
                         assert(next_min_literal_size == next_min_literal_cnt || next_min_literal_cnt >= Numbers);
 #endif
-                        if (this->solve(board, empties - 1, next_min_literal_size, next_min_literal_index)) {
-                            if (kSearchMode == SearchMode::OneAnswer) {
-                                return true;
-                            }
-                            else if (kSearchMode == SearchMode::MoreThanOneAnswer) {
-                                if (this->answers_.size() > 1)
-                                    return true;
-                            }
+                        if (this->template solve<nSearchMode>(board, empties - 1, next_min_literal_size,
+                                                              next_min_literal_index, visitor)) {
+                            return true;
                         }
 
 #if V3_ENABLE_OLD_ALGORITHM
@@ -3202,6 +3861,7 @@ public:
 #if V3_ENABLE_OLD_ALGORITHM
                     assert(this->state_.row_num_cols[num][row].count() == old_get_literal_cnt(min_literal_id));
 #endif
+                    this->saveBacktrackState(recover_state);
                     while (col_bits != 0) {
                         size_t col_bit = BitUtils::ls1b(col_bits);
                         col = BitUtils::bsf(col_bits);
@@ -3250,14 +3910,9 @@ public:
                         assert(next_min_literal_index < TotalLiterals);
                         assert(next_min_literal_size == next_min_literal_cnt || next_min_literal_cnt >= Cols);
 #endif
-                        if (this->solve(board, empties - 1, next_min_literal_size, next_min_literal_index)) {
-                            if (kSearchMode == SearchMode::OneAnswer) {
-                                return true;
-                            }
-                            else if (kSearchMode == SearchMode::MoreThanOneAnswer) {
-                                if (this->answers_.size() > 1)
-                                    return true;
-                            }
+                        if (this->template solve<nSearchMode>(board, empties - 1, next_min_literal_size,
+                                                              next_min_literal_index, visitor)) {
+                            return true;
                         }
 
 #if V3_ENABLE_OLD_ALGORITHM
@@ -3290,6 +3945,7 @@ public:
 #if V3_ENABLE_OLD_ALGORITHM
                     assert(this->state_.col_num_rows[num][col].count() == old_get_literal_cnt(min_literal_id));
 #endif
+                    this->saveBacktrackState(recover_state);
                     while (row_bits != 0) {
                         size_t row_bit = BitUtils::ls1b(row_bits);
                         row = BitUtils::bsf(row_bits);
@@ -3338,14 +3994,9 @@ public:
                         assert(next_min_literal_index < TotalLiterals);
                         assert(next_min_literal_size == next_min_literal_cnt || next_min_literal_cnt >= Rows);
 #endif
-                        if (this->solve(board, empties - 1, next_min_literal_size, next_min_literal_index)) {
-                            if (kSearchMode == SearchMode::OneAnswer) {
-                                return true;
-                            }
-                            else if (kSearchMode == SearchMode::MoreThanOneAnswer) {
-                                if (this->answers_.size() > 1)
-                                    return true;
-                            }
+                        if (this->template solve<nSearchMode>(board, empties - 1, next_min_literal_size,
+                                                              next_min_literal_index, visitor)) {
+                            return true;
                         }
 
 #if V3_ENABLE_OLD_ALGORITHM
@@ -3378,6 +4029,7 @@ public:
 #if V3_ENABLE_OLD_ALGORITHM
                     assert(this->state_.box_num_cells[num][box].count() == old_get_literal_cnt(min_literal_id));
 #endif
+                    this->saveBacktrackState(recover_state);
                     while (cell_bits != 0) {
                         size_t cell_bit = BitUtils::ls1b(cell_bits);
                         cell = BitUtils::bsf(cell_bits);
@@ -3423,14 +4075,9 @@ public:
                         assert(next_min_literal_index < TotalLiterals);
                         assert(next_min_literal_size == next_min_literal_cnt || next_min_literal_cnt >= BoxSize);
 #endif
-                        if (this->solve(board, empties - 1, next_min_literal_size, next_min_literal_index)) {
-                            if (kSearchMode == SearchMode::OneAnswer) {
-                                return true;
-                            }
-                            else if (kSearchMode == SearchMode::MoreThanOneAnswer) {
-                                if (this->answers_.size() > 1)
-                                    return true;
-                            }
+                        if (this->template solve<nSearchMode>(board, empties - 1, next_min_literal_size,
+                                                              next_min_literal_index, visitor)) {
+                            return true;
                         }
 
 #if V3_ENABLE_OLD_ALGORITHM
@@ -3457,13 +4104,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
 #if 0
         bool success = this->solve(board, this->empties_,
@@ -3485,6 +4135,69 @@ public:
 #endif
     }
 
+    //
+    // Complete search in the given search mode, returns the number of answers:
+    // OneAnswer: 0 or 1, the answer is written to the board.
+    // MoreThanOneAnswer: 0, 1 or 2 (2 means more than one), see answers().
+    // AllAnswers: the number of all answers, see answers().
+    //
+    template <size_t nSearchMode>
+    size_t search(Board & board) {
+        if (nSearchMode > SearchMode::OneAnswer) {
+            this->answers_.clear();
+        }
+        if (!this->check_input(board))
+            return 0;
+        this->init_board(board);
+        bool success = this->template solve<nSearchMode>(board, this->empties_,
+                                                         this->count_.min_literal_size,
+                                                         this->count_.min_literal_index);
+        if (nSearchMode == SearchMode::OneAnswer)
+            return (success ? 1 : 0);
+        else
+            return this->answers_.size();
+    }
+
+    //
+    // The search of one answer from the state of the last count_literals(),
+    // which must have counted this board and returned true. Returns 0 or 1,
+    // as search<OneAnswer>(), without building the state again.
+    //
+    size_t search_counted(Board & board) {
+        bool success = this->template solve<SearchMode::OneAnswer>(board, this->empties_,
+                                                                   this->count_.min_literal_size,
+                                                                   this->count_.min_literal_index);
+        return (success ? 1 : 0);
+    }
+
+    //
+    // Streams all the answers to the visitor, bool visitor(const Board & answer),
+    // nothing is stored. The visitor stops the search by returning false.
+    // Returns the number of the answers given to the visitor.
+    //
+    template <typename VisitorTy>
+    size_t enumerate(const Board & board, VisitorTy & visitor) {
+        Board temp = board;
+        if (!this->check_input(temp))
+            return 0;
+        this->init_board(temp);
+        CountingVisitor<VisitorTy, Board> counter(visitor);
+        this->template solve<SearchMode::AllAnswers>(temp, this->empties_,
+                                                     this->count_.min_literal_size,
+                                                     this->count_.min_literal_index, counter);
+        return counter.count;
+    }
+
+    // 0: no solution, 1: unique solution, 2: more than one solution.
+    size_t count_solutions(const Board & board) {
+        Board temp = board;
+        return this->template search<SearchMode::MoreThanOneAnswer>(temp);
+    }
+
+    const std::vector<Board> & answers() const {
+        return this->answers_;
+    }
+
     void display_result(Board & board, double elapsed_time,
                         bool print_answer = true,
                         bool print_all_answers = true) {
@@ -3492,42 +4205,42 @@ public:
     }
 };
 
-template <typename SudokuTy>
-bool Solver<SudokuTy>::mask_is_inited = false;
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
+bool Solver<SudokuTy, PolicyTy, StatsTy>::mask_is_inited = false;
 
-template <typename SudokuTy>
-std::vector<typename Solver<SudokuTy>::neighbor_boxes_t>
-Solver<SudokuTy>::neighbor_boxes;
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
+std::vector<typename Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes_t>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16 * Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::neighbor_cells_mask;
+PackedBitSet2D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16 * Solver<SudokuTy, PolicyTy, StatsTy>::Cols16>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_cells_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16 * Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::neighbor_boxes_mask;
+PackedBitSet2D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Boxes16 * Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::Boxes, Solver<SudokuTy>::BoxSize16, Solver<SudokuTy>::Numbers16>
-Solver<SudokuTy>::box_cell_neighbors_mask[Solver<SudokuTy>::BoardSize][Solver<SudokuTy>::Numbers];
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::Boxes, Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16, Solver<SudokuTy, PolicyTy, StatsTy>::Numbers16>
+Solver<SudokuTy, PolicyTy, StatsTy>::box_cell_neighbors_mask[Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize][Solver<SudokuTy, PolicyTy, StatsTy>::Numbers];
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16, Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::row_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16, Solver<SudokuTy, PolicyTy, StatsTy>::Cols16>
+Solver<SudokuTy, PolicyTy, StatsTy>::row_neighbors_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Cols16, Solver<SudokuTy>::Rows16>
-Solver<SudokuTy>::col_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Cols16, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16>
+Solver<SudokuTy, PolicyTy, StatsTy>::col_neighbors_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16, Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::box_num_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Boxes16, Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, PolicyTy, StatsTy>::box_num_neighbors_mask;
 
 } // namespace v3
 } // namespace jmSudoku
@@ -59,12 +59,13 @@ namespace v3a {
 
 static const size_t kSearchMode = V3A_SEARCH_MODE;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -1443,9 +1444,11 @@ public:
         assert(min_literal_id < TotalLiterals);
         if (min_literal_cnt > 0) {
             if (min_literal_cnt == 1)
-                basic_solver_t::num_unique_candidate++;
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
             else
-                basic_solver_t::num_guesses++;
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
 
             bitset_type save_bits;
             BitMask save_effect_cells;
@@ -1667,13 +1670,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_);
         return success;
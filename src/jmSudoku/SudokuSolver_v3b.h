@@ -87,12 +87,13 @@ static const NeighborBoxes<3, 3> neighbor_boxes[9] = {
 };
 #endif
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy = BasicStats>
 class Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, StatsTy>           solver_type;
+    typedef StatsTy                             stats_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -1650,9 +1651,11 @@ public:
         assert(min_literal_id < TotalLiterals);
         if (min_literal_cnt > 0) {
             if (min_literal_cnt == 1)
-                basic_solver_t::num_unique_candidate++;
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
             else
-                basic_solver_t::num_guesses++;
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
 
             PackedBitSet<Numbers16> save_bits;
             PackedBitSet<BoardSize16> save_effect_cells;
@@ -1874,13 +1877,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_);
         return success;
@@ -1893,42 +1899,42 @@ public:
     }
 };
 
-template <typename SudokuTy>
-bool Solver<SudokuTy>::mask_is_inited = false;
+template <typename SudokuTy, typename StatsTy>
+bool Solver<SudokuTy, StatsTy>::mask_is_inited = false;
 
-template <typename SudokuTy>
-std::vector<typename Solver<SudokuTy>::neighbor_boxes_t>
-Solver<SudokuTy>::neighbor_boxes;
+template <typename SudokuTy, typename StatsTy>
+std::vector<typename Solver<SudokuTy, StatsTy>::neighbor_boxes_t>
+Solver<SudokuTy, StatsTy>::neighbor_boxes;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16 * Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::neighbor_cells_mask;
+PackedBitSet2D<Solver<SudokuTy, StatsTy>::BoardSize, Solver<SudokuTy, StatsTy>::Rows16 * Solver<SudokuTy, StatsTy>::Cols16>
+Solver<SudokuTy, StatsTy>::neighbor_cells_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16 * Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::neighbor_boxes_mask;
+PackedBitSet2D<Solver<SudokuTy, StatsTy>::BoardSize, Solver<SudokuTy, StatsTy>::Boxes16 * Solver<SudokuTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, StatsTy>::neighbor_boxes_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::Boxes, Solver<SudokuTy>::BoxSize16, Solver<SudokuTy>::Numbers16>
-Solver<SudokuTy>::neighbors_box_cell_mask[Solver<SudokuTy>::BoardSize][Solver<SudokuTy>::Numbers];
+PackedBitSet3D<Solver<SudokuTy, StatsTy>::Boxes, Solver<SudokuTy, StatsTy>::BoxSize16, Solver<SudokuTy, StatsTy>::Numbers16>
+Solver<SudokuTy, StatsTy>::neighbors_box_cell_mask[Solver<SudokuTy, StatsTy>::BoardSize][Solver<SudokuTy, StatsTy>::Numbers];
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16, Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::neighbors_row_mask;
+PackedBitSet3D<Solver<SudokuTy, StatsTy>::BoardSize, Solver<SudokuTy, StatsTy>::Rows16, Solver<SudokuTy, StatsTy>::Cols16>
+Solver<SudokuTy, StatsTy>::neighbors_row_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Cols16, Solver<SudokuTy>::Rows16>
-Solver<SudokuTy>::neighbors_col_mask;
+PackedBitSet3D<Solver<SudokuTy, StatsTy>::BoardSize, Solver<SudokuTy, StatsTy>::Cols16, Solver<SudokuTy, StatsTy>::Rows16>
+Solver<SudokuTy, StatsTy>::neighbors_col_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16, Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::neighbors_box_num_mask;
+PackedBitSet3D<Solver<SudokuTy, StatsTy>::BoardSize, Solver<SudokuTy, StatsTy>::Boxes16, Solver<SudokuTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, StatsTy>::neighbors_box_num_mask;
 
 } // namespace v3b
 } // namespace jmSudoku
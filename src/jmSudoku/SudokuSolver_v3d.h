@@ -28,6 +28,7 @@
 #endif // _MSC_VER
 
 #include "Sudoku.h"
+#include "SudokuVerify.h"
 #include "StopWatch.h"
 #include "BitUtils.h"
 #include "BitSet.h"
@@ -3098,6 +3099,8 @@ public:
     }
 
     bool solve(Board & board) {
+        if (check_board(board) != BoardCheck::BoardValid)
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_,
                                    this->count_.min_literal_size,
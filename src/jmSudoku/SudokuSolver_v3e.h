@@ -57,6 +57,8 @@
 #define V3E_ENABLE_OLD_ALGORITHM     0
 #define V3E_USE_SMID_COPY_BOARD      1
 
+#define V3E_USE_SIMD_INIT_BOARD      1
+
 #define V3E_RECOVER_STATE_DISABL_CHANGED     1
 
 namespace jmSudoku {
@@ -87,12 +89,37 @@ static const NeighborBoxes<3, 3> neighbor_boxes[9] = {
 };
 #endif
 
-template <typename SudokuTy>
-class Solver : public BasicSolver<SudokuTy> {
+//
+// The switches of the solver, the defaults come from the macros above, so
+// that the combinations can be built and compared in one binary:
+//   kSaveCountSize:    keep the size of every literal in count_.sizes,
+//   kSimdCopyBoard:    save and restore the bitboards with 16x16 vectors,
+//   kRecoverAllBoxes:  restore all the neighbor boxes, not only the changed
+//                      ones (the scalar copy needs it),
+//   kSimdInitBoard:    build the 9x9 state in bulk in init_board(),
+//
+template <bool SaveCountSize, bool SimdCopyBoard, bool RecoverAllBoxes,
+          bool SimdInitBoard>
+struct SolverPolicy {
+    static const bool kSaveCountSize = SaveCountSize;
+    static const bool kSimdCopyBoard = SimdCopyBoard;
+    static const bool kRecoverAllBoxes = RecoverAllBoxes;
+    static const bool kSimdInitBoard = SimdInitBoard;
+};
+
+typedef SolverPolicy<(V3E_SAVE_COUNT_SIZE != 0), (V3E_USE_SMID_COPY_BOARD != 0),
+                     (V3E_RECOVER_STATE_DISABL_CHANGED != 0), (V3E_USE_SIMD_INIT_BOARD != 0)>
+                     DefaultPolicy;
+
+// Aligned as a whole: the alignas(32) of its packed members doesn't hold.
+template <typename SudokuTy, typename PolicyTy = DefaultPolicy, typename StatsTy = BasicStats>
+class alignas(32) Solver : public BasicSolver<SudokuTy> {
 public:
     typedef SudokuTy                            sudoku_t;
     typedef BasicSolver<SudokuTy>               basic_solver_t;
-    typedef Solver<SudokuTy>                    solver_type;
+    typedef Solver<SudokuTy, PolicyTy, StatsTy> solver_type;
+    typedef StatsTy                             stats_t;
+    typedef PolicyTy                            policy_t;
 
     typedef typename basic_solver_t::Board      Board;
     typedef typename sudoku_t::NeighborCells    NeighborCells;
@@ -102,6 +129,9 @@ public:
     typedef typename sudoku_t::BitMask          BitMask;
     typedef typename sudoku_t::BitMaskTable     BitMaskTable;
 
+    static_assert(PolicyTy::kSimdCopyBoard || PolicyTy::kRecoverAllBoxes,
+                  "The scalar copy of the board doesn't keep the changed boxes.");
+
     static const size_t kAlignment = sudoku_t::kAlignment;
     static const size_t BoxCellsX = sudoku_t::BoxCellsX;      // 3
     static const size_t BoxCellsY = sudoku_t::BoxCellsY;      // 3
@@ -225,7 +255,9 @@ private:
         alignas(32) PackedBitSet3D<Numbers, Boxes16, BoxSize16>   num_box_cells;    // [num][box][cell]
     };
 
-    struct RecoverState {
+    // The alignas(32) of the members is dropped by the pack(1), the struct
+    // keeps its own, the SIMD code loads and stores it aligned.
+    struct alignas(32) RecoverState {
         static const size_t kBoxesTotal = neighbor_boxes_t::kBoxesCount;
         alignas(32) PackedBitSet2D<BoxSize16, Numbers16>          boxes[kBoxesTotal];   // [cell][num]
         alignas(32) PackedBitSet2D<Rows16, Cols16>                row_cols;             // [row][col]
@@ -308,6 +340,9 @@ private:
     State   state_;
     Count   count_;
 
+    // Behind the packed members, so that their offsets don't change.
+    SearchPoller    poller_;
+
 #if V3E_ENABLE_OLD_ALGORITHM
 #if defined(__SSE4_1__)
     alignas(32) literal_info_t literal_info_[TotalLiterals];
@@ -337,6 +372,9 @@ public:
     }
     ~Solver() {}
 
+    SearchControl * control() const { return this->poller_.control(); }
+    void set_control(SearchControl * control) { this->poller_.set_control(control); }
+
 private:
     static size_t make_neighbor_cells_masklist(size_t fill_pos,
                                                size_t row, size_t col) {
@@ -524,6 +562,148 @@ private:
     }
 
     void init_board(Board & board) {
+        if (PolicyTy::kSimdInitBoard && BoardSize == 81)
+            this->init_board_simd(board);
+        else
+            this->init_board_scalar(board);
+    }
+
+public:
+    //
+    // Builds the same state as init_board_scalar(), in bulk (9x9 only):
+    //   - the one-hot masks of the givens come from two pshufb,
+    //   - the candidates of an empty cell are the numbers that its row,
+    //     column and box don't have,
+    //   - the [num] bitboards are the AND of the neighbor masks of the givens
+    //     of the num (the masks of updateNeighborCellsEffect()), without the
+    //     filled cells.
+    //
+    void init_board_simd(Board & board) {
+        init_literal_info();
+
+        this->poller_.reset();
+
+        basic_solver_t::num_guesses = 0;
+        basic_solver_t::num_unique_candidate = 0;
+        basic_solver_t::num_failed_return = 0;
+        if (kSearchMode > SEARCH_MODE_ONE_ANSWER) {
+            this->answers_.clear();
+        }
+
+        alignas(16) uint16_t masks[BoardSize + 7];
+        uint64_t givens[2];
+        {
+            const __m128i one_char  = _mm_set1_epi8('1');
+            const __m128i dot_char  = _mm_set1_epi8('.');
+            const __m128i max_index = _mm_set1_epi8(15);
+            const __m128i lo_table  = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i hi_table  = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0);
+
+            // 81 cells: 5 vectors and the last one overlapped at 65.
+            uint64_t empty_bits[6];
+            for (size_t i = 0; i < 6; i++) {
+                size_t offset = (i < 5) ? (i * 16) : (BoardSize - 16);
+                __m128i cells = _mm_loadu_si128((const __m128i *)(board.cells + offset));
+                empty_bits[i] = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(cells, dot_char));
+                __m128i index = _mm_min_epu8(_mm_sub_epi8(cells, one_char), max_index);
+                __m128i lo = _mm_shuffle_epi8(lo_table, index);
+                __m128i hi = _mm_shuffle_epi8(hi_table, index);
+                _mm_storeu_si128((__m128i *)(masks + offset), _mm_unpacklo_epi8(lo, hi));
+                _mm_storeu_si128((__m128i *)(masks + offset + 8), _mm_unpackhi_epi8(lo, hi));
+            }
+            uint64_t empties_lo = empty_bits[0] | (empty_bits[1] << 16) | (empty_bits[2] << 32) | (empty_bits[3] << 48);
+            uint64_t empties_hi = empty_bits[4] | ((empty_bits[5] >> 15) << 16);
+            givens[0] = ~empties_lo;
+            givens[1] = ~empties_hi & 0x1FFFFull;
+        }
+        this->empties_ = BoardSize - BitUtils::popcnt64(givens[0]) - BitUtils::popcnt64(givens[1]);
+
+        uint32_t rows[Rows16] = { 0 };
+        uint32_t cols[Cols16] = { 0 };
+        uint32_t boxes[Boxes16] = { 0 };
+        alignas(32) uint16_t row_givens[Rows16] = { 0 };
+        alignas(32) uint16_t col_givens[Cols16] = { 0 };
+        alignas(32) uint16_t box_givens[Boxes16] = { 0 };
+        uint8_t num_givens[Numbers][BoardSize];
+        size_t num_counts[Numbers] = { 0 };
+
+        for (size_t n = 0; n < 2; n++) {
+            uint64_t bits = givens[n];
+            while (bits != 0) {
+                size_t pos = n * 64 + BitUtils::bsf64(bits);
+                bits &= bits - 1;
+                const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+                size_t row = cellInfo.row;
+                size_t col = cellInfo.col;
+                size_t box = cellInfo.box;
+                size_t cell = cellInfo.cell;
+                uint32_t num_bit = masks[pos];
+                size_t num = BitUtils::bsf32(num_bit);
+
+                rows[row] |= num_bit;
+                cols[col] |= num_bit;
+                boxes[box] |= num_bit;
+                row_givens[row] |= uint16_t(1U << col);
+                col_givens[col] |= uint16_t(1U << row);
+                box_givens[box] |= uint16_t(1U << cell);
+                num_givens[num][num_counts[num]++] = (uint8_t)pos;
+
+                disable_cell_literal(box * BoxSize16 + cell);
+                disable_row_literal(num * Rows16 + row);
+                disable_col_literal(num * Cols16 + col);
+                disable_box_literal(num * Boxes16 + box);
+            }
+        }
+
+        // The padding cells keep all the numbers.
+        this->state_.box_cell_nums.fill(kAllNumberBits);
+        uint16_t * box_cells = (uint16_t *)&this->state_.box_cell_nums;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            const CellInfo & cellInfo = sudoku_t::cell_info[pos];
+            uint32_t cands = ~(rows[cellInfo.row] | cols[cellInfo.col] | boxes[cellInfo.box]) &
+                             (uint32_t)kAllNumberBits;
+            box_cells[cellInfo.box * BoxSize16 + cellInfo.cell] = (masks[pos] == 0) ? (uint16_t)cands : 0;
+        }
+
+        // The empty cells, the padding rows, cols and boxes keep all the bits.
+        BitVec16x16 row_empties, col_empties, box_empties;
+        BitVec16x16 all_bits;
+        row_empties.loadAligned(row_givens);
+        all_bits.fill_u16((uint16_t)kAllColBits);
+        row_empties._and_not(all_bits);
+        col_empties.loadAligned(col_givens);
+        all_bits.fill_u16((uint16_t)kAllRowBits);
+        col_empties._and_not(all_bits);
+        box_empties.loadAligned(box_givens);
+        all_bits.fill_u16((uint16_t)kAllBoxCellBits);
+        box_empties._and_not(all_bits);
+
+        for (size_t num = 0; num < Numbers; num++) {
+            BitVec16x16 row_bits = row_empties;
+            BitVec16x16 col_bits = col_empties;
+            BitVec16x16 box_bits = box_empties;
+            for (size_t i = 0; i < num_counts[num]; i++) {
+                size_t pos = num_givens[num][i];
+                BitVec16x16 mask;
+                mask.loadAligned(&row_neighbors_mask[pos]);
+                row_bits &= mask;
+                mask.loadAligned(&col_neighbors_mask[pos]);
+                col_bits &= mask;
+                mask.loadAligned(&box_num_neighbors_mask[pos]);
+                box_bits &= mask;
+            }
+            row_bits.saveAligned(&this->state_.num_row_cols[num]);
+            col_bits.saveAligned(&this->state_.num_col_rows[num]);
+            box_bits.saveAligned(&this->state_.num_box_cells[num]);
+        }
+
+        uint32_t min_literal_index;
+        uint32_t min_literal_size = this->count_all_literal_size(min_literal_index);
+        this->count_.min_literal_size = min_literal_size;
+        this->count_.min_literal_index = min_literal_index;
+    }
+
+    void init_board_scalar(Board & board) {
 #if V3E_ENABLE_OLD_ALGORITHM
         old_init_literal_info();
 #endif
@@ -543,6 +723,8 @@ private:
         this->state_.num_col_rows.fill(kAllRowBits);
         this->state_.num_box_cells.fill(kAllBoxCellBits);
 
+        this->poller_.reset();
+
         basic_solver_t::num_guesses = 0;
         basic_solver_t::num_unique_candidate = 0;
         basic_solver_t::num_failed_return = 0;
@@ -590,6 +772,21 @@ private:
 #endif
     }
 
+    // Builds the state by both paths, true if they are bit-identical.
+    bool check_init_board(Board & board) {
+        this->init_board_scalar(board);
+        State state = this->state_;
+        Count count = this->count_;
+        size_t empties = this->empties_;
+
+        this->init_board_simd(board);
+        return ((std::memcmp((const void *)&state, (const void *)&this->state_, sizeof(State)) == 0) &&
+                (std::memcmp((const void *)&count, (const void *)&this->count_, sizeof(Count)) == 0) &&
+                (empties == this->empties_));
+    }
+
+private:
+
 #if V3E_ENABLE_OLD_ALGORITHM
     static const size_t kLiteralStep = sizeof(size_t) / sizeof(literal_info_t);
 
@@ -2110,10 +2307,9 @@ private:
         }
     }
 
-#if V3E_USE_SMID_COPY_BOARD
 
-    inline void updateNeighborCellsEffect(RecoverState & recover_state,
-                                          size_t fill_pos, size_t box, size_t num) {
+    inline void updateNeighborCellsEffect_simd(RecoverState & recover_state,
+                                               size_t fill_pos, size_t box, size_t num) {
         static const bool hasChanged = true;
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
@@ -2123,60 +2319,63 @@ private:
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
 
-#if V3E_RECOVER_STATE_DISABL_CHANGED
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
-            
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            box_cell_nums &= box_cell_neighbor_mask;
-            box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
-
-            recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-            recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
-#elif 1
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
+            if (PolicyTy::kRecoverAllBoxes) {
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
             
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            box_cell_nums &= box_cell_neighbor_mask;
-
-            box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                box_cell_nums &= box_cell_neighbor_mask;
+                box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
 
-            bool boxHasChanged = (box_idx == box) ||
-                                 !BitVec16x16::isMemEqual(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
-            recover_state.changed.box_cells[box_idx] = boxHasChanged;
-            if (boxHasChanged) {
                 recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
                 recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
             }
+            else {
+#if 1
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
+            
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                box_cell_nums &= box_cell_neighbor_mask;
+
+                box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+
+                bool boxHasChanged = (box_idx == box) ||
+                                     !BitVec16x16::isMemEqual(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
+                recover_state.changed.box_cells[box_idx] = boxHasChanged;
+                if (boxHasChanged) {
+                    recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
+                    recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
+                }
 #else
-            // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
-            BitVec16x16 box_cell_nums, new_box_cell_nums;
-            box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
-            new_box_cell_nums = box_cell_nums;
-            box_cell_nums.saveAligned(&recover_state.boxes[i]);
+                // recover_state.boxes[i] = this->state_.box_cell_nums[box_idx];
+                BitVec16x16 box_cell_nums, new_box_cell_nums;
+                box_cell_nums.loadAligned(&this->state_.box_cell_nums[box_idx]);
+                new_box_cell_nums = box_cell_nums;
+                box_cell_nums.saveAligned(&recover_state.boxes[i]);
             
-            // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
-            BitVec16x16 box_cell_neighbor_mask;
-            box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
-            new_box_cell_nums &= box_cell_neighbor_mask;
-
-            bool boxHasChanged = (box_idx == box) || (new_box_cell_nums != box_cell_nums);
-            recover_state.changed.box_cells[box_idx] = boxHasChanged;
-            if (boxHasChanged) {
-                new_box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
-                recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
-                recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
-            }
+                // this->state_.box_cell_nums[box_idx] &= neighbors_mask[box_idx];
+                BitVec16x16 box_cell_neighbor_mask;
+                box_cell_neighbor_mask.loadAligned(&neighbors_mask[box_idx]);
+                new_box_cell_nums &= box_cell_neighbor_mask;
+
+                bool boxHasChanged = (box_idx == box) || (new_box_cell_nums != box_cell_nums);
+                recover_state.changed.box_cells[box_idx] = boxHasChanged;
+                if (boxHasChanged) {
+                    new_box_cell_nums.saveAligned(&this->state_.box_cell_nums[box_idx]);
+                    recover_state.counts.box_cells[box_idx] = this->count_.counts.box_cells[box_idx];
+                    recover_state.indexs.box_cells[box_idx] = this->count_.indexs.box_cells[box_idx];
+                }
 #endif
+            }
         }
         //recover_state.boxes[boxesCount] = this->state_.box_cell_nums[box];
         //this->state_.box_cell_nums[box] &= neighbors_mask[box];        
@@ -2230,14 +2429,14 @@ private:
         }
     }
 
-    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
-                                           size_t box, size_t num) {
+    inline void restoreNeighborCellsEffect_simd(const RecoverState & recover_state,
+                                                size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
-            if (V3E_RECOVER_STATE_DISABL_CHANGED || recover_state.changed.box_cells[box_idx]) {
+            if (PolicyTy::kRecoverAllBoxes || recover_state.changed.box_cells[box_idx]) {
                 // this->state_.box_cell_nums[box_idx] = recover_state.boxes[i];
 
                 BitVec16x16::copyAligned(&recover_state.boxes[i], &this->state_.box_cell_nums[box_idx]);
@@ -2267,10 +2466,9 @@ private:
         //}
     }
 
-#else
 
-    inline void updateNeighborCellsEffect(RecoverState & recover_state,
-                                          size_t fill_pos, size_t box, size_t num) {
+    inline void updateNeighborCellsEffect_scalar(RecoverState & recover_state,
+                                                 size_t fill_pos, size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
@@ -2300,8 +2498,8 @@ private:
         this->state_.num_box_cells[num] &= box_num_neighbors_mask[fill_pos];
     }
 
-    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
-                                           size_t box, size_t num) {
+    inline void restoreNeighborCellsEffect_scalar(const RecoverState & recover_state,
+                                                  size_t box, size_t num) {
         // Position (Box-Cell) literal
         static const size_t boxesCount = neighbor_boxes_t::kBoxesCount;
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
@@ -2324,7 +2522,22 @@ private:
         this->state_.num_box_cells[num] = recover_state.box_cells;
     }
 
-#endif // V3E_USE_SMID_COPY_BOARD
+    inline void updateNeighborCellsEffect(RecoverState & recover_state,
+                                          size_t fill_pos, size_t box, size_t num) {
+        if (PolicyTy::kSimdCopyBoard)
+            this->updateNeighborCellsEffect_simd(recover_state, fill_pos, box, num);
+        else
+            this->updateNeighborCellsEffect_scalar(recover_state, fill_pos, box, num);
+    }
+
+    inline void restoreNeighborCellsEffect(const RecoverState & recover_state,
+                                           size_t box, size_t num) {
+        if (PolicyTy::kSimdCopyBoard)
+            this->restoreNeighborCellsEffect_simd(recover_state, box, num);
+        else
+            this->restoreNeighborCellsEffect_scalar(recover_state, box, num);
+    }
+
 
     inline uint32_t count_all_literal_size(uint32_t & out_min_literal_index) {
         BitVec16x16 bitboard;
@@ -2338,9 +2551,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_cells[box * BoxSize16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_cells[box * BoxSize16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.box_cells[box * BoxSize16]);
             popcnt16 |= enable_mask;
@@ -2369,9 +2582,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.row_nums[num * Rows16]);
             popcnt16 |= enable_mask;
@@ -2400,9 +2613,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.col_nums[num * Cols16]);
             popcnt16 |= enable_mask;
@@ -2431,9 +2644,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.box_nums[num * Boxes16]);
             popcnt16 |= enable_mask;
@@ -2481,15 +2694,15 @@ private:
         const neighbor_boxes_t & neighborBoxes = neighbor_boxes[box];
         for (size_t i = 0; i < boxesCount; i++) {
             size_t box_idx = neighborBoxes.boxes[i];
-            if (V3E_RECOVER_STATE_DISABL_CHANGED || recover_state.changed.box_cells[box_idx]) {
+            if (PolicyTy::kRecoverAllBoxes || recover_state.changed.box_cells[box_idx]) {
                 const PackedBitSet2D<BoxSize16, Numbers16> * bitset;
                 bitset = &this->state_.box_cell_nums[box_idx];
                 bitboard.loadAligned(bitset);
 
                 BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3E_SAVE_COUNT_SIZE
-                popcnt16.saveAligned(&this->count_.sizes.box_cells[box_idx * BoxSize16]);
-#endif
+                if (PolicyTy::kSaveCountSize) {
+                    popcnt16.saveAligned(&this->count_.sizes.box_cells[box_idx * BoxSize16]);
+                }
                 BitVec16x16 enable_mask;
                 enable_mask.loadAligned(&this->count_.enabled.box_cells[box_idx * BoxSize16]);
                 popcnt16 |= enable_mask;
@@ -2526,9 +2739,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Numbers>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_cells[box_id * BoxSize16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_cells[box_id * BoxSize16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.box_cells[box_id * BoxSize16]);
             popcnt16 |= enable_mask;
@@ -2562,9 +2775,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num * Rows16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.row_nums[num * Rows16]);
             popcnt16 |= enable_mask;
@@ -2593,9 +2806,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Cols>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.row_nums[num_index * Rows16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.row_nums[num_index * Rows16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.row_nums[num_index * Rows16]);
             popcnt16 |= enable_mask;
@@ -2629,9 +2842,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num * Cols16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.col_nums[num * Cols16]);
             popcnt16 |= enable_mask;
@@ -2659,9 +2872,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<Rows>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.col_nums[num_index * Cols16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.col_nums[num_index * Cols16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.col_nums[num_index * Cols16]);
             popcnt16 |= enable_mask;
@@ -2695,9 +2908,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num * Boxes16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.box_nums[num * Boxes16]);
             popcnt16 |= enable_mask;
@@ -2725,9 +2938,9 @@ private:
             bitboard.loadAligned(bitset);
 
             BitVec16x16 popcnt16 = bitboard.popcount16<BoxSize>();
-#if V3E_SAVE_COUNT_SIZE
-            popcnt16.saveAligned(&this->count_.sizes.box_nums[num_index * Boxes16]);
-#endif
+            if (PolicyTy::kSaveCountSize) {
+                popcnt16.saveAligned(&this->count_.sizes.box_nums[num_index * Boxes16]);
+            }
             BitVec16x16 enable_mask;
             enable_mask.loadAligned(&this->count_.enabled.box_nums[num_index * Boxes16]);
             popcnt16 |= enable_mask;
@@ -2887,6 +3100,9 @@ private:
 
 public:
     bool solve(Board & board, size_t empties, uint32_t min_literal_size, uint32_t min_literal_index) {
+        if (this->poller_.should_stop())
+            return false;
+
         if (empties == 0) {
             if (kSearchMode > SearchMode::OneAnswer) {
                 this->answers_.push_back(board);
@@ -2903,16 +3119,20 @@ public:
         uint32_t min_literal_id = min_literal_index;
         if (min_literal_size > 0) {
             if (min_literal_size == 1)
-                basic_solver_t::num_unique_candidate++;
-            else
-                basic_solver_t::num_guesses++;
+                count_stats<StatsTy>(basic_solver_t::num_unique_candidate, basic_solver_t::unique_depths,
+                                     this->empties_ - empties);
+            else {
+                count_stats<StatsTy>(basic_solver_t::num_guesses, basic_solver_t::guess_depths,
+                                     this->empties_ - empties);
+                this->poller_.count_guess();
+            }
 
 #if V3E_ENABLE_OLD_ALGORITHM
             PackedBitSet<Numbers16> save_bits;
             PackedBitSet<BoardSize16> save_effect_cells;
 #endif
             PackedBitSet<Numbers16> save_num_bits;
-            RecoverState recover_state;
+            alignas(32) RecoverState recover_state;
             size_t pos, row, col, box, cell, num;
             uint32_t next_min_literal_size, next_min_literal_index;
 
@@ -3275,13 +3495,16 @@ public:
             }
         }
         else {
-            basic_solver_t::num_failed_return++;
+            count_stats<StatsTy>(basic_solver_t::num_failed_return, basic_solver_t::failed_depths,
+                                 this->empties_ - empties);
         }
 
         return false;
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_,
                                    this->count_.min_literal_size,
@@ -3296,42 +3519,42 @@ public:
     }
 };
 
-template <typename SudokuTy>
-bool Solver<SudokuTy>::mask_is_inited = false;
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
+bool Solver<SudokuTy, PolicyTy, StatsTy>::mask_is_inited = false;
 
-template <typename SudokuTy>
-std::vector<typename Solver<SudokuTy>::neighbor_boxes_t>
-Solver<SudokuTy>::neighbor_boxes;
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
+std::vector<typename Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes_t>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16 * Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::neighbor_cells_mask;
+PackedBitSet2D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16 * Solver<SudokuTy, PolicyTy, StatsTy>::Cols16>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_cells_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet2D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16 * Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::neighbor_boxes_mask;
+PackedBitSet2D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Boxes16 * Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, PolicyTy, StatsTy>::neighbor_boxes_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::Boxes, Solver<SudokuTy>::BoxSize16, Solver<SudokuTy>::Numbers16>
-Solver<SudokuTy>::box_cell_neighbors_mask[Solver<SudokuTy>::BoardSize][Solver<SudokuTy>::Numbers];
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::Boxes, Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16, Solver<SudokuTy, PolicyTy, StatsTy>::Numbers16>
+Solver<SudokuTy, PolicyTy, StatsTy>::box_cell_neighbors_mask[Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize][Solver<SudokuTy, PolicyTy, StatsTy>::Numbers];
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Rows16, Solver<SudokuTy>::Cols16>
-Solver<SudokuTy>::row_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16, Solver<SudokuTy, PolicyTy, StatsTy>::Cols16>
+Solver<SudokuTy, PolicyTy, StatsTy>::row_neighbors_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Cols16, Solver<SudokuTy>::Rows16>
-Solver<SudokuTy>::col_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Cols16, Solver<SudokuTy, PolicyTy, StatsTy>::Rows16>
+Solver<SudokuTy, PolicyTy, StatsTy>::col_neighbors_mask;
 
-template <typename SudokuTy>
+template <typename SudokuTy, typename PolicyTy, typename StatsTy>
 alignas(32)
-PackedBitSet3D<Solver<SudokuTy>::BoardSize, Solver<SudokuTy>::Boxes16, Solver<SudokuTy>::BoxSize16>
-Solver<SudokuTy>::box_num_neighbors_mask;
+PackedBitSet3D<Solver<SudokuTy, PolicyTy, StatsTy>::BoardSize, Solver<SudokuTy, PolicyTy, StatsTy>::Boxes16, Solver<SudokuTy, PolicyTy, StatsTy>::BoxSize16>
+Solver<SudokuTy, PolicyTy, StatsTy>::box_num_neighbors_mask;
 
 } // namespace v3e
 } // namespace jmSudoku
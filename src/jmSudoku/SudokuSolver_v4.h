@@ -736,6 +736,8 @@ public:
     }
 
     bool solve(Board & board) {
+        if (!this->check_input(board))
+            return false;
         this->init_board(board);
         bool success = this->solve(board, this->empties_,
                                    this->min_info_.literal_size,
@@ -0,0 +1,481 @@
+
+#ifndef JM_SUDOKU_STREAM_H
+#define JM_SUDOKU_STREAM_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>      // For std::memcpy()
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "Sudoku.h"
+#include "SudokuVerify.h"
+
+//
+// Streaming filter: reads one puzzle per line and writes one line per puzzle,
+// the solution (81 numbers), "no solution", "multiple" or "invalid", in the
+// order of the input. Empty lines and comments ('#' or "//") are skipped.
+//
+// The input is read in large blocks and cut into batches of puzzles. A pool
+// of 2 * (threads + 1) batches flows through three stages: the reader parses,
+// the workers solve and format the output text, the writer writes the batches
+// back in sequence. So every stage works on one batch while the next one is
+// filled. With threads = 0 all the stages run inline on the calling thread.
+//
+// The blocks are read from the file descriptor of the input, a read returns
+// what a pipe has so far. After such a short read the batch is sent at once
+// and its output is flushed, so a producer that waits for its answers isn't
+// stalled by a half filled batch. Nothing must be left in the stdio buffer
+// of the input. A write error stops the reader.
+//
+// The SudokuSolver must provide search<SearchMode::MoreThanOneAnswer>(board)
+// and answers(), see v3::Solver.
+//
+namespace jmSudoku {
+
+template <typename SudokuSolver>
+class StreamFilter {
+public:
+    typedef SudokuSolver                                solver_type;
+    typedef typename SudokuSolver::sudoku_t             sudoku_t;
+    typedef typename SudokuSolver::Board                Board;
+
+    static const size_t BoardSize = sudoku_t::BoardSize;
+    static const size_t kReadBufSize = 4 * 1024 * 1024;
+    static const size_t kDefaultBatchSize = 4096;
+    static const size_t kMaxLineLength = 1024;
+
+    enum Status {
+        Solved,
+        NoSolution,
+        Multiple,
+        Invalid,
+        StatusLast
+    };
+
+    struct Stats {
+        size_t  puzzles;
+        size_t  status[StatusLast];
+
+        void reset() {
+            this->puzzles = 0;
+            for (size_t i = 0; i < StatusLast; i++) {
+                this->status[i] = 0;
+            }
+        }
+    };
+
+private:
+    struct Batch {
+        size_t              sequence;
+        size_t              size;
+        std::vector<Board>  boards;
+        std::vector<char>   output;
+        size_t              status[StatusLast];
+        bool                flush;      // Cut by a short read, flush the output
+
+        Batch(size_t capacity) : sequence(0), size(0), boards(capacity), flush(false) {
+            this->output.reserve(capacity * (BoardSize + 1));
+        }
+    };
+
+    size_t                      threads_;
+    size_t                      batch_size_;
+    Stats                       stats_;
+
+    std::vector<Batch *>        batches_;
+
+    std::mutex                  mutex_;
+    std::condition_variable     free_cond_;
+    std::condition_variable     work_cond_;
+    std::condition_variable     done_cond_;
+
+    std::vector<Batch *>        free_list_;
+    std::deque<Batch *>         work_queue_;
+    std::map<size_t, Batch *>   done_map_;
+    bool                        input_end_;
+    bool                        write_failed_;
+    size_t                      total_batches_;
+
+public:
+    StreamFilter(size_t threads = 0, size_t batch_size = kDefaultBatchSize)
+        : threads_(threads), batch_size_((batch_size != 0) ? batch_size : kDefaultBatchSize),
+          input_end_(false), write_failed_(false), total_batches_(0) {
+        this->stats_.reset();
+    }
+
+    ~StreamFilter() {
+        for (size_t i = 0; i < this->batches_.size(); i++) {
+            delete this->batches_[i];
+        }
+        this->batches_.clear();
+    }
+
+    const Stats & stats() const { return this->stats_; }
+
+    static const char * status_name(size_t status) {
+        static const char * names[StatusLast] = {
+            "solved", "no solution", "multiple", "invalid"
+        };
+        return (status < StatusLast) ? names[status] : "unknown";
+    }
+
+    // Returns false if a read or write error occurred.
+    bool run(FILE * in, FILE * out) {
+        this->stats_.reset();
+        this->input_end_ = false;
+        this->write_failed_ = false;
+        this->total_batches_ = 0;
+        this->free_list_.clear();
+        this->work_queue_.clear();
+        this->done_map_.clear();
+
+        size_t pool_size = 2 * (this->threads_ + 1);
+        while (this->batches_.size() < pool_size) {
+            this->batches_.push_back(new Batch(this->batch_size_));
+        }
+        for (size_t i = 0; i < pool_size; i++) {
+            this->free_list_.push_back(this->batches_[i]);
+        }
+
+        // The inline mode solves on this one. It is built before the workers
+        // start, so they never race on the static mask tables.
+        solver_type solver;
+
+        bool write_ok = true;
+        std::vector<std::thread> workers;
+        std::thread writer;
+        if (this->threads_ != 0) {
+            for (size_t i = 0; i < this->threads_; i++) {
+                workers.emplace_back(&StreamFilter::worker_thread, this);
+            }
+            writer = std::thread([this, out, &write_ok]() {
+                write_ok = this->writer_thread(out);
+            });
+        }
+
+        // Inline, a write error is returned by the reader.
+        bool read_ok = this->reader(in, out, solver);
+
+        if (this->threads_ != 0) {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->input_end_ = true;
+            }
+            this->work_cond_.notify_all();
+            this->done_cond_.notify_all();
+            for (size_t i = 0; i < workers.size(); i++) {
+                workers[i].join();
+            }
+            writer.join();
+        }
+
+        std::fflush(out);
+        return (read_ok && write_ok);
+    }
+
+private:
+    //
+    // Parses a line into the board, returns 0 for an empty line or a comment,
+    // 1 for a puzzle, -1 if the line is not a puzzle (it is still reported).
+    //
+    static int parse_line(const char * line, size_t length, Board & board) {
+        size_t i = 0;
+        while (i < length && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+            i++;
+        if (i >= length)
+            return 0;
+        if (line[i] == '#' || (line[i] == '/' && (i + 1) < length && line[i + 1] == '/'))
+            return 0;
+
+        size_t pos = 0;
+        for (; i < length; i++) {
+            char val = line[i];
+            if (val >= '1' && val <= '9') {
+                if (pos >= BoardSize)
+                    return -1;
+                board.cells[pos++] = val;
+            }
+            else if (val == '0' || val == '.' || val == '-') {
+                if (pos >= BoardSize)
+                    return -1;
+                board.cells[pos++] = '.';
+            }
+            else if (val != ' ' && val != '\t' && val != '\r') {
+                return -1;
+            }
+        }
+        return (pos == BoardSize) ? 1 : -1;
+    }
+
+    static void solve_batch(solver_type & solver, Batch & batch) {
+        for (size_t i = 0; i < StatusLast; i++) {
+            batch.status[i] = 0;
+        }
+        batch.output.clear();
+
+        for (size_t i = 0; i < batch.size; i++) {
+            Board & board = batch.boards[i];
+            size_t status;
+            // An unparsed line is marked by a '\0' in the first cell.
+            if (board.cells[0] == '\0' || check_board(board) != BoardCheck::BoardValid) {
+                status = (board.cells[0] == '\0') ? Status::Invalid : Status::NoSolution;
+            }
+            else {
+                size_t answers = solver.template search<SearchMode::MoreThanOneAnswer>(board);
+                if (answers == 1)
+                    status = Status::Solved;
+                else if (answers == 0)
+                    status = Status::NoSolution;
+                else
+                    status = Status::Multiple;
+            }
+            batch.status[status]++;
+
+            if (status == Status::Solved) {
+                const Board & answer = solver.answers()[0];
+                batch.output.insert(batch.output.end(), &answer.cells[0], &answer.cells[BoardSize]);
+                batch.output.push_back('\n');
+            }
+            else {
+                const char * text = status_name(status);
+                batch.output.insert(batch.output.end(), text, text + std::strlen(text));
+                batch.output.push_back('\n');
+            }
+        }
+    }
+
+    void add_stats(const Batch & batch) {
+        this->stats_.puzzles += batch.size;
+        for (size_t i = 0; i < StatusLast; i++) {
+            this->stats_.status[i] += batch.status[i];
+        }
+    }
+
+    static bool write_batch(FILE * out, const Batch & batch) {
+        if (!batch.output.empty()) {
+            if (std::fwrite(&batch.output[0], 1, batch.output.size(), out) != batch.output.size())
+                return false;
+        }
+        if (batch.flush)
+            return (std::fflush(out) == 0);
+        return true;
+    }
+
+    // Returns the bytes read, 0 at the end of the input, -1 on an error.
+    static ptrdiff_t read_input(FILE * in, char * data, size_t size) {
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+        return (ptrdiff_t)::_read(::_fileno(in), data, (unsigned int)size);
+#else
+        for (;;) {
+            ssize_t bytes = ::read(::fileno(in), data, size);
+            if (bytes >= 0 || errno != EINTR)
+                return (ptrdiff_t)bytes;
+        }
+#endif
+    }
+
+    Batch * get_free_batch() {
+        std::unique_lock<std::mutex> lock(this->mutex_);
+        while (this->free_list_.empty()) {
+            this->free_cond_.wait(lock);
+        }
+        Batch * batch = this->free_list_.back();
+        this->free_list_.pop_back();
+        batch->size = 0;
+        batch->flush = false;
+        return batch;
+    }
+
+    //
+    // Inline: solves and writes, returns false if the write failed.
+    // Threads: hands the batch to the workers, returns false if the writer
+    // has failed already.
+    //
+    bool submit_batch(Batch * batch, FILE * out, solver_type & solver) {
+        if (this->threads_ == 0) {
+            batch->sequence = this->total_batches_++;
+            solve_batch(solver, *batch);
+            this->add_stats(*batch);
+            bool success = write_batch(out, *batch);
+            this->free_list_.push_back(batch);
+            return success;
+        }
+        else {
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                if (this->write_failed_) {
+                    this->free_list_.push_back(batch);
+                    return false;
+                }
+                batch->sequence = this->total_batches_++;
+                this->work_queue_.push_back(batch);
+            }
+            this->work_cond_.notify_one();
+            return true;
+        }
+    }
+
+    bool reader(FILE * in, FILE * out, solver_type & solver) {
+        std::vector<char> buffer(kReadBufSize + kMaxLineLength);
+        size_t carry = 0;
+        bool success = true;
+
+        Batch * batch = this->get_free_batch();
+        for (;;) {
+            ptrdiff_t bytes = read_input(in, &buffer[carry], kReadBufSize);
+            if (bytes < 0) {
+                success = false;
+                bytes = 0;
+            }
+            size_t length = carry + (size_t)bytes;
+            bool is_eof = (bytes == 0);
+
+            const char * data = &buffer[0];
+            size_t line_start = 0;
+            for (;;) {
+                const char * newline = (const char *)std::memchr(data + line_start, '\n', length - line_start);
+                size_t line_end;
+                if (newline != nullptr) {
+                    line_end = (size_t)(newline - data);
+                }
+                else if (is_eof && line_start < length) {
+                    line_end = length;
+                }
+                else {
+                    break;
+                }
+
+                Board & board = batch->boards[batch->size];
+                int result = parse_line(data + line_start, line_end - line_start, board);
+                if (result != 0) {
+                    if (result < 0)
+                        board.cells[0] = '\0';
+                    batch->size++;
+                    if (batch->size >= this->batch_size_) {
+                        if (!this->submit_batch(batch, out, solver))
+                            return false;
+                        batch = this->get_free_batch();
+                    }
+                }
+                line_start = line_end + 1;
+                if (line_start >= length)
+                    break;
+            }
+
+            if (is_eof)
+                break;
+
+            if ((size_t)bytes < kReadBufSize && batch->size != 0) {
+                batch->flush = true;
+                if (!this->submit_batch(batch, out, solver))
+                    return false;
+                batch = this->get_free_batch();
+            }
+
+            // Keep the incomplete line, a too long line is cut.
+            carry = (line_start < length) ? (length - line_start) : 0;
+            if (carry > kMaxLineLength)
+                carry = kMaxLineLength;
+            if (carry != 0)
+                std::memmove(&buffer[0], &buffer[length - carry], carry);
+        }
+
+        if (batch->size != 0) {
+            if (!this->submit_batch(batch, out, solver))
+                return false;
+        }
+        else {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->free_list_.push_back(batch);
+        }
+        return success;
+    }
+
+    void worker_thread() {
+        solver_type solver;
+        for (;;) {
+            Batch * batch;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                while (this->work_queue_.empty() && !this->input_end_) {
+                    this->work_cond_.wait(lock);
+                }
+                if (this->work_queue_.empty())
+                    break;
+                batch = this->work_queue_.front();
+                this->work_queue_.pop_front();
+            }
+
+            solve_batch(solver, *batch);
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                this->done_map_.insert(std::make_pair(batch->sequence, batch));
+            }
+            this->done_cond_.notify_one();
+        }
+    }
+
+    bool writer_thread(FILE * out) {
+        bool success = true;
+        size_t next_sequence = 0;
+        for (;;) {
+            Batch * batch;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                for (;;) {
+                    if (!this->done_map_.empty() && this->done_map_.begin()->first == next_sequence)
+                        break;
+                    if (this->input_end_ && next_sequence >= this->total_batches_)
+                        break;
+                    this->done_cond_.wait(lock);
+                }
+                if (this->done_map_.empty() || this->done_map_.begin()->first != next_sequence)
+                    break;
+                batch = this->done_map_.begin()->second;
+                this->done_map_.erase(this->done_map_.begin());
+            }
+
+            this->add_stats(*batch);
+            if (success)
+                success = write_batch(out, *batch);
+            next_sequence++;
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex_);
+                if (!success)
+                    this->write_failed_ = true;
+                this->free_list_.push_back(batch);
+            }
+            this->free_cond_.notify_one();
+        }
+        return success;
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_STREAM_H
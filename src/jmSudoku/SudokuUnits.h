@@ -0,0 +1,380 @@
+
+#ifndef JM_SUDOKU_UNITS_H
+#define JM_SUDOKU_UNITS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "Sudoku.h"
+#include "SudokuVerify.h"
+#include "BitUtils.h"
+#include "BitSet.h"
+
+//
+// The constraint description of the sudoku variants: a list of units, a
+// unit is a set of Numbers cells that holds every number once. The classic
+// sudoku is its rows, columns and boxes, Sudoku-X adds the two diagonals,
+// Windoku adds the four windows, and a jigsaw sudoku replaces the boxes by
+// irregular regions.
+//
+// compile() turns the list into the masks of the variant engines, once:
+// the units of every cell, the cell mask of every unit and the peers of
+// every cell (the cells that share a unit with it).
+//
+namespace jmSudoku {
+
+template <typename SudokuTy = Sudoku>
+class Units {
+public:
+    typedef SudokuTy                            sudoku_t;
+    typedef typename SudokuTy::board_type       Board;
+
+    static const size_t BoxCellsX = SudokuTy::BoxCellsX;      // 3
+    static const size_t BoxCellsY = SudokuTy::BoxCellsY;      // 3
+    static const size_t BoxCountX = SudokuTy::BoxCountX;      // 3
+    static const size_t BoxCountY = SudokuTy::BoxCountY;      // 3
+
+    static const size_t Rows = SudokuTy::Rows;
+    static const size_t Cols = SudokuTy::Cols;
+    static const size_t Boxes = SudokuTy::Boxes;
+    static const size_t Numbers = SudokuTy::Numbers;
+    static const size_t BoardSize = SudokuTy::BoardSize;
+
+    // The classic units and one more family as large as the boxes.
+    static const size_t MaxUnits = Rows + Cols + Boxes + Boxes;
+    // The center cell of Sudoku-X with the windows is in 6 units.
+    static const size_t MaxUnitsPerCell = 6;
+
+    static const uint8_t kNoRegion = 0xFF;
+
+    typedef WordBitSet<BoardSize> cell_mask_t;
+
+private:
+    size_t      unit_count_;
+    uint8_t     unit_cells_[MaxUnits][Numbers];
+    uint8_t     unit_kinds_[MaxUnits];              // The BoardCheck of a conflict
+    cell_mask_t unit_masks_[MaxUnits];
+
+    uint8_t     cell_unit_count_[BoardSize];
+    uint8_t     cell_units_[BoardSize][MaxUnitsPerCell];
+    cell_mask_t peers_[BoardSize];
+
+    const char * name_;
+    bool        is_valid_;
+    bool        is_compiled_;
+
+public:
+    Units(const char * name = "") : unit_count_(0), name_(name), is_valid_(true), is_compiled_(false) {
+        std::memset((void *)&this->cell_unit_count_[0], 0, sizeof(this->cell_unit_count_));
+    }
+    ~Units() {}
+
+    const char * name() const { return this->name_; }
+
+    size_t unit_count() const { return this->unit_count_; }
+
+    // False if a unit was rejected by add_unit().
+    bool is_valid() const { return this->is_valid_; }
+    bool is_compiled() const { return this->is_compiled_; }
+
+    const uint8_t * unit_cells(size_t unit) const {
+        assert(unit < this->unit_count_);
+        return &this->unit_cells_[unit][0];
+    }
+
+    const cell_mask_t & unit_mask(size_t unit) const {
+        assert(this->is_compiled_);
+        return this->unit_masks_[unit];
+    }
+
+    size_t cell_unit_count(size_t pos) const {
+        return this->cell_unit_count_[pos];
+    }
+
+    const uint8_t * cell_units(size_t pos) const {
+        return &this->cell_units_[pos][0];
+    }
+
+    const cell_mask_t & peers(size_t pos) const {
+        assert(this->is_compiled_);
+        return this->peers_[pos];
+    }
+
+    //
+    // Adds a unit of Numbers cells. A unit with a cell out of the board, a
+    // cell twice, or a cell that is already in MaxUnitsPerCell units is
+    // rejected, and makes the description invalid.
+    //
+    bool add_unit(const uint8_t * cells, BoardCheck kind = BoardCheck::BoxConflict) {
+        bool is_valid = (this->unit_count_ < MaxUnits);
+        cell_mask_t mask;
+        mask.reset();
+        for (size_t i = 0; i < Numbers && is_valid; i++) {
+            size_t pos = cells[i];
+            is_valid = (pos < BoardSize && !mask.test(pos) &&
+                        this->cell_unit_count_[pos] < MaxUnitsPerCell);
+            if (is_valid)
+                mask.set(pos);
+        }
+        if (!is_valid) {
+            this->is_valid_ = false;
+            return false;
+        }
+
+        size_t unit = this->unit_count_++;
+        for (size_t i = 0; i < Numbers; i++) {
+            size_t pos = cells[i];
+            this->unit_cells_[unit][i] = (uint8_t)pos;
+            this->cell_units_[pos][this->cell_unit_count_[pos]++] = (uint8_t)unit;
+        }
+        this->unit_kinds_[unit] = (uint8_t)kind;
+        this->is_compiled_ = false;
+        return true;
+    }
+
+    void add_rows() {
+        uint8_t cells[Numbers];
+        for (size_t row = 0; row < Rows; row++) {
+            for (size_t col = 0; col < Cols; col++) {
+                cells[col] = (uint8_t)(row * Cols + col);
+            }
+            this->add_unit(cells, BoardCheck::RowConflict);
+        }
+    }
+
+    void add_cols() {
+        uint8_t cells[Numbers];
+        for (size_t col = 0; col < Cols; col++) {
+            for (size_t row = 0; row < Rows; row++) {
+                cells[row] = (uint8_t)(row * Cols + col);
+            }
+            this->add_unit(cells, BoardCheck::ColConflict);
+        }
+    }
+
+    void add_boxes() {
+        this->add_windows(0, 0, BoxCellsY, BoxCellsX);
+    }
+
+    // The main diagonal and the anti-diagonal, a square board only.
+    void add_diagonals() {
+        uint8_t diagonal[Numbers], anti_diagonal[Numbers];
+        for (size_t i = 0; i < Rows; i++) {
+            diagonal[i] = (uint8_t)(i * Cols + i);
+            anti_diagonal[i] = (uint8_t)(i * Cols + (Cols - 1 - i));
+        }
+        this->add_unit(diagonal);
+        this->add_unit(anti_diagonal);
+    }
+
+    //
+    // The box shaped windows from (first_row, first_col), step_y and step_x
+    // apart. The boxes are the windows from (0, 0) with no gap, the windows
+    // of Windoku start from (1, 1) with a gap of one cell.
+    //
+    void add_windows(size_t first_row, size_t first_col, size_t step_y, size_t step_x) {
+        uint8_t cells[Numbers];
+        for (size_t top = first_row; top + BoxCellsY <= Rows; top += step_y) {
+            for (size_t left = first_col; left + BoxCellsX <= Cols; left += step_x) {
+                size_t cell = 0;
+                for (size_t y = 0; y < BoxCellsY; y++) {
+                    for (size_t x = 0; x < BoxCellsX; x++) {
+                        cells[cell++] = (uint8_t)((top + y) * Cols + (left + x));
+                    }
+                }
+                this->add_unit(cells);
+            }
+        }
+    }
+
+    //
+    // The regions of a jigsaw sudoku, regions[pos] is the region of the cell:
+    // '1' - '9', 'A' - 'Z' after them, or '0' - '8'. Every region must have
+    // Numbers cells.
+    //
+    bool add_regions(const char * regions) {
+        size_t region_cells[Boxes];
+        uint8_t cells[Boxes][Numbers];
+        std::memset((void *)&region_cells[0], 0, sizeof(region_cells));
+
+        // Only a layout that uses '0' starts from '0'.
+        bool from_zero = false;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (regions[pos] == '\0') {
+                this->is_valid_ = false;
+                return false;
+            }
+            from_zero |= (regions[pos] == '0');
+        }
+
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            char ch = regions[pos];
+            size_t region;
+            if (ch >= '0' && ch <= '9')
+                region = (size_t)(ch - '0') - (from_zero ? 0 : 1);
+            else if (ch >= 'A' && ch <= 'Z')
+                region = (size_t)(ch - 'A') + 10 - (from_zero ? 0 : 1);
+            else
+                region = kNoRegion;
+            if (region >= Boxes || region_cells[region] >= Numbers) {
+                this->is_valid_ = false;
+                return false;
+            }
+            cells[region][region_cells[region]++] = (uint8_t)pos;
+        }
+
+        for (size_t region = 0; region < Boxes; region++) {
+            if (region_cells[region] != Numbers || !this->add_unit(cells[region])) {
+                this->is_valid_ = false;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // Builds the unit masks and the peers from the list of the units.
+    // Returns false if the description is invalid or a cell is in no unit.
+    //
+    bool compile() {
+        for (size_t unit = 0; unit < this->unit_count_; unit++) {
+            this->unit_masks_[unit].reset();
+            for (size_t i = 0; i < Numbers; i++) {
+                this->unit_masks_[unit].set(this->unit_cells_[unit][i]);
+            }
+        }
+
+        bool all_cells_in_units = true;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            cell_mask_t & peers = this->peers_[pos];
+            peers.reset();
+            for (size_t i = 0; i < this->cell_unit_count_[pos]; i++) {
+                const cell_mask_t & unit_mask = this->unit_masks_[this->cell_units_[pos][i]];
+                for (size_t w = 0; w < cell_mask_t::kWords; w++) {
+                    peers.words[w] |= unit_mask.words[w];
+                }
+            }
+            peers.reset(pos);
+            all_cells_in_units &= (this->cell_unit_count_[pos] != 0);
+        }
+
+        this->is_compiled_ = this->is_valid_ && all_cells_in_units;
+        return this->is_compiled_;
+    }
+
+    //
+    // The input check of the variant engines, in the order of BoardCheck.
+    // A conflict in a unit is reported by the kind given to add_unit(): the
+    // rows and the columns by their own, the other units as BoxConflict.
+    //
+    BoardCheck check_board(const Board & board) const {
+        assert(this->is_compiled_);
+        uint32_t unit_nums[MaxUnits];
+        std::memset((void *)&unit_nums[0], 0, sizeof(unit_nums));
+
+        size_t conflict = BoardCheck::BoardCheckLast;
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            char val = board.cells[pos];
+            if (val == '.')
+                continue;
+            if (val < '1' || val > (char)('0' + Numbers))
+                return BoardCheck::InvalidChar;
+            uint32_t num_bit = 1U << (val - '1');
+            for (size_t i = 0; i < this->cell_unit_count_[pos]; i++) {
+                size_t unit = this->cell_units_[pos][i];
+                if ((unit_nums[unit] & num_bit) != 0 && this->unit_kinds_[unit] < conflict)
+                    conflict = this->unit_kinds_[unit];
+                unit_nums[unit] |= num_bit;
+            }
+        }
+        if (conflict != BoardCheck::BoardCheckLast)
+            return (BoardCheck)conflict;
+
+        const uint32_t kAllNumbers = (uint32_t)((size_t(1) << Numbers) - 1);
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            if (board.cells[pos] == '.') {
+                uint32_t num_bits = 0;
+                for (size_t i = 0; i < this->cell_unit_count_[pos]; i++) {
+                    num_bits |= unit_nums[this->cell_units_[pos][i]];
+                }
+                if (num_bits == kAllNumbers)
+                    return BoardCheck::NoCandidate;
+            }
+        }
+        return BoardCheck::BoardValid;
+    }
+
+    // The answer keeps the givens, and every unit holds every number once.
+    bool verify_solution(const Board & puzzle, const Board & answer) const {
+        const uint32_t kAllNumbers = (uint32_t)((size_t(1) << Numbers) - 1);
+        for (size_t pos = 0; pos < BoardSize; pos++) {
+            char val = answer.cells[pos];
+            if (val < '1' || val > (char)('0' + Numbers))
+                return false;
+            if (puzzle.cells[pos] != '.' && puzzle.cells[pos] != val)
+                return false;
+        }
+        for (size_t unit = 0; unit < this->unit_count_; unit++) {
+            uint32_t num_bits = 0;
+            for (size_t i = 0; i < Numbers; i++) {
+                num_bits |= 1U << (answer.cells[this->unit_cells_[unit][i]] - '1');
+            }
+            if (num_bits != kAllNumbers)
+                return false;
+        }
+        return true;
+    }
+
+    static Units classic() {
+        Units units("classic");
+        units.add_rows();
+        units.add_cols();
+        units.add_boxes();
+        units.compile();
+        return units;
+    }
+
+    static Units sudoku_x() {
+        Units units("Sudoku-X");
+        units.add_rows();
+        units.add_cols();
+        units.add_boxes();
+        units.add_diagonals();
+        units.compile();
+        return units;
+    }
+
+    static Units windoku() {
+        Units units("Windoku");
+        units.add_rows();
+        units.add_cols();
+        units.add_boxes();
+        units.add_windows(1, 1, BoxCellsY + 1, BoxCellsX + 1);
+        units.compile();
+        return units;
+    }
+
+    // See add_regions(), is_compiled() is false for a bad layout.
+    static Units jigsaw(const char * regions) {
+        Units units("jigsaw");
+        units.add_rows();
+        units.add_cols();
+        units.add_regions(regions);
+        units.compile();
+        return units;
+    }
+};
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_UNITS_H
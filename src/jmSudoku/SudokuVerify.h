@@ -0,0 +1,360 @@
+
+#ifndef JM_SUDOKU_VERIFY_H
+#define JM_SUDOKU_VERIFY_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <emmintrin.h>      // For SSE 2
+#include <tmmintrin.h>      // For SSSE 3
+#else
+#include <x86intrin.h>      // For SSSE 3
+#endif // _MSC_VER
+
+#include "Sudoku.h"
+
+//
+// Verification of the answers of the 9x9 sudoku.
+//
+// An answer is correct if it keeps the givens of the puzzle, and every row,
+// column and box is a permutation of 1 - 9.
+//
+// The SIMD version maps every cell to a one-hot 16 bit mask by two pshufb
+// (the low and the high byte of 1 << (val - '1'), a char that is not a number
+// gets no bit). Since every cell has at most one bit, a unit is a permutation
+// exactly when the OR of its 9 masks is 0x1FF:
+//   - columns: the OR of the 9 rows, 8 columns in one vector,
+//   - boxes: the OR of the 3 rows of a band, then of 3 neighbor lanes,
+//   - rows: a horizontal OR of the 8 first lanes of the row.
+//
+// The check of an input board uses the same masks of the givens, a unit
+// has a duplicate number exactly when the sum of its masks is not the OR of
+// them (two equal bits carry). An empty cell has no candidate when the OR
+// of its row, column and box is 0x1FF.
+//
+namespace jmSudoku {
+
+enum BoardCheck {
+    BoardValid,
+    InvalidChar,            // Not '1' - '9' or '.'
+    RowConflict,            // A number appears twice in a row
+    ColConflict,
+    BoxConflict,
+    NoCandidate,            // An empty cell that no number fits
+    BoardCheckLast
+};
+
+inline const char * board_check_name(size_t check)
+{
+    static const char * names[BoardCheckLast] = {
+        "valid", "invalid char", "row conflict", "column conflict", "box conflict", "no candidate"
+    };
+    return (check < BoardCheckLast) ? names[check] : "unknown";
+}
+
+//
+// The reasons are checked in the order of BoardCheck, so the scalar and the
+// SIMD version return the same reason for a board with several faults.
+//
+inline BoardCheck check_board_scalar(const Sudoku::board_type & board)
+{
+    uint32_t rows[Sudoku::Rows] = { 0 };
+    uint32_t cols[Sudoku::Cols] = { 0 };
+    uint32_t boxes[Sudoku::Boxes] = { 0 };
+    bool row_conflict = false, col_conflict = false, box_conflict = false;
+
+    for (size_t pos = 0; pos < Sudoku::BoardSize; pos++) {
+        char val = board.cells[pos];
+        if (val == '.')
+            continue;
+        if (val < '1' || val > '9')
+            return BoardCheck::InvalidChar;
+        uint32_t num_bit = 1U << (val - '1');
+        const Sudoku::CellInfo & cellInfo = Sudoku::cell_info[pos];
+        row_conflict |= ((rows[cellInfo.row] & num_bit) != 0);
+        col_conflict |= ((cols[cellInfo.col] & num_bit) != 0);
+        box_conflict |= ((boxes[cellInfo.box] & num_bit) != 0);
+        rows[cellInfo.row] |= num_bit;
+        cols[cellInfo.col] |= num_bit;
+        boxes[cellInfo.box] |= num_bit;
+    }
+    if (row_conflict)
+        return BoardCheck::RowConflict;
+    if (col_conflict)
+        return BoardCheck::ColConflict;
+    if (box_conflict)
+        return BoardCheck::BoxConflict;
+
+    for (size_t pos = 0; pos < Sudoku::BoardSize; pos++) {
+        if (board.cells[pos] == '.') {
+            const Sudoku::CellInfo & cellInfo = Sudoku::cell_info[pos];
+            if ((rows[cellInfo.row] | cols[cellInfo.col] | boxes[cellInfo.box]) == 0x01FFu)
+                return BoardCheck::NoCandidate;
+        }
+    }
+    return BoardCheck::BoardValid;
+}
+
+inline bool verify_solution_scalar(const Sudoku::board_type & puzzle, const Sudoku::board_type & answer)
+{
+    uint32_t rows[Sudoku::Rows] = { 0 };
+    uint32_t cols[Sudoku::Cols] = { 0 };
+    uint32_t boxes[Sudoku::Boxes] = { 0 };
+
+    for (size_t pos = 0; pos < Sudoku::BoardSize; pos++) {
+        char val = answer.cells[pos];
+        if (val < '1' || val > '9')
+            return false;
+        if (puzzle.cells[pos] != '.' && puzzle.cells[pos] != val)
+            return false;
+        uint32_t num_bit = 1U << (val - '1');
+        const Sudoku::CellInfo & cellInfo = Sudoku::cell_info[pos];
+        if (((rows[cellInfo.row] | cols[cellInfo.col] | boxes[cellInfo.box]) & num_bit) != 0)
+            return false;
+        rows[cellInfo.row] |= num_bit;
+        cols[cellInfo.col] |= num_bit;
+        boxes[cellInfo.box] |= num_bit;
+    }
+    return true;
+}
+
+#if defined(__SSSE3__)
+
+inline bool verify_solution(const Sudoku::board_type & puzzle, const Sudoku::board_type & answer)
+{
+    static const size_t Cols = Sudoku::Cols;
+    static const uint32_t kAllBits = 0x01FFu;
+
+    alignas(16) uint16_t masks[Sudoku::BoardSize + 7];
+
+    const __m128i one_char  = _mm_set1_epi8('1');
+    const __m128i dot_char  = _mm_set1_epi8('.');
+    const __m128i max_index = _mm_set1_epi8(15);
+    const __m128i lo_table  = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i hi_table  = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0);
+
+    // 81 cells: 5 vectors and the last one overlapped at 65.
+    __m128i givens_kept = _mm_set1_epi8((char)0xFF);
+    for (size_t i = 0; i < 6; i++) {
+        size_t offset = (i < 5) ? (i * 16) : (Sudoku::BoardSize - 16);
+        __m128i cells = _mm_loadu_si128((const __m128i *)(answer.cells + offset));
+        __m128i givens = _mm_loadu_si128((const __m128i *)(puzzle.cells + offset));
+        givens_kept = _mm_and_si128(givens_kept, _mm_or_si128(_mm_cmpeq_epi8(givens, cells),
+                                                              _mm_cmpeq_epi8(givens, dot_char)));
+
+        // A char out of '1' - '9' gets an index of 9 - 15, so no bit.
+        __m128i index = _mm_min_epu8(_mm_sub_epi8(cells, one_char), max_index);
+        __m128i lo = _mm_shuffle_epi8(lo_table, index);
+        __m128i hi = _mm_shuffle_epi8(hi_table, index);
+        _mm_storeu_si128((__m128i *)(masks + offset), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128((__m128i *)(masks + offset + 8), _mm_unpackhi_epi8(lo, hi));
+    }
+    if (_mm_movemask_epi8(givens_kept) != 0xFFFF)
+        return false;
+
+    uint32_t all_units = kAllBits;
+    __m128i cols = _mm_setzero_si128();
+    uint32_t col8 = 0;
+    for (size_t band = 0; band < 3; band++) {
+        const uint16_t * row0 = masks + band * 3 * Cols;
+        __m128i r0 = _mm_loadu_si128((const __m128i *)(row0));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)(row0 + Cols));
+        __m128i r2 = _mm_loadu_si128((const __m128i *)(row0 + Cols * 2));
+        uint32_t band8 = (uint32_t)row0[8] | row0[Cols + 8] | row0[Cols * 2 + 8];
+
+        // Rows
+        __m128i h0 = _mm_or_si128(r0, _mm_srli_si128(r0, 8));
+        __m128i h1 = _mm_or_si128(r1, _mm_srli_si128(r1, 8));
+        __m128i h2 = _mm_or_si128(r2, _mm_srli_si128(r2, 8));
+        h0 = _mm_or_si128(h0, _mm_srli_si128(h0, 4));
+        h1 = _mm_or_si128(h1, _mm_srli_si128(h1, 4));
+        h2 = _mm_or_si128(h2, _mm_srli_si128(h2, 4));
+        h0 = _mm_or_si128(h0, _mm_srli_si128(h0, 2));
+        h1 = _mm_or_si128(h1, _mm_srli_si128(h1, 2));
+        h2 = _mm_or_si128(h2, _mm_srli_si128(h2, 2));
+        all_units &= ((uint32_t)_mm_extract_epi16(h0, 0) | row0[8]);
+        all_units &= ((uint32_t)_mm_extract_epi16(h1, 0) | row0[Cols + 8]);
+        all_units &= ((uint32_t)_mm_extract_epi16(h2, 0) | row0[Cols * 2 + 8]);
+
+        // Boxes: lanes 0, 3 and 6 (+ column 8) of the OR of 3 neighbor lanes.
+        __m128i v = _mm_or_si128(_mm_or_si128(r0, r1), r2);
+        __m128i b = _mm_or_si128(_mm_or_si128(v, _mm_srli_si128(v, 2)), _mm_srli_si128(v, 4));
+        all_units &= (uint32_t)_mm_extract_epi16(b, 0);
+        all_units &= (uint32_t)_mm_extract_epi16(b, 3);
+        all_units &= ((uint32_t)_mm_extract_epi16(b, 6) | band8);
+
+        // Columns
+        cols = _mm_or_si128(cols, v);
+        col8 |= band8;
+    }
+    all_units &= col8;
+
+    __m128i cols_full = _mm_cmpeq_epi16(cols, _mm_set1_epi16((short)kAllBits));
+    return ((all_units == kAllBits) && (_mm_movemask_epi8(cols_full) == 0xFFFF));
+}
+
+inline BoardCheck check_board(const Sudoku::board_type & board)
+{
+    static const size_t Cols = Sudoku::Cols;
+    static const uint32_t kAllBits = 0x01FFu;
+
+    alignas(16) uint16_t masks[Sudoku::BoardSize + 7];
+
+    const __m128i one_char  = _mm_set1_epi8('1');
+    const __m128i dot_char  = _mm_set1_epi8('.');
+    const __m128i max_num   = _mm_set1_epi8(8);
+    const __m128i max_index = _mm_set1_epi8(15);
+    const __m128i lo_table  = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i hi_table  = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0);
+
+    __m128i chars_ok = _mm_set1_epi8((char)0xFF);
+    for (size_t i = 0; i < 6; i++) {
+        size_t offset = (i < 5) ? (i * 16) : (Sudoku::BoardSize - 16);
+        __m128i cells = _mm_loadu_si128((const __m128i *)(board.cells + offset));
+        __m128i index = _mm_sub_epi8(cells, one_char);
+        __m128i is_num = _mm_cmpeq_epi8(_mm_min_epu8(index, max_num), index);
+        chars_ok = _mm_and_si128(chars_ok, _mm_or_si128(is_num, _mm_cmpeq_epi8(cells, dot_char)));
+
+        index = _mm_min_epu8(index, max_index);
+        __m128i lo = _mm_shuffle_epi8(lo_table, index);
+        __m128i hi = _mm_shuffle_epi8(hi_table, index);
+        _mm_storeu_si128((__m128i *)(masks + offset), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128((__m128i *)(masks + offset + 8), _mm_unpackhi_epi8(lo, hi));
+    }
+    if (_mm_movemask_epi8(chars_ok) != 0xFFFF)
+        return BoardCheck::InvalidChar;
+
+    // Broadcasts lane 0 and 3 (the boxes) to the lanes of their columns.
+    const __m128i box_lanes = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 6, 7, 6, 7, 6, 7, 12, 13, 12, 13);
+
+    __m128i rows[Sudoku::Rows];
+    uint32_t row_or[Sudoku::Rows];
+    __m128i box_or[3];
+    uint32_t box8_or[3];
+    uint32_t row_diff = 0, box_diff = 0;
+    __m128i cols_or = _mm_setzero_si128();
+    __m128i cols_sum = _mm_setzero_si128();
+    uint32_t col8_or = 0, col8_sum = 0;
+
+    for (size_t band = 0; band < 3; band++) {
+        const uint16_t * row0 = masks + band * 3 * Cols;
+        __m128i * r = &rows[band * 3];
+        r[0] = _mm_loadu_si128((const __m128i *)(row0));
+        r[1] = _mm_loadu_si128((const __m128i *)(row0 + Cols));
+        r[2] = _mm_loadu_si128((const __m128i *)(row0 + Cols * 2));
+
+        // Rows
+        for (size_t n = 0; n < 3; n++) {
+            __m128i h_or = _mm_or_si128(r[n], _mm_srli_si128(r[n], 8));
+            __m128i h_sum = _mm_add_epi16(r[n], _mm_srli_si128(r[n], 8));
+            h_or = _mm_or_si128(h_or, _mm_srli_si128(h_or, 4));
+            h_sum = _mm_add_epi16(h_sum, _mm_srli_si128(h_sum, 4));
+            h_or = _mm_or_si128(h_or, _mm_srli_si128(h_or, 2));
+            h_sum = _mm_add_epi16(h_sum, _mm_srli_si128(h_sum, 2));
+            uint32_t cell8 = row0[Cols * n + 8];
+            uint32_t or_bits = (uint32_t)_mm_extract_epi16(h_or, 0) | cell8;
+            uint32_t sum_bits = (uint32_t)_mm_extract_epi16(h_sum, 0) + cell8;
+            row_diff |= or_bits ^ sum_bits;
+            row_or[band * 3 + n] = or_bits;
+        }
+
+        // Boxes: lanes 0, 3 and 6 (+ column 8) of 3 neighbor lanes.
+        __m128i v_or = _mm_or_si128(_mm_or_si128(r[0], r[1]), r[2]);
+        __m128i v_sum = _mm_add_epi16(_mm_add_epi16(r[0], r[1]), r[2]);
+        uint32_t band8_or = (uint32_t)row0[8] | row0[Cols + 8] | row0[Cols * 2 + 8];
+        uint32_t band8_sum = (uint32_t)row0[8] + row0[Cols + 8] + row0[Cols * 2 + 8];
+        __m128i b_or = _mm_or_si128(_mm_or_si128(v_or, _mm_srli_si128(v_or, 2)), _mm_srli_si128(v_or, 4));
+        __m128i b_sum = _mm_add_epi16(_mm_add_epi16(v_sum, _mm_srli_si128(v_sum, 2)), _mm_srli_si128(v_sum, 4));
+        __m128i b_diff = _mm_xor_si128(b_or, b_sum);
+        box_diff |= (uint32_t)_mm_extract_epi16(b_diff, 0) | (uint32_t)_mm_extract_epi16(b_diff, 3);
+        uint32_t box2_or = (uint32_t)_mm_extract_epi16(b_or, 6) | band8_or;
+        box_diff |= box2_or ^ ((uint32_t)_mm_extract_epi16(b_sum, 6) + band8_sum);
+        __m128i box_bits = _mm_shuffle_epi8(b_or, box_lanes);
+        box_bits = _mm_insert_epi16(box_bits, (int)box2_or, 6);
+        box_bits = _mm_insert_epi16(box_bits, (int)box2_or, 7);
+        box_or[band] = box_bits;
+        box8_or[band] = box2_or;
+
+        // Columns
+        cols_or = _mm_or_si128(cols_or, v_or);
+        cols_sum = _mm_add_epi16(cols_sum, v_sum);
+        col8_or |= band8_or;
+        col8_sum += band8_sum;
+    }
+
+    if (row_diff != 0)
+        return BoardCheck::RowConflict;
+    __m128i cols_same = _mm_cmpeq_epi16(cols_or, cols_sum);
+    if (_mm_movemask_epi8(cols_same) != 0xFFFF || col8_or != col8_sum)
+        return BoardCheck::ColConflict;
+    if (box_diff != 0)
+        return BoardCheck::BoxConflict;
+
+    const __m128i all_bits = _mm_set1_epi16((short)kAllBits);
+    const __m128i zeros = _mm_setzero_si128();
+    __m128i no_cand = _mm_setzero_si128();
+    uint32_t no_cand8 = 0;
+    for (size_t row = 0; row < Sudoku::Rows; row++) {
+        size_t band = row / 3;
+        __m128i cells = rows[row];
+        __m128i used = _mm_or_si128(_mm_or_si128(cols_or, box_or[band]), _mm_set1_epi16((short)row_or[row]));
+        no_cand = _mm_or_si128(no_cand, _mm_and_si128(_mm_cmpeq_epi16(cells, zeros),
+                                                      _mm_cmpeq_epi16(used, all_bits)));
+        uint32_t used8 = col8_or | box8_or[band] | row_or[row];
+        no_cand8 |= (uint32_t)(masks[row * Cols + 8] == 0 && used8 == kAllBits);
+    }
+    if (_mm_movemask_epi8(no_cand) != 0 || no_cand8 != 0)
+        return BoardCheck::NoCandidate;
+
+    return BoardCheck::BoardValid;
+}
+
+#else
+
+inline bool verify_solution(const Sudoku::board_type & puzzle, const Sudoku::board_type & answer)
+{
+    return verify_solution_scalar(puzzle, answer);
+}
+
+inline BoardCheck check_board(const Sudoku::board_type & board)
+{
+    return check_board_scalar(board);
+}
+
+#endif // __SSSE3__
+
+//
+// Verifies answers[i] against puzzles[i], results[i] (may be null) gets 1 if
+// the answer is correct. Returns the number of the correct answers.
+//
+inline size_t verify_solutions(const Sudoku::board_type * puzzles, const Sudoku::board_type * answers,
+                               size_t count, uint8_t * results = nullptr)
+{
+    size_t correct = 0;
+    if (results != nullptr) {
+        for (size_t i = 0; i < count; i++) {
+            bool is_correct = verify_solution(puzzles[i], answers[i]);
+            results[i] = is_correct ? 1 : 0;
+            correct += is_correct ? 1 : 0;
+        }
+    }
+    else {
+        for (size_t i = 0; i < count; i++) {
+            correct += verify_solution(puzzles[i], answers[i]) ? 1 : 0;
+        }
+    }
+    return correct;
+}
+
+} // namespace jmSudoku
+
+#endif // JM_SUDOKU_VERIFY_H